@@ -0,0 +1,96 @@
+// Compares the 2D spectral convolution engine against the previous
+// row-by-row 1D FFT path across image sizes.
+//
+// Usage: bench_conv2d [kernel_size] [repeats] [size...]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "src/convolution.h"
+#include "src/fft_convolution.h"
+
+// The pre-2D implementation: pad to exactly image + kernel - 1, then one
+// r2c/c2r pair per row (plans cached, so only transform cost is measured)
+static void rowwiseConvolve(const std::vector<std::vector<float>>& image,
+                            const std::vector<std::vector<float>>& kernel,
+                            std::vector<std::vector<float>>& output) {
+    FFTWrapper fftWrapper;
+    int kernel_rows = kernel.size();
+    int kernel_cols = kernel[0].size();
+    int padded_rows = image.size() + kernel_rows - 1;
+    int padded_cols = image[0].size() + kernel_cols - 1;
+
+    std::vector<std::vector<float>> padded_image(padded_rows, std::vector<float>(padded_cols, 0));
+    std::vector<std::vector<float>> padded_kernel(padded_rows, std::vector<float>(padded_cols, 0));
+    for (size_t i = 0; i < image.size(); ++i) {
+        std::copy(image[i].begin(), image[i].end(), padded_image[i + (kernel_rows - 1) / 2].begin() + (kernel_cols - 1) / 2);
+    }
+    for (int i = 0; i < kernel_rows; ++i) {
+        for (int j = 0; j < kernel_cols; ++j) {
+            padded_kernel[i][j] = kernel[kernel_rows - i - 1][kernel_cols - j - 1];
+        }
+    }
+
+    std::vector<std::vector<std::complex<float>>> fft_image(padded_rows), fft_kernel(padded_rows);
+    for (int i = 0; i < padded_rows; ++i) {
+        fftWrapper.performFFT1D(padded_image[i], fft_image[i], Flags::MEASURE);
+        fftWrapper.performFFT1D(padded_kernel[i], fft_kernel[i], Flags::MEASURE);
+    }
+
+    std::vector<std::complex<float>> fft_result(padded_cols / 2 + 1);
+    std::vector<float> result_row(padded_cols);
+    for (size_t i = 0; i < output.size(); ++i) {
+        for (size_t j = 0; j < fft_result.size(); ++j) {
+            fft_result[j] = fft_image[i][j] * fft_kernel[i][j];
+        }
+        fftWrapper.performInverseFFT1D(fft_result, result_row, Flags::MEASURE);
+        std::copy(result_row.begin(), result_row.begin() + output[i].size(), output[i].begin());
+    }
+}
+
+template <typename Fn>
+static double medianMillis(int repeats, Fn fn) {
+    fn();  // warm-up: planning is not part of the measurement
+    std::vector<double> times;
+    for (int r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    int kernel_size = argc > 1 ? std::atoi(argv[1]) : 5;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+    std::vector<int> sizes;
+    for (int i = 3; i < argc; ++i) sizes.push_back(std::atoi(argv[i]));
+    if (sizes.empty()) sizes = {61, 127, 251, 509, 1021, 2039};
+
+    std::vector<std::vector<float>> kernel(kernel_size, std::vector<float>(kernel_size, 1.0f / (kernel_size * kernel_size)));
+
+    std::cout << "kernel " << kernel_size << "x" << kernel_size << ", median of " << repeats << " runs\n";
+    std::cout << std::setw(8) << "size" << std::setw(14) << "rowwise ms" << std::setw(14) << "2D fft ms"
+              << std::setw(12) << "fft extent" << std::setw(10) << "speedup" << "\n";
+
+    for (int size : sizes) {
+        std::vector<std::vector<float>> image(size, std::vector<float>(size));
+        for (int i = 0; i < size; ++i)
+            for (int j = 0; j < size; ++j)
+                image[i][j] = static_cast<float>((i * 31 + j * 17) % 23);
+
+        std::vector<std::vector<float>> rowwise_out(size, std::vector<float>(size));
+        double rowwise = medianMillis(repeats, [&]() { rowwiseConvolve(image, kernel, rowwise_out); });
+        double spectral = medianMillis(repeats, [&]() { convolve(image, kernel, 1, Padding::ZERO); });
+
+        std::cout << std::setw(8) << size << std::fixed << std::setprecision(3)
+                  << std::setw(14) << rowwise << std::setw(14) << spectral
+                  << std::setw(12) << fftConvolutionSize(size, kernel_size, Padding::ZERO)
+                  << std::setw(9) << std::setprecision(2) << rowwise / spectral << "x\n";
+    }
+    return 0;
+}
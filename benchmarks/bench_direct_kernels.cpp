@@ -0,0 +1,77 @@
+// Compares the fixed-size direct kernels against the FFT path for the
+// kernel sizes they cover, with a few sizes that keep the generic direct
+// loops for contrast. 1xK kernels are timed on 1D signals of size^2 samples.
+//
+// Usage: bench_direct_kernels [repeats] [size...]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "src/conv_engine.h"
+#include "src/direct_kernels.h"
+#include "src/simd.h"
+
+template <typename Fn>
+static double medianMillis(int repeats, Fn fn) {
+    fn();  // warm-up: planning is not part of the measurement
+    std::vector<double> times;
+    for (int r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    int repeats = argc > 1 ? std::atoi(argv[1]) : 5;
+    std::vector<int> sizes;
+    for (int i = 2; i < argc; ++i) sizes.push_back(std::atoi(argv[i]));
+    if (sizes.empty()) sizes = {64, 256, 1024};
+
+    struct Shape {
+        int rows;
+        int cols;
+    };
+    const Shape shapes[] = {{1, 3}, {1, 5}, {1, 7}, {1, 9}, {1, 8}, {3, 3}, {5, 5}, {7, 7}, {4, 4}, {6, 6}};
+
+    std::cout << "simd " << simdLevelName(getSimdLevel()) << ", median of " << repeats << " runs\n";
+    std::cout << std::setw(8) << "kernel" << std::setw(9) << "path" << std::setw(8) << "size"
+              << std::setw(13) << "direct ms" << std::setw(13) << "fft ms" << std::setw(12) << "speedup"
+              << std::setw(13) << "ns/tap" << "\n";
+
+    for (const Shape& shape : shapes) {
+        for (int size : sizes) {
+            // 1D signals are one-row images
+            int rows = shape.rows == 1 ? 1 : size;
+            int cols = shape.rows == 1 ? size * size : size;
+            Tensor<float> image(rows, cols);
+            for (int i = 0; i < rows; ++i)
+                for (int j = 0; j < cols; ++j) image(i, j) = static_cast<float>((i * 31 + j * 17) % 23);
+            Tensor<float> kernel(shape.rows, shape.cols);
+            for (int i = 0; i < shape.rows; ++i)
+                for (int j = 0; j < shape.cols; ++j) kernel(i, j) = 1.0f / (shape.rows * shape.cols);
+            Tensor<float> output(rows, cols);
+
+            double direct = medianMillis(repeats, [&]() {
+                dispatchConvolve2D(image, kernel, output, Padding::ZERO, 0, ConvAlgorithm::DIRECT);
+            });
+            double spectral = medianMillis(repeats, [&]() {
+                dispatchConvolve2D(image, kernel, output, Padding::ZERO, 0, ConvAlgorithm::FFT);
+            });
+            double taps = static_cast<double>(rows) * cols * shape.rows * shape.cols;
+
+            std::cout << std::setw(5) << shape.rows << "x" << std::setw(2) << std::left << shape.cols << std::right
+                      << std::setw(9) << (fixedDirectKernel(shape.rows, shape.cols) ? "fixed" : "generic")
+                      << std::setw(8) << size << std::fixed << std::setprecision(3)
+                      << std::setw(13) << direct << std::setw(13) << spectral
+                      << std::setw(11) << std::setprecision(2) << spectral / direct << "x"
+                      << std::setw(13) << std::setprecision(4) << direct * 1e6 / taps << "\n";
+        }
+    }
+    return 0;
+}
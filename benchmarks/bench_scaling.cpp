@@ -0,0 +1,92 @@
+// Thread scaling of each backend: median time and speedup over one thread
+// as the thread count goes from 1 to N.
+//
+// Usage: bench_scaling [max_threads] [size] [repeats]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "src/conv_engine.h"
+#include "src/conv_layer.h"
+#include "src/parallel.h"
+
+template <typename Fn>
+static double medianMillis(int repeats, Fn fn) {
+    fn();  // warm-up: planning is not part of the measurement
+    std::vector<double> times;
+    for (int r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    int max_threads = argc > 1 ? std::atoi(argv[1]) : getNumThreads();
+    int size = argc > 2 ? std::atoi(argv[2]) : 2048;
+    int repeats = argc > 3 ? std::atoi(argv[3]) : 5;
+
+    Tensor<float> image(size, size, 1, 4);
+    for (int b = 0; b < 4; ++b)
+        for (int i = 0; i < size; ++i)
+            for (int j = 0; j < size; ++j) image(b, 0, i, j) = static_cast<float>((i * 31 + j * 17 + b) % 23);
+    Tensor<float> output(size, size, 1, 4);
+
+    struct Case {
+        const char* name;
+        ConvAlgorithm algorithm;
+        int kernel_size;
+    };
+    std::vector<Case> cases = {
+        {"direct 5x5", ConvAlgorithm::DIRECT, 5},
+        {"winograd 3x3", ConvAlgorithm::WINOGRAD, 3},
+        {"separable 15x15", ConvAlgorithm::SEPARABLE, 15},
+        {"fft 31x31", ConvAlgorithm::FFT, 31},
+        {"tiled fft 31x31", ConvAlgorithm::TILED_FFT, 31},
+    };
+
+    // A small layer, batched: the frequency-domain accumulation is split by output channel
+    int layer_size = std::min(size, 256);
+    Tensor<float> filters(5, 5, 8, 16);
+    for (int k = 0; k < 16; ++k)
+        for (int c = 0; c < 8; ++c)
+            for (int i = 0; i < 5; ++i)
+                for (int j = 0; j < 5; ++j) filters(k, c, i, j) = static_cast<float>((k + c * 3 + i * 5 + j) % 7) - 3;
+    Tensor<float> layer_input(layer_size, layer_size, 8, 4);
+    Tensor<float> layer_output(layer_size, layer_size, 16, 4);
+    ConvLayer layer(filters, Padding::ZERO, 0, ConvAlgorithm::FFT);
+
+    std::cout << size << "x" << size << " x4 images, median of " << repeats << " runs\n";
+    std::cout << std::setw(18) << "backend";
+    for (int t = 1; t <= max_threads; t *= 2) std::cout << std::setw(10) << t << "T ms" << std::setw(8) << "x";
+    std::cout << "\n";
+
+    auto row = [&](const char* name, auto run) {
+        std::cout << std::setw(18) << name << std::fixed;
+        double serial = 0;
+        for (int t = 1; t <= max_threads; t *= 2) {
+            setNumThreads(t);
+            double ms = medianMillis(repeats, run);
+            if (t == 1) serial = ms;
+            std::cout << std::setw(14) << std::setprecision(3) << ms
+                      << std::setw(7) << std::setprecision(2) << serial / ms << "x";
+        }
+        std::cout << "\n";
+    };
+
+    for (const Case& c : cases) {
+        Tensor<float> kernel(c.kernel_size, c.kernel_size);
+        for (int i = 0; i < c.kernel_size; ++i)
+            for (int j = 0; j < c.kernel_size; ++j) kernel(i, j) = 1.0f / (c.kernel_size * c.kernel_size);
+        row(c.name, [&]() { dispatchConvolve2D(image, kernel, output, Padding::ZERO, 0, c.algorithm); });
+    }
+    row("layer 8->16 5x5", [&]() { layer.forward(layer_input, layer_output); });
+
+    setNumThreads(0);
+    return 0;
+}
@@ -0,0 +1,300 @@
+// Benchmark suite for regression tracking. Sweeps 1D lengths, 2D image
+// sizes, kernel sizes, batch sizes, padding modes, plan flags and thread
+// counts over every backend (and 1D batches one call per signal against
+// batched calls), and reports median/p99 latency, effective
+// GFLOP/s (2 x outputs x taps of the direct computation, per second) and
+// bytes allocated per call, as a table and optionally as JSON for
+// benchmarks/compare_bench.py.
+//
+// Usage: bench_suite [--full] [--repeats N] [--sizes a,b,..] [--lengths a,b,..]
+//                    [--kernels a,b,..] [--threads a,b,..] [--filter text] [--json path]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "src/conv_engine.h"
+#include "src/convolution.h"
+#include "src/parallel.h"
+#include "src/simd.h"
+
+// ------------------- Allocation Counting -------------------
+
+// Every operator new and (through the linker's --wrap) every fftwf_malloc
+// of the library is counted
+static std::atomic<std::size_t> allocated_bytes{0};
+static std::atomic<std::size_t> allocation_count{0};
+
+void* operator new(std::size_t bytes) {
+    allocated_bytes += bytes;
+    ++allocation_count;
+    if (void* p = std::malloc(bytes ? bytes : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+extern "C" void* __real_fftwf_malloc(std::size_t bytes);
+extern "C" void* __wrap_fftwf_malloc(std::size_t bytes) {
+    allocated_bytes += bytes;
+    ++allocation_count;
+    return __real_fftwf_malloc(bytes);
+}
+
+// ------------------- Cases -------------------
+
+struct Case {
+    std::string backend;
+    int dims;      // 1 or 2
+    int size;      // signal length, or image rows and cols
+    int kernel;
+    int batch;
+    Padding padding;
+    Flags flags;
+    int threads;
+};
+
+struct Result {
+    double median_ns;
+    double p99_ns;
+    double gflops;
+    std::size_t bytes;
+    std::size_t allocations;
+};
+
+static const char* paddingName(Padding padding) {
+    switch (padding) {
+        case Padding::VALID: return "valid";
+        case Padding::ZERO: return "zero";
+        case Padding::CONSTANT: return "constant";
+        case Padding::REPLICATE: return "replicate";
+        case Padding::REFLECT: return "reflect";
+        case Padding::FULL: return "full";
+        case Padding::CIRCULAR: return "circular";
+    }
+    return "?";
+}
+
+static const char* flagsName(Flags flags) {
+    return flags == Flags::ESTIMATE ? "estimate" : flags == Flags::MEASURE ? "measure" : "patient";
+}
+
+static ConvAlgorithm algorithmNamed(const std::string& name) {
+    if (name == "direct") return ConvAlgorithm::DIRECT;
+    if (name == "winograd") return ConvAlgorithm::WINOGRAD;
+    if (name == "separable") return ConvAlgorithm::SEPARABLE;
+    if (name == "fft") return ConvAlgorithm::FFT;
+    if (name == "tiled_fft") return ConvAlgorithm::TILED_FFT;
+    return ConvAlgorithm::AUTO;
+}
+
+static bool isSpectral(const std::string& backend) {
+    return backend == "fft" || backend == "tiled_fft";
+}
+
+// batched_direct and batched_fft run 1D batches through convolveBatch1D
+static bool isBatched(const std::string& backend) {
+    return backend.compare(0, 8, "batched_") == 0;
+}
+
+static std::string caseName(const Case& c) {
+    std::ostringstream name;
+    name << c.backend << "/" << c.dims << "d/" << c.size << "/k" << c.kernel << "/b" << c.batch << "/"
+         << paddingName(c.padding) << "/" << flagsName(c.flags) << "/t" << c.threads;
+    return name.str();
+}
+
+static Result run(const Case& c, int repeats) {
+    setNumThreads(c.threads);
+    setPlanFlags(c.flags);
+    double outputs;
+    std::vector<double> times;
+    std::size_t bytes = 0, allocations = 0;
+
+    auto measure = [&](auto call) {
+        call();  // warm-up: planning and spectrum caching are not measured
+        for (int r = 0; r < repeats; ++r) {
+            std::size_t bytes_before = allocated_bytes, count_before = allocation_count;
+            auto start = std::chrono::steady_clock::now();
+            call();
+            times.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+            bytes = allocated_bytes - bytes_before;
+            allocations = allocation_count - count_before;
+        }
+    };
+
+    if (c.dims == 1 && isBatched(c.backend)) {
+        // The batch as one [batch][length] buffer, in one convolveBatch1D call
+        Tensor<float> signals(c.batch, c.size);
+        for (int b = 0; b < c.batch; ++b)
+            for (int i = 0; i < c.size; ++i) signals(b, i) = static_cast<float>((i * 31 + b) % 17);
+        Tensor<float> kernel(1, c.kernel);
+        for (int i = 0; i < c.kernel; ++i) kernel(0, i) = 1.0f / c.kernel;
+        Tensor<float> output(c.batch, convolutionOutputSize(c.size, c.kernel, c.padding));
+        setConvAlgorithm(algorithmNamed(c.backend.substr(8)));
+        outputs = static_cast<double>(output.rows()) * output.cols();
+        measure([&]() { convolveBatch1D(signals, kernel, output, c.padding, 0.5f); });
+        setConvAlgorithm(ConvAlgorithm::AUTO);
+    } else if (c.dims == 1) {
+        // 1D signals go through convolve(), which reads the global algorithm,
+        // one call per signal
+        std::vector<float> signal(c.size), kernel(c.kernel, 1.0f / c.kernel);
+        for (int i = 0; i < c.size; ++i) signal[i] = static_cast<float>((i * 31) % 17);
+        setConvAlgorithm(algorithmNamed(c.backend));
+        outputs = static_cast<double>(convolutionOutputSize(c.size, c.kernel, c.padding)) * c.batch;
+        measure([&]() {
+            for (int b = 0; b < c.batch; ++b) convolve(signal, kernel, 1, c.padding, 0.5f);
+        });
+        setConvAlgorithm(ConvAlgorithm::AUTO);
+    } else {
+        Tensor<float> image(c.size, c.size, 1, c.batch);
+        for (int b = 0; b < c.batch; ++b)
+            for (int i = 0; i < c.size; ++i)
+                for (int j = 0; j < c.size; ++j) image(b, 0, i, j) = static_cast<float>((i * 31 + j * 17 + b) % 23);
+        // Box kernels are rank 1, so every backend (separable included) applies
+        Tensor<float> kernel(c.kernel, c.kernel);
+        for (int i = 0; i < c.kernel; ++i)
+            for (int j = 0; j < c.kernel; ++j) kernel(i, j) = 1.0f / (c.kernel * c.kernel);
+        int out = convolutionOutputSize(c.size, c.kernel, c.padding);
+        Tensor<float> output(out, out, 1, c.batch);
+        outputs = static_cast<double>(out) * out * c.batch;
+        ConvAlgorithm algorithm = algorithmNamed(c.backend);
+        measure([&]() { dispatchConvolve2D(image, kernel, output, c.padding, 0.5f, algorithm); });
+    }
+
+    std::sort(times.begin(), times.end());
+    double taps = c.dims == 1 ? c.kernel : static_cast<double>(c.kernel) * c.kernel;
+    Result result;
+    result.median_ns = times[times.size() / 2];
+    result.p99_ns = times[static_cast<std::size_t>(std::ceil(0.99 * times.size())) - 1];
+    result.gflops = 2 * outputs * taps / result.median_ns;
+    result.bytes = bytes;
+    result.allocations = allocations;
+    return result;
+}
+
+// ------------------- Sweep -------------------
+
+static std::vector<int> parseList(const char* text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) values.push_back(std::atoi(item.c_str()));
+    return values;
+}
+
+int main(int argc, char** argv) {
+    bool full = false;
+    int repeats = 15;
+    std::string json_path, filter;
+    std::vector<int> sizes = {64, 256, 1024};
+    std::vector<int> lengths = {1000, 100000};
+    std::vector<int> kernels = {3, 7, 31};
+    std::vector<int> threads = {1, getNumThreads()};
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--full") full = true;
+        else if (arg == "--repeats" && has_value) repeats = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--sizes" && has_value) sizes = parseList(argv[++i]);
+        else if (arg == "--lengths" && has_value) lengths = parseList(argv[++i]);
+        else if (arg == "--kernels" && has_value) kernels = parseList(argv[++i]);
+        else if (arg == "--threads" && has_value) threads = parseList(argv[++i]);
+        else if (arg == "--filter" && has_value) filter = argv[++i];
+        else if (arg == "--json" && has_value) json_path = argv[++i];
+        else {
+            std::cerr << "unknown argument " << arg << "\n";
+            return 1;
+        }
+    }
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+    // The default sweep varies one dimension at a time around zero padding,
+    // one image and MEASURE plans; --full takes the whole cross product
+    std::vector<int> batches = full ? std::vector<int>{1, 8} : std::vector<int>{1};
+    std::vector<Padding> paddings = full ? std::vector<Padding>{Padding::VALID, Padding::ZERO, Padding::REFLECT,
+                                                                               Padding::CIRCULAR}
+                                         : std::vector<Padding>{Padding::ZERO};
+    std::vector<Flags> plan_flags = full ? std::vector<Flags>{Flags::ESTIMATE, Flags::MEASURE}
+                                         : std::vector<Flags>{Flags::MEASURE};
+
+    std::vector<Case> cases;
+    auto add = [&](const Case& c) {
+        if (filter.empty() || caseName(c).find(filter) != std::string::npos) cases.push_back(c);
+    };
+    for (int t : threads) {
+        for (int length : lengths)
+            for (int k : kernels)
+                for (Padding padding : paddings)
+                    for (const char* backend : {"direct", "fft"})
+                        for (Flags flags : plan_flags)
+                            if (k < length && (isSpectral(backend) || flags == plan_flags.back()))
+                                add(Case{backend, 1, length, k, 1, padding, flags, t});
+        for (int size : sizes)
+            for (int k : kernels)
+                for (int batch : batches)
+                    for (Padding padding : paddings)
+                        for (const char* backend : {"direct", "winograd", "separable", "fft", "tiled_fft"})
+                            for (Flags flags : plan_flags) {
+                                if (k >= size || (std::string(backend) == "winograd" && k != 3)) continue;
+                                if (!isSpectral(backend) && flags != plan_flags.back()) continue;
+                                add(Case{backend, 2, size, k, batch, padding, flags, t});
+                            }
+    }
+    // Many short signals: one convolve() per signal against one batched call
+    for (const char* backend : {"direct", "fft", "batched_direct", "batched_fft"}) {
+        int k = kernels[kernels.size() / 2];
+        if (k < lengths.front()) add(Case{backend, 1, lengths.front(), k, 256, Padding::ZERO, Flags::MEASURE,
+                                          threads.back()});
+    }
+    if (!full) {
+        // Batch, padding and flag variations on a mid-sized problem
+        int size = sizes[sizes.size() / 2], k = kernels[kernels.size() / 2];
+        for (const char* backend : {"direct", "fft"}) {
+            add(Case{backend, 2, size, k, 8, Padding::ZERO, Flags::MEASURE, threads.back()});
+            add(Case{backend, 2, size, k, 1, Padding::REFLECT, Flags::MEASURE, threads.back()});
+            add(Case{backend, 2, size, k, 1, Padding::CIRCULAR, Flags::MEASURE, threads.back()});
+        }
+        add(Case{"fft", 2, size, k, 1, Padding::ZERO, Flags::ESTIMATE, threads.back()});
+    }
+
+    std::cout << std::left << std::setw(44) << "case" << std::right << std::setw(13) << "median us"
+              << std::setw(13) << "p99 us" << std::setw(10) << "GFLOP/s" << std::setw(14) << "bytes/call" << "\n";
+    std::ostringstream json;
+    json << std::fixed << "{\n  \"schema\": 1,\n  \"repeats\": " << repeats << ",\n  \"simd\": \""
+         << simdLevelName(getSimdLevel()) << "\",\n  \"results\": [";
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const Case& c = cases[i];
+        Result r = run(c, repeats);
+        std::cout << std::left << std::setw(44) << caseName(c) << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(13) << r.median_ns / 1000 << std::setw(13) << r.p99_ns / 1000
+                  << std::setprecision(2) << std::setw(10) << r.gflops << std::setw(14) << r.bytes << "\n";
+        json << (i ? "," : "") << "\n    {\"name\": \"" << caseName(c) << "\", \"backend\": \"" << c.backend
+             << "\", \"dims\": " << c.dims << ", \"size\": " << c.size << ", \"kernel\": " << c.kernel
+             << ", \"batch\": " << c.batch << ", \"padding\": \"" << paddingName(c.padding)
+             << "\", \"flags\": \"" << flagsName(c.flags) << "\", \"threads\": " << c.threads
+             << std::setprecision(1) << ", \"median_ns\": " << r.median_ns << ", \"p99_ns\": " << r.p99_ns
+             << std::setprecision(4) << ", \"gflops\": " << r.gflops << ", \"bytes_allocated\": " << r.bytes
+             << ", \"allocations\": " << r.allocations << "}";
+    }
+    json << "\n  ]\n}\n";
+    setNumThreads(0);
+
+    if (!json_path.empty()) {
+        std::ofstream file(json_path, std::ios::trunc);
+        file << json.str();
+        if (!file) {
+            std::cerr << "could not write " << json_path << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""Diff two bench_suite JSON files.
+
+Cases are matched by name. For each one the script prints the median and
+p99 latency ratios (current / baseline) and the change in bytes allocated.
+A case whose median grew by more than --threshold is a regression, and the
+script then exits with status 1.
+
+Usage: compare_bench.py baseline.json current.json [--threshold 0.10]
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return {r["name"]: r for r in data["results"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative median slowdown counted as a regression (default 0.10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = 0
+    print(f"{'case':<44}{'median':>10}{'p99':>10}{'bytes':>14}")
+    for name in sorted(set(baseline) & set(current)):
+        old, new = baseline[name], current[name]
+        median = new["median_ns"] / old["median_ns"] if old["median_ns"] else float("inf")
+        p99 = new["p99_ns"] / old["p99_ns"] if old["p99_ns"] else float("inf")
+        bytes_delta = new["bytes_allocated"] - old["bytes_allocated"]
+        regressed = median > 1 + args.threshold
+        regressions += regressed
+        print(f"{name:<44}{median:>9.2f}x{p99:>9.2f}x{bytes_delta:>+14d}{'  REGRESSION' if regressed else ''}")
+
+    for name in sorted(set(baseline) - set(current)):
+        print(f"{name:<44}  missing from {args.current}")
+    for name in sorted(set(current) - set(baseline)):
+        print(f"{name:<44}  new")
+
+    print(f"{regressions} regression(s) over {args.threshold:.0%}")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
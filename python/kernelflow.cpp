@@ -0,0 +1,364 @@
+// Python bindings. float32 arrays (numpy or anything else exporting the
+// buffer protocol) are wrapped as TensorViews without copying: the last
+// one or two axes are rows and cols, leading axes are channels and batch.
+// The GIL is released while convolving, so Python threads can run
+// convolutions concurrently.
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "src/conv_engine.h"
+#include "src/conv_layer.h"
+#include "src/convolution.h"
+#include "src/correlation.h"
+#include "src/parallel.h"
+#include "src/prepared_kernel.h"
+
+namespace py = pybind11;
+
+// A buffer seen as [batch][channels][rows][cols]. Views are zero-copy when
+// the last axis is contiguous and every stride is a non-negative multiple
+// of a float; other read-only inputs are gathered into `staging`.
+struct BufferTensor {
+    py::buffer_info info;
+    Tensor<float> staging;
+    TensorView<float> view;
+};
+
+static bool isFloat32(const std::string& format) {
+    return format == "f" || format == "<f" || format == "=f" || format == "@f";
+}
+
+static void wrapBuffer(BufferTensor& tensor, bool writable, const char* name) {
+    const py::buffer_info& info = tensor.info;
+    if (!isFloat32(info.format) || info.itemsize != sizeof(float)) {
+        throw py::type_error(std::string(name) + " must be a float32 array");
+    }
+    if (info.ndim < 1 || info.ndim > 4) {
+        throw py::value_error(std::string(name) + " must have 1 to 4 dimensions");
+    }
+    if (writable && info.readonly) {
+        throw py::value_error(std::string(name) + " must be writable");
+    }
+
+    // Missing leading axes have extent 1
+    int extent[4] = {1, 1, 1, 1};
+    py::ssize_t stride[4] = {0, 0, 0, 0};
+    for (py::ssize_t d = 0; d < info.ndim; ++d) {
+        extent[4 - info.ndim + d] = static_cast<int>(info.shape[d]);
+        stride[4 - info.ndim + d] = info.strides[d];
+    }
+    int batch = extent[0], channels = extent[1], rows = extent[2], cols = extent[3];
+
+    // Axes of extent 1 are never stepped along, so their stride is free
+    bool zero_copy = true;
+    std::ptrdiff_t pitch[4];
+    for (int d = 0; d < 4; ++d) {
+        if (extent[d] == 1) {
+            stride[d] = 0;
+        }
+        zero_copy = zero_copy && stride[d] >= 0 && stride[d] % static_cast<py::ssize_t>(sizeof(float)) == 0;
+        pitch[d] = static_cast<std::ptrdiff_t>(stride[d] / static_cast<py::ssize_t>(sizeof(float)));
+    }
+    zero_copy = zero_copy && (cols == 1 || pitch[3] == 1);
+    if (rows == 1) pitch[2] = cols;
+    zero_copy = zero_copy && pitch[2] >= cols;
+
+    float* data = static_cast<float*>(info.ptr);
+    if (zero_copy) {
+        tensor.view = TensorView<float>(data, rows, cols, channels, batch, pitch[2], pitch[1], pitch[0]);
+        return;
+    }
+    if (writable) {
+        throw py::value_error(std::string(name) + " must have a contiguous last axis");
+    }
+    tensor.staging = Tensor<float>(rows, cols, channels, batch);
+    const char* base = static_cast<const char*>(info.ptr);
+    for (int b = 0; b < batch; ++b)
+        for (int c = 0; c < channels; ++c)
+            for (int i = 0; i < rows; ++i)
+                for (int j = 0; j < cols; ++j)
+                    tensor.staging(b, c, i, j) = *reinterpret_cast<const float*>(
+                        base + b * stride[0] + c * stride[1] + i * stride[2] + j * stride[3]);
+    tensor.view = tensor.staging.view();
+}
+
+static void requestBuffer(BufferTensor& tensor, const py::buffer& buffer, bool writable, const char* name) {
+    tensor.info = buffer.request(writable);
+    wrapBuffer(tensor, writable, name);
+}
+
+// The caller's `out`, checked against the expected shape, or a new array
+static py::object outputArray(const py::object& out, const std::vector<py::ssize_t>& shape, BufferTensor& tensor) {
+    if (out.is_none()) {
+        py::array_t<float> array(shape);
+        requestBuffer(tensor, array, true, "out");
+        return std::move(array);
+    }
+    requestBuffer(tensor, out.cast<py::buffer>(), true, "out");
+    if (tensor.info.shape != shape) {
+        throw py::value_error("out has the wrong shape");
+    }
+    return out;
+}
+
+// Shape of an input with its last `axes` extents replaced
+static std::vector<py::ssize_t> replaceTrailing(const py::buffer_info& info, std::vector<py::ssize_t> trailing) {
+    std::vector<py::ssize_t> shape(info.shape.begin(), info.shape.end() - trailing.size());
+    shape.insert(shape.end(), trailing.begin(), trailing.end());
+    return shape;
+}
+
+static py::object convolveArray(const py::buffer& image, const py::buffer& kernel, const py::object& out,
+                                int stride, Padding padding, float pad_val, ConvAlgorithm algorithm) {
+    BufferTensor input, filter, output;
+    requestBuffer(input, image, false, "image");
+    requestBuffer(filter, kernel, false, "kernel");
+    if (filter.info.ndim > 2 || (input.info.ndim == 1 && filter.info.ndim != 1)) {
+        throw py::value_error("kernel must be 1D for signals and 1D or 2D for images");
+    }
+
+    int output_rows = convolutionOutputSize(input.view.rows(), filter.view.rows(), padding, stride);
+    int output_cols = convolutionOutputSize(input.view.cols(), filter.view.cols(), padding, stride);
+    if (output_rows <= 0 || output_cols <= 0) {
+        throw py::value_error("Kernel does not fit in the image");
+    }
+    std::vector<py::ssize_t> shape = input.info.ndim == 1 ? replaceTrailing(input.info, {output_cols})
+                                                          : replaceTrailing(input.info, {output_rows, output_cols});
+    py::object result = outputArray(out, shape, output);
+
+    py::gil_scoped_release release;
+    dispatchConvolve2D(input.view, filter.view, output.view, padding, pad_val, algorithm, stride);
+    return result;
+}
+
+static py::object convolveBatchArray(const py::buffer& signals, const py::buffer& kernels, const py::object& out,
+                                     Padding padding, float pad_val) {
+    BufferTensor input, filter, output;
+    requestBuffer(input, signals, false, "signals");
+    requestBuffer(filter, kernels, false, "kernels");
+    if (input.info.ndim != 2) {
+        throw py::value_error("signals must be [count][length]");
+    }
+    if (filter.info.ndim > 2 || (filter.info.ndim == 2 && filter.view.rows() != input.view.rows())) {
+        throw py::value_error("kernels must be one kernel or [count][length]");
+    }
+
+    int output_cols = convolutionOutputSize(input.view.cols(), filter.view.cols(), padding);
+    if (output_cols <= 0) {
+        throw py::value_error("Kernel does not fit in the signals");
+    }
+    py::object result = outputArray(out, replaceTrailing(input.info, {output_cols}), output);
+
+    py::gil_scoped_release release;
+    convolveBatch1D(input.view, filter.view, output.view, padding, pad_val);
+    return result;
+}
+
+static PreparedKernel prepareKernel(const py::buffer& kernel, const std::vector<int>& shape, Padding padding) {
+    BufferTensor filter;
+    requestBuffer(filter, kernel, false, "kernel");
+    if (shape.size() == 1 && filter.info.ndim == 1) {
+        std::vector<float> taps(filter.view.row(0, 0, 0), filter.view.row(0, 0, 0) + filter.view.cols());
+        py::gil_scoped_release release;
+        return PreparedKernel(taps, shape[0], padding);
+    }
+    if (shape.size() == 2 && filter.info.ndim == 2) {
+        py::gil_scoped_release release;
+        return PreparedKernel(filter.view, shape[0], shape[1], padding);
+    }
+    throw py::value_error("shape must be (length,) for 1D kernels and (rows, cols) for 2D kernels");
+}
+
+static py::object convolvePrepared(const py::buffer& image, const PreparedKernel& kernel, const py::object& out,
+                                   float pad_val) {
+    BufferTensor input, output;
+    requestBuffer(input, image, false, "image");
+    std::vector<py::ssize_t> shape = kernel.rank() == 1 || input.info.ndim == 1
+                                         ? replaceTrailing(input.info, {kernel.outputCols()})
+                                         : replaceTrailing(input.info, {kernel.outputRows(), kernel.outputCols()});
+    py::object result = outputArray(out, shape, output);
+
+    py::gil_scoped_release release;
+    convolve(input.view, kernel, output.view, pad_val);
+    return result;
+}
+
+// Templates [count][rows][cols] (or one [rows][cols]) as a batch of
+// single-channel images
+static TensorView<float> templateBatch(const BufferTensor& tensor, const char* name) {
+    if (tensor.info.ndim < 2 || tensor.info.ndim > 3) {
+        throw py::value_error(std::string(name) + " must be [count][rows][cols] or [rows][cols]");
+    }
+    const TensorView<float>& v = tensor.view;
+    return TensorView<float>(v.data(), v.rows(), v.cols(), 1, v.channels(), v.rowStride(), v.channelStride(),
+                             v.channelStride());
+}
+
+static void requestMatch(BufferTensor& input, BufferTensor& bank, const py::buffer& image,
+                         const py::buffer& templates) {
+    requestBuffer(input, image, false, "image");
+    requestBuffer(bank, templates, false, "templates");
+    if (input.info.ndim != 2) {
+        throw py::value_error("image must be [rows][cols]");
+    }
+    templateBatch(bank, "templates");
+    if (bank.view.rows() > input.view.rows() || bank.view.cols() > input.view.cols()) {
+        throw py::value_error("Template does not fit in the image");
+    }
+}
+
+static py::object correlateArray(const py::buffer& image, const py::buffer& templates, MatchMethod method,
+                                 const py::object& out) {
+    BufferTensor input, bank, output;
+    requestMatch(input, bank, image, templates);
+    std::vector<py::ssize_t> shape = replaceTrailing(bank.info, {input.view.rows() - bank.view.rows() + 1,
+                                                                 input.view.cols() - bank.view.cols() + 1});
+    py::object result = outputArray(out, shape, output);
+
+    TensorView<float> scores = templateBatch(output, "out");
+    TensorView<float> batch = templateBatch(bank, "templates");
+    py::gil_scoped_release release;
+    correlate2D(input.view, batch, scores, method);
+    return result;
+}
+
+// Peaks as (row, col, score) tuples, one list per template (a single list
+// for a single [rows][cols] template)
+static py::object matchArray(const py::buffer& image, const py::buffer& templates, int k, MatchMethod method,
+                             float min_score) {
+    BufferTensor input, bank;
+    requestMatch(input, bank, image, templates);
+    TensorView<float> batch = templateBatch(bank, "templates");
+    std::vector<std::vector<MatchPeak>> peaks;
+    {
+        py::gil_scoped_release release;
+        peaks = matchTemplates(input.view, batch, k, method, min_score);
+    }
+    py::list lists;
+    for (const std::vector<MatchPeak>& best : peaks) {
+        py::list list;
+        for (const MatchPeak& peak : best) {
+            list.append(py::make_tuple(peak.row, peak.col, peak.score));
+        }
+        lists.append(list);
+    }
+    return bank.info.ndim == 2 ? lists[0] : py::object(lists);
+}
+
+// ConvLayer::forward must not run concurrently on one layer; the lock is
+// taken with the GIL released
+struct PyConvLayer {
+    ConvLayer layer;
+    std::mutex mutex;
+
+    PyConvLayer(const TensorView<const float>& filters, Padding padding, float pad_val, ConvAlgorithm algorithm)
+        : layer(filters, padding, pad_val, algorithm) {}
+};
+
+static std::unique_ptr<PyConvLayer> makeLayer(const py::buffer& filters, Padding padding, float pad_val,
+                                              ConvAlgorithm algorithm) {
+    BufferTensor bank;
+    requestBuffer(bank, filters, false, "filters");
+    if (bank.info.ndim != 4) {
+        throw py::value_error("filters must be [out][in][rows][cols]");
+    }
+    return std::unique_ptr<PyConvLayer>(new PyConvLayer(bank.view, padding, pad_val, algorithm));
+}
+
+static py::object layerForward(PyConvLayer& self, const py::buffer& input, const py::object& out) {
+    BufferTensor in, output;
+    requestBuffer(in, input, false, "input");
+    if (in.info.ndim < 3) {
+        throw py::value_error("input must be [batch][channels][rows][cols] or [channels][rows][cols]");
+    }
+    std::vector<py::ssize_t> shape = replaceTrailing(in.info, {self.layer.outChannels(),
+                                                               self.layer.outputRows(in.view.rows()),
+                                                               self.layer.outputCols(in.view.cols())});
+    py::object result = outputArray(out, shape, output);
+
+    py::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(self.mutex);
+    self.layer.forward(in.view, output.view);
+    return result;
+}
+
+PYBIND11_MODULE(kernelflow, m) {
+    m.doc() = "FFT, Winograd and direct 2D convolution on float32 buffers";
+
+    py::enum_<Padding>(m, "Padding")
+        .value("VALID", Padding::VALID)
+        .value("ZERO", Padding::ZERO)
+        .value("CONSTANT", Padding::CONSTANT)
+        .value("REPLICATE", Padding::REPLICATE)
+        .value("REFLECT", Padding::REFLECT)
+        .value("FULL", Padding::FULL)
+        .value("CIRCULAR", Padding::CIRCULAR);
+
+    py::enum_<ConvAlgorithm>(m, "ConvAlgorithm")
+        .value("AUTO", ConvAlgorithm::AUTO)
+        .value("DIRECT", ConvAlgorithm::DIRECT)
+        .value("WINOGRAD", ConvAlgorithm::WINOGRAD)
+        .value("SEPARABLE", ConvAlgorithm::SEPARABLE)
+        .value("FFT", ConvAlgorithm::FFT)
+        .value("TILED_FFT", ConvAlgorithm::TILED_FFT);
+
+    py::enum_<Flags>(m, "Flags")
+        .value("ESTIMATE", Flags::ESTIMATE)
+        .value("MEASURE", Flags::MEASURE)
+        .value("PATIENT", Flags::PATIENT);
+
+    m.def("convolve", &convolveArray, py::arg("image"), py::arg("kernel"), py::arg("out") = py::none(),
+          py::arg("stride") = 1, py::arg("padding") = Padding::ZERO, py::arg("pad_val") = 0.0f,
+          py::arg("algorithm") = ConvAlgorithm::AUTO,
+          "Convolve a signal, an image or a [batch][channels] stack of images with one kernel.\n"
+          "The result is written to `out` if given, else to a new numpy array.");
+
+    m.def("convolve_batch", &convolveBatchArray, py::arg("signals"), py::arg("kernels"), py::arg("out") = py::none(),
+          py::arg("padding") = Padding::ZERO, py::arg("pad_val") = 0.0f,
+          "Convolve every row of a [count][length] array with one kernel or with its own row of\n"
+          "a [count][length] kernel array, using batched transforms.");
+
+    py::class_<PreparedKernel>(m, "PreparedKernel")
+        .def(py::init(&prepareKernel), py::arg("kernel"), py::arg("shape"), py::arg("padding") = Padding::ZERO,
+             "Transform `kernel` once for inputs of `shape`: (length,) or (rows, cols)")
+        .def_property_readonly("rank", &PreparedKernel::rank)
+        .def_property_readonly("padding", &PreparedKernel::padding)
+        .def_property_readonly("input_shape", [](const PreparedKernel& k) {
+            return k.rank() == 1 ? py::make_tuple(k.inputCols()) : py::make_tuple(k.inputRows(), k.inputCols());
+        })
+        .def_property_readonly("output_shape", [](const PreparedKernel& k) {
+            return k.rank() == 1 ? py::make_tuple(k.outputCols()) : py::make_tuple(k.outputRows(), k.outputCols());
+        });
+
+    m.def("convolve_prepared", &convolvePrepared, py::arg("image"), py::arg("kernel"),
+          py::arg("out") = py::none(), py::arg("pad_val") = 0.0f,
+          "Convolve every signal or image of `image` with a PreparedKernel");
+
+    py::class_<PyConvLayer>(m, "ConvLayer")
+        .def(py::init(&makeLayer), py::arg("filters"), py::arg("padding") = Padding::ZERO,
+             py::arg("pad_val") = 0.0f, py::arg("algorithm") = ConvAlgorithm::AUTO,
+             "Layer with a [out][in][rows][cols] filter bank (copied)")
+        .def_property_readonly("in_channels", [](const PyConvLayer& l) { return l.layer.inChannels(); })
+        .def_property_readonly("out_channels", [](const PyConvLayer& l) { return l.layer.outChannels(); })
+        .def("forward", &layerForward, py::arg("input"), py::arg("out") = py::none(),
+             "Convolve a [batch][in][rows][cols] (or [in][rows][cols]) input into [batch][out][...]");
+
+    py::enum_<MatchMethod>(m, "MatchMethod")
+        .value("CROSS_CORRELATION", MatchMethod::CROSS_CORRELATION)
+        .value("ZNCC", MatchMethod::ZNCC);
+
+    m.def("correlate", &correlateArray, py::arg("image"), py::arg("templates"),
+          py::arg("method") = MatchMethod::ZNCC, py::arg("out") = py::none(),
+          "Score every window of `image` against one template or a [count] stack of templates");
+    m.def("match_templates", &matchArray, py::arg("image"), py::arg("templates"), py::arg("k") = 1,
+          py::arg("method") = MatchMethod::ZNCC, py::arg("min_score") = -1e30f,
+          "The k best (row, col, score) peaks of each template, best first");
+
+    m.def("set_num_threads", &setNumThreads, py::arg("threads"), "Threads per call; 0 restores the default");
+    m.def("get_num_threads", &getNumThreads);
+    m.def("set_plan_flags", &setPlanFlags, py::arg("flags"));
+}
@@ -0,0 +1,103 @@
+#include "FFTWisdom.h"
+#include <fftw3.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+static const char* WISDOM_MAGIC = "kernel-flow-wisdom";
+
+FFTStatus FFTWisdom::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        return FFTStatus::FAILURE;
+    }
+
+    // Header: "<magic> <format version>" followed by the FFTW version string
+    std::string header, magic, fftwVersion;
+    int version = 0;
+    std::getline(file, header);
+    std::istringstream fields(header);
+    fields >> magic >> version >> fftwVersion;
+    if (!fields || magic != WISDOM_MAGIC || version != FORMAT_VERSION || fftwVersion != fftwf_version) {
+        return FFTStatus::FAILURE;
+    }
+
+    std::stringstream wisdom;
+    wisdom << file.rdbuf();
+    if (!FFTPlanCache::instance().importWisdom(wisdom.str())) {
+        return FFTStatus::FAILURE;
+    }
+
+    return FFTStatus::SUCCESS;
+}
+
+FFTStatus FFTWisdom::save(const std::string& path) {
+    std::string wisdom;
+    if (!FFTPlanCache::instance().exportWisdom(wisdom)) {
+        return FFTStatus::FAILURE;
+    }
+
+    // Write next to the target and rename, so a crash never leaves a truncated file
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        file << WISDOM_MAGIC << " " << FORMAT_VERSION << " " << fftwf_version << "\n" << wisdom;
+        if (!file) {
+            std::remove(tmpPath.c_str());
+            return FFTStatus::FAILURE;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return FFTStatus::FAILURE;
+    }
+
+    return FFTStatus::SUCCESS;
+}
+
+FFTStatus FFTWisdom::prePlan(const std::vector<FFTShape>& shapes, Flags flags) {
+    FFTWrapper fftWrapper;
+
+    // Run each transform once through FFTWrapper so exactly the plans it
+    // will look up later end up in the plan cache and in the wisdom
+    for (const auto& shape : shapes) {
+        if (shape.inPlace) {
+            int rows = shape.rank > 1 ? shape.dims[0] : 1;
+            int cols = shape.dims[shape.rank - 1];
+            Tensor<float> data(rows, cols, 1, 1, 2 * (cols / 2 + 1));
+            TensorView<std::complex<float>> spectrum(reinterpret_cast<std::complex<float>*>(data.data()),
+                                                     rows, cols / 2 + 1, 1, 1, cols / 2 + 1,
+                                                     rows * (cols / 2 + 1), rows * (cols / 2 + 1));
+            FFTStatus forward = shape.rank == 1 ? fftWrapper.performFFT1D(data.view(), spectrum, flags)
+                                                : fftWrapper.performFFT2D(data.view(), spectrum, flags);
+            FFTStatus inverse = shape.rank == 1 ? fftWrapper.performInverseFFT1D(spectrum, data.view(), flags)
+                                                : fftWrapper.performInverseFFT2D(spectrum, data.view(), flags);
+            if (forward != FFTStatus::SUCCESS || inverse != FFTStatus::SUCCESS) {
+                return FFTStatus::FAILURE;
+            }
+        } else if (shape.rank == 1) {
+            std::vector<float> signal(shape.dims[0], 0);
+            std::vector<std::complex<float>> spectrum;
+            if (fftWrapper.performFFT1D(signal, spectrum, flags) != FFTStatus::SUCCESS ||
+                fftWrapper.performInverseFFT1D(spectrum, signal, flags) != FFTStatus::SUCCESS) {
+                return FFTStatus::FAILURE;
+            }
+        } else if (shape.rank == 2) {
+            std::vector<std::vector<float>> image(shape.dims[0], std::vector<float>(shape.dims[1], 0));
+            std::vector<std::vector<std::complex<float>>> spectrum;
+            if (fftWrapper.performFFT2D(image, spectrum, flags) != FFTStatus::SUCCESS ||
+                fftWrapper.performInverseFFT2D(spectrum, image, flags) != FFTStatus::SUCCESS) {
+                return FFTStatus::FAILURE;
+            }
+        } else {
+            return FFTStatus::FAILURE;
+        }
+    }
+
+    return FFTStatus::SUCCESS;
+}
+
+void FFTWisdom::forget() {
+    FFTPlanCache::instance().forgetWisdom();
+}
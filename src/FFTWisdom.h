@@ -0,0 +1,36 @@
+#ifndef FFTWISDOM_H
+#define FFTWISDOM_H
+
+#include <string>
+#include <vector>
+#include "FFTWrapper.h"
+
+// Geometry of a real transform to pre-plan (rank 1 uses dims[0] only).
+// In-place shapes are planned on row-padded tensors, as the 2D engine uses them.
+struct FFTShape {
+    int rank;
+    int dims[2];
+    bool inPlace;
+};
+
+// Persistent FFTW wisdom. Wisdom files carry a header with the file format
+// version and the FFTW version that produced them; files from another
+// version are rejected rather than half-imported.
+class FFTWisdom {
+public:
+    static constexpr int FORMAT_VERSION = 1;
+
+    // Import wisdom from a file written by save()
+    static FFTStatus load(const std::string& path);
+
+    // Export the accumulated wisdom, replacing the file atomically
+    static FFTStatus save(const std::string& path);
+
+    // Plan (and cache) the forward and inverse transforms for each shape
+    static FFTStatus prePlan(const std::vector<FFTShape>& shapes, Flags flags);
+
+    // Drop all accumulated wisdom
+    static void forget();
+};
+
+#endif  // FFTWISDOM_H
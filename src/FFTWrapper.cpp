@@ -1,56 +1,245 @@
 #include "FFTWrapper.h"
 #include <fftw3.h>
+#include "instrumentation.h"
+#include "parallel.h"
+#include "simd.h"
+#include "workspace.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
 
-// Constructor
-FFTWrapper::FFTWrapper() {
-    forwardPlan1D = nullptr;
-    inversePlan1D = nullptr;
-    forwardPlan2D = nullptr;
-    inversePlan2D = nullptr;
+// ------------------- Plan Cache Implementation -------------------
+
+bool PlanKey::operator==(const PlanKey& other) const {
+    return rank == other.rank && dims[0] == other.dims[0] && dims[1] == other.dims[1] &&
+           layout.howmany == other.layout.howmany &&
+           layout.inPitch == other.layout.inPitch && layout.inDist == other.layout.inDist &&
+           layout.outPitch == other.layout.outPitch && layout.outDist == other.layout.outDist &&
+           inPlace == other.inPlace && direction == other.direction && flags == other.flags &&
+           inAlignment == other.inAlignment && outAlignment == other.outAlignment && threads == other.threads;
 }
 
-// Destructor
-FFTWrapper::~FFTWrapper() {
-    if (forwardPlan1D) fftwf_destroy_plan(forwardPlan1D);
-    if (inversePlan1D) fftwf_destroy_plan(inversePlan1D);
-    if (forwardPlan2D) fftwf_destroy_plan(forwardPlan2D);
-    if (inversePlan2D) fftwf_destroy_plan(inversePlan2D);
+std::size_t PlanKeyHash::operator()(const PlanKey& key) const {
+    std::size_t seed = 0;
+    auto combine = [&seed](std::size_t value) {
+        seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    };
+    combine(std::hash<int>()(key.rank));
+    combine(std::hash<int>()(key.dims[0]));
+    combine(std::hash<int>()(key.dims[1]));
+    combine(std::hash<int>()(key.layout.howmany));
+    combine(std::hash<int>()(key.layout.inPitch));
+    combine(std::hash<int>()(key.layout.inDist));
+    combine(std::hash<int>()(key.layout.outPitch));
+    combine(std::hash<int>()(key.layout.outDist));
+    combine(std::hash<bool>()(key.inPlace));
+    combine(std::hash<int>()(static_cast<int>(key.direction)));
+    combine(std::hash<unsigned>()(key.flags));
+    combine(std::hash<int>()(key.inAlignment));
+    combine(std::hash<int>()(key.outAlignment));
+    combine(std::hash<int>()(key.threads));
+    return seed;
+}
+
+// Layout of a single densely packed transform
+static PlanLayout denseLayout(int rank, const int* dims, FFTDirection direction) {
+    int realCols = dims[rank - 1];
+    int complexCols = realCols / 2 + 1;
+    int rows = rank > 1 ? dims[0] : 1;
+    if (direction == FFTDirection::FORWARD) {
+        return PlanLayout{1, realCols, rows * realCols, complexCols, rows * complexCols};
+    }
+    return PlanLayout{1, complexCols, rows * complexCols, realCols, rows * realCols};
+}
+
+FFTPlanCache& FFTPlanCache::instance() {
+    static FFTPlanCache cache;
+    return cache;
+}
+
+FFTPlanCache::~FFTPlanCache() {
+    clear();
+}
+
+fftwf_plan FFTPlanCache::createPlan(const PlanKey& key) {
+    ScopedStage stage(Stage::PLAN);
+    const PlanLayout& layout = key.layout;
+    int rows = key.rank > 1 ? key.dims[0] : 1;
+    bool forward = key.direction == FFTDirection::FORWARD;
+
+    // Extent of each side of the batch, in elements
+    std::size_t inCount = static_cast<std::size_t>(layout.howmany - 1) * layout.inDist +
+                          static_cast<std::size_t>(rows) * layout.inPitch;
+    std::size_t outCount = static_cast<std::size_t>(layout.howmany - 1) * layout.outDist +
+                           static_cast<std::size_t>(rows) * layout.outPitch;
+    std::size_t realBytes = (forward ? inCount : outCount) * sizeof(float);
+    std::size_t complexBytes = (forward ? outCount : inCount) * sizeof(fftwf_complex);
+
+    // Plan on scratch buffers offset to the caller's alignment, so that the
+    // plan can later be executed on the caller's arrays
+    const int maxOffset = 64;
+    char* realBase = static_cast<char*>(fftwf_malloc(std::max(realBytes, complexBytes) + maxOffset));
+    char* complexBase = key.inPlace ? realBase : static_cast<char*>(fftwf_malloc(complexBytes + maxOffset));
+    if (!realBase || !complexBase) {
+        fftwf_free(realBase);
+        if (!key.inPlace) fftwf_free(complexBase);
+        return nullptr;
+    }
+    countAllocation(std::max(realBytes, complexBytes) + maxOffset);
+    if (!key.inPlace) countAllocation(complexBytes + maxOffset);
+
+    int inEmbed[2] = {rows, layout.inPitch};
+    int outEmbed[2] = {rows, layout.outPitch};
+    const int* inEmbedDims = key.rank > 1 ? inEmbed : inEmbed + 1;
+    const int* outEmbedDims = key.rank > 1 ? outEmbed : outEmbed + 1;
+
+    // Planning is serialized by the cache lock, so the planner's global
+    // thread count can be set per plan
+    static bool threads_initialized = fftwf_init_threads() != 0;
+    if (threads_initialized) {
+        fftwf_plan_with_nthreads(key.threads);
+    }
+
+    fftwf_plan plan = nullptr;
+    if (forward) {
+        float* in = reinterpret_cast<float*>(realBase + key.inAlignment);
+        fftwf_complex* out = reinterpret_cast<fftwf_complex*>(complexBase + key.outAlignment);
+        plan = fftwf_plan_many_dft_r2c(key.rank, key.dims, layout.howmany, in, inEmbedDims, 1, layout.inDist,
+                                       out, outEmbedDims, 1, layout.outDist, key.flags);
+    } else {
+        fftwf_complex* in = reinterpret_cast<fftwf_complex*>(complexBase + key.inAlignment);
+        float* out = reinterpret_cast<float*>(realBase + key.outAlignment);
+        plan = fftwf_plan_many_dft_c2r(key.rank, key.dims, layout.howmany, in, inEmbedDims, 1, layout.inDist,
+                                       out, outEmbedDims, 1, layout.outDist, key.flags);
+    }
+
+    fftwf_free(realBase);
+    if (!key.inPlace) fftwf_free(complexBase);
+    return plan;
+}
+
+fftwf_plan FFTPlanCache::getPlan(const PlanKey& key) {
+    // The FFTW planner is not thread-safe, so planning happens under the lock
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = plans.find(key);
+    if (it != plans.end()) {
+        countEvent(Counter::PLAN_CACHE_HITS);
+        return it->second;
+    }
+
+    countEvent(Counter::PLAN_CACHE_MISSES);
+    fftwf_plan plan = createPlan(key);
+    if (plan) {
+        plans.emplace(key, plan);
+    }
+    return plan;
+}
+
+fftwf_plan FFTPlanCache::getForwardPlan(int rank, const int* dims, float* in, fftwf_complex* out, unsigned flags) {
+    return getForwardPlan(rank, dims, denseLayout(rank, dims, FFTDirection::FORWARD), in, out, flags);
+}
+
+fftwf_plan FFTPlanCache::getInversePlan(int rank, const int* dims, fftwf_complex* in, float* out, unsigned flags) {
+    return getInversePlan(rank, dims, denseLayout(rank, dims, FFTDirection::INVERSE), in, out, flags);
+}
+
+fftwf_plan FFTPlanCache::getForwardPlan(int rank, const int* dims, const PlanLayout& layout,
+                                        float* in, fftwf_complex* out, unsigned flags) {
+    PlanKey key{rank, {dims[0], rank > 1 ? dims[1] : 1}, layout,
+                static_cast<void*>(in) == static_cast<void*>(out), FFTDirection::FORWARD, flags,
+                fftwf_alignment_of(in), fftwf_alignment_of(reinterpret_cast<float*>(out)), 1};
+    key.threads = fftThreads(static_cast<double>(layout.howmany) * key.dims[0] * key.dims[1]);
+    return getPlan(key);
+}
+
+fftwf_plan FFTPlanCache::getInversePlan(int rank, const int* dims, const PlanLayout& layout,
+                                        fftwf_complex* in, float* out, unsigned flags) {
+    PlanKey key{rank, {dims[0], rank > 1 ? dims[1] : 1}, layout,
+                static_cast<void*>(in) == static_cast<void*>(out), FFTDirection::INVERSE, flags,
+                fftwf_alignment_of(reinterpret_cast<float*>(in)), fftwf_alignment_of(out), 1};
+    key.threads = fftThreads(static_cast<double>(layout.howmany) * key.dims[0] * key.dims[1]);
+    return getPlan(key);
+}
+
+std::size_t FFTPlanCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return plans.size();
 }
 
+void FFTPlanCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : plans) {
+        fftwf_destroy_plan(entry.second);
+    }
+    plans.clear();
+    clears.fetch_add(1, std::memory_order_release);
+}
+
+bool FFTPlanCache::importWisdom(const std::string& wisdom) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fftwf_import_wisdom_from_string(wisdom.c_str()) != 0;
+}
+
+bool FFTPlanCache::exportWisdom(std::string& wisdom) {
+    std::lock_guard<std::mutex> lock(mutex);
+    char* text = fftwf_export_wisdom_to_string();
+    if (!text) {
+        return false;
+    }
+    wisdom = text;
+    std::free(text);
+    return true;
+}
+
+void FFTPlanCache::forgetWisdom() {
+    std::lock_guard<std::mutex> lock(mutex);
+    fftwf_forget_wisdom();
+}
+
+// Constructor
+FFTWrapper::FFTWrapper() = default;
+
+// Destructor
+FFTWrapper::~FFTWrapper() = default;
+
 // ------------------- 1D FFT Implementation -------------------
 
 FFTStatus FFTWrapper::performFFT1D(const std::vector<float>& input, std::vector<std::complex<float>>& output, Flags flags) {
+    ScopedStage stage(Stage::FORWARD_FFT);
     int size = input.size();
     output.resize(size / 2 + 1);
 
-    forwardPlan1D = fftwf_plan_dft_r2c_1d(size, const_cast<float*>(input.data()),
-                                          reinterpret_cast<fftwf_complex*>(output.data()), static_cast<unsigned int>(flags));
+    float* in = const_cast<float*>(input.data());
+    fftwf_complex* out = reinterpret_cast<fftwf_complex*>(output.data());
+    fftwf_plan plan = FFTPlanCache::instance().getForwardPlan(1, &size, in, out, static_cast<unsigned int>(flags));
 
-    if (!forwardPlan1D) {
+    if (!plan) {
         return FFTStatus::FAILURE;
     }
 
-    fftwf_execute(forwardPlan1D);
+    fftwf_execute_dft_r2c(plan, in, out);
     return FFTStatus::SUCCESS;
 }
 
 FFTStatus FFTWrapper::performInverseFFT1D(const std::vector<std::complex<float>>& input, std::vector<float>& output, Flags flags) {
+    ScopedStage stage(Stage::INVERSE_FFT);
     int size = output.size();
 
-    inversePlan1D = fftwf_plan_dft_c2r_1d(size, reinterpret_cast<fftwf_complex*>(const_cast<std::complex<float>*>(input.data())), 
-                                          output.data(), static_cast<unsigned int>(flags));
+    // The input is const, so ask FFTW not to use it as scratch space
+    fftwf_complex* in = reinterpret_cast<fftwf_complex*>(const_cast<std::complex<float>*>(input.data()));
+    fftwf_plan plan = FFTPlanCache::instance().getInversePlan(1, &size, in, output.data(),
+                                                              static_cast<unsigned int>(flags) | FFTW_PRESERVE_INPUT);
 
-    if (!inversePlan1D) {
+    if (!plan) {
         return FFTStatus::FAILURE;
     }
 
-    fftwf_execute(inversePlan1D);
+    fftwf_execute_dft_c2r(plan, in, output.data());
 
     // Normalize the output
-    for (auto& val : output) {
-        val /= size;
-    }
+    scaledCopy(output.data(), output.data(), size, 1.0f / size);
 
     return FFTStatus::SUCCESS;
 }
@@ -58,76 +247,289 @@ FFTStatus FFTWrapper::performInverseFFT1D(const std::vector<std::complex<float>>
 // ------------------- 2D FFT Implementation -------------------
 
 FFTStatus FFTWrapper::performFFT2D(const std::vector<std::vector<float>>& input, std::vector<std::vector<std::complex<float>>>& output, Flags flags) {
+    ScopedStage stage(Stage::FORWARD_FFT);
     int rows = input.size();
     int cols = input[0].size();
 
-    output.resize(rows, std::vector<std::complex<float>>(cols / 2 + 1)); // Resize output for complex values
+    output.assign(rows, std::vector<std::complex<float>>(cols / 2 + 1)); // Resize output for complex values
 
-    // Create an intermediate 1D array for FFTW
-    std::vector<float> flatInput(rows * cols);
-    std::vector<std::complex<float>> flatOutput(rows * (cols / 2 + 1));
+    // Intermediate 1D arrays for FFTW, from the thread's workspace
+    WorkspaceFrame frame;
+    float* flatInput = frame.array<float>(static_cast<std::size_t>(rows) * cols);
+    std::complex<float>* flatOutput = frame.array<std::complex<float>>(static_cast<std::size_t>(rows) * (cols / 2 + 1));
 
     // Flatten the 2D input array to 1D
     for (int i = 0; i < rows; ++i) {
-        std::copy(input[i].begin(), input[i].end(), flatInput.begin() + i * cols);
+        std::copy(input[i].begin(), input[i].end(), flatInput + i * cols);
     }
 
-    // Create FFTW plans
-    forwardPlan2D = fftwf_plan_dft_r2c_2d(rows, cols, flatInput.data(),
-                                          reinterpret_cast<fftwf_complex*>(flatOutput.data()), static_cast<unsigned int>(flags));
+    // Fetch the FFTW plan
+    int dims[2] = {rows, cols};
+    fftwf_complex* out = reinterpret_cast<fftwf_complex*>(flatOutput);
+    fftwf_plan plan = FFTPlanCache::instance().getForwardPlan(2, dims, flatInput, out, static_cast<unsigned int>(flags));
 
-    if (!forwardPlan2D) {
+    if (!plan) {
         return FFTStatus::FAILURE;
     }
 
     // Execute FFT
-    fftwf_execute(forwardPlan2D);
+    fftwf_execute_dft_r2c(plan, flatInput, out);
 
     // Copy the results to the 2D output
     for (int i = 0; i < rows; ++i) {
-        std::copy(flatOutput.begin() + i * (cols / 2 + 1), flatOutput.begin() + (i + 1) * (cols / 2 + 1), output[i].begin());
+        std::copy(flatOutput + i * (cols / 2 + 1), flatOutput + (i + 1) * (cols / 2 + 1), output[i].begin());
     }
 
     return FFTStatus::SUCCESS;
 }
 
 FFTStatus FFTWrapper::performInverseFFT2D(const std::vector<std::vector<std::complex<float>>>& input, std::vector<std::vector<float>>& output, Flags flags) {
+    ScopedStage stage(Stage::INVERSE_FFT);
     int rows = input.size();
     int cols = input[0].size();
 
-    output.resize(rows, std::vector<float>(cols * 2)); // Resize output for real values
+    // The real width is ambiguous from a half spectrum; use the caller's output width if it matches
+    int realCols = 2 * (cols - 1);
+    if (!output.empty() && static_cast<int>(output[0].size()) / 2 + 1 == cols) {
+        realCols = output[0].size();
+    }
+
+    output.assign(rows, std::vector<float>(realCols)); // Resize output for real values
 
-    // Create an intermediate 1D array for FFTW
-    std::vector<std::complex<float>> flatInput(rows * (cols / 2 + 1));
-    std::vector<float> flatOutput(rows * cols * 2);
+    // Intermediate 1D arrays for FFTW, from the thread's workspace
+    WorkspaceFrame frame;
+    std::complex<float>* flatInput = frame.array<std::complex<float>>(static_cast<std::size_t>(rows) * cols);
+    float* flatOutput = frame.array<float>(static_cast<std::size_t>(rows) * realCols);
 
     // Flatten the 2D input array to 1D
     for (int i = 0; i < rows; ++i) {
-        std::copy(input[i].begin(), input[i].end(), flatInput.begin() + i * (cols / 2 + 1));
+        std::copy(input[i].begin(), input[i].end(), flatInput + i * cols);
     }
 
-    // Create FFTW plans
-    inversePlan2D = fftwf_plan_dft_c2r_2d(rows, cols * 2, reinterpret_cast<fftwf_complex*>(flatInput.data()),
-                                          flatOutput.data(), static_cast<unsigned int>(flags));
+    // Fetch the FFTW plan
+    int dims[2] = {rows, realCols};
+    fftwf_complex* in = reinterpret_cast<fftwf_complex*>(flatInput);
+    fftwf_plan plan = FFTPlanCache::instance().getInversePlan(2, dims, in, flatOutput, static_cast<unsigned int>(flags));
 
-    if (!inversePlan2D) {
+    if (!plan) {
         return FFTStatus::FAILURE;
     }
 
     // Execute inverse FFT
-    fftwf_execute(inversePlan2D);
+    fftwf_execute_dft_c2r(plan, in, flatOutput);
 
-    // Copy the results to the 2D output
+    // Copy the normalized results to the 2D output
+    float scale = 1.0f / (static_cast<float>(rows) * realCols);
     for (int i = 0; i < rows; ++i) {
-        std::copy(flatOutput.begin() + i * (cols * 2), flatOutput.begin() + (i + 1) * (cols * 2), output[i].begin());
+        scaledCopy(output[i].data(), flatOutput + i * realCols, realCols, scale);
     }
 
-    // Normalize the output
-    for (auto& row : output) {
-        for (auto& val : row) {
-            val /= (rows * cols);
+    return FFTStatus::SUCCESS;
+}
+
+// ------------------- Tensor FFT Implementation -------------------
+
+// One level of the transform loop nest: `count` transforms `inStride` /
+// `outStride` elements apart
+struct BatchLevel {
+    int count;
+    std::ptrdiff_t inStride;
+    std::ptrdiff_t outStride;
+};
+
+// Run `transform(layout, inOffset, outOffset)` over a loop nest of transforms
+// (innermost level first), folding as many levels as possible into the
+// advanced-interface howmany/dist of a single plan
+template <typename Transform>
+static FFTStatus forEachBatch(const std::vector<BatchLevel>& levels, PlanLayout layout, Transform transform) {
+    layout.howmany = 1;
+    layout.inDist = 0;
+    layout.outDist = 0;
+
+    size_t merged = 0;
+    for (; merged < levels.size(); ++merged) {
+        const BatchLevel& level = levels[merged];
+        if (level.count == 1) {
+            continue;
+        }
+        bool first = layout.howmany == 1;
+        bool contiguous = first || (level.inStride == static_cast<std::ptrdiff_t>(layout.howmany) * layout.inDist &&
+                                    level.outStride == static_cast<std::ptrdiff_t>(layout.howmany) * layout.outDist);
+        bool fits = level.inStride <= INT_MAX && level.outStride <= INT_MAX &&
+                    static_cast<long long>(layout.howmany) * level.count <= INT_MAX;
+        if (!contiguous || !fits) {
+            break;
+        }
+        if (first) {
+            layout.inDist = level.inStride;
+            layout.outDist = level.outStride;
+        }
+        layout.howmany *= level.count;
+    }
+
+    // Loop over whatever could not be merged
+    std::vector<int> index(levels.size(), 0);
+    while (true) {
+        std::ptrdiff_t inOffset = 0;
+        std::ptrdiff_t outOffset = 0;
+        for (size_t l = merged; l < levels.size(); ++l) {
+            inOffset += index[l] * levels[l].inStride;
+            outOffset += index[l] * levels[l].outStride;
+        }
+        if (transform(layout, inOffset, outOffset) != FFTStatus::SUCCESS) {
+            return FFTStatus::FAILURE;
+        }
+
+        size_t l = merged;
+        while (l < levels.size() && ++index[l] == levels[l].count) {
+            index[l++] = 0;
+        }
+        if (l == levels.size()) {
+            break;
         }
     }
 
     return FFTStatus::SUCCESS;
-}
\ No newline at end of file
+}
+
+// Scale every element of a real view by `scale`
+static void scaleView(const TensorView<float>& view, float scale) {
+    long rows = static_cast<long>(view.batch()) * view.channels() * view.rows();
+    int threads = parallelThreads(static_cast<double>(rows) * view.cols());
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (long r = 0; r < rows; ++r) {
+        int i = static_cast<int>(r % view.rows());
+        int image = static_cast<int>(r / view.rows());
+        float* row = view.row(image / view.channels(), image % view.channels(), i);
+        scaledCopy(row, row, view.cols(), scale);
+    }
+}
+
+template <typename In, typename Out>
+static bool sameBatchShape(const TensorView<In>& in, const TensorView<Out>& out) {
+    return in.batch() == out.batch() && in.channels() == out.channels() && in.rows() == out.rows();
+}
+
+static bool pitchFits(std::ptrdiff_t pitch) {
+    return pitch <= INT_MAX;
+}
+
+FFTStatus FFTWrapper::performFFT1D(const TensorView<const float>& input, const TensorView<std::complex<float>>& output, Flags flags) {
+    ScopedStage stage(Stage::FORWARD_FFT);
+    int n = input.cols();
+    if (input.empty() || !sameBatchShape(input, output) || output.cols() != n / 2 + 1) {
+        return FFTStatus::FAILURE;
+    }
+
+    std::vector<BatchLevel> levels = {
+        {input.rows(), input.rowStride(), output.rowStride()},
+        {input.channels(), input.channelStride(), output.channelStride()},
+        {input.batch(), input.batchStride(), output.batchStride()},
+    };
+    float* in = const_cast<float*>(input.data());
+    fftwf_complex* out = reinterpret_cast<fftwf_complex*>(output.data());
+
+    return forEachBatch(levels, PlanLayout{1, n, 0, n / 2 + 1, 0},
+                        [&](const PlanLayout& layout, std::ptrdiff_t inOffset, std::ptrdiff_t outOffset) {
+        fftwf_plan plan = FFTPlanCache::instance().getForwardPlan(1, &n, layout, in + inOffset, out + outOffset,
+                                                                  static_cast<unsigned int>(flags));
+        if (!plan) {
+            return FFTStatus::FAILURE;
+        }
+        fftwf_execute_dft_r2c(plan, in + inOffset, out + outOffset);
+        return FFTStatus::SUCCESS;
+    });
+}
+
+FFTStatus FFTWrapper::performInverseFFT1D(const TensorView<std::complex<float>>& input, const TensorView<float>& output, Flags flags,
+                                          bool normalize) {
+    ScopedStage stage(Stage::INVERSE_FFT);
+    int n = output.cols();
+    if (output.empty() || !sameBatchShape(input, output) || input.cols() != n / 2 + 1) {
+        return FFTStatus::FAILURE;
+    }
+
+    std::vector<BatchLevel> levels = {
+        {input.rows(), input.rowStride(), output.rowStride()},
+        {input.channels(), input.channelStride(), output.channelStride()},
+        {input.batch(), input.batchStride(), output.batchStride()},
+    };
+    fftwf_complex* in = reinterpret_cast<fftwf_complex*>(input.data());
+    float* out = output.data();
+
+    FFTStatus status = forEachBatch(levels, PlanLayout{1, n / 2 + 1, 0, n, 0},
+                                    [&](const PlanLayout& layout, std::ptrdiff_t inOffset, std::ptrdiff_t outOffset) {
+        fftwf_plan plan = FFTPlanCache::instance().getInversePlan(1, &n, layout, in + inOffset, out + outOffset,
+                                                                  static_cast<unsigned int>(flags));
+        if (!plan) {
+            return FFTStatus::FAILURE;
+        }
+        fftwf_execute_dft_c2r(plan, in + inOffset, out + outOffset);
+        return FFTStatus::SUCCESS;
+    });
+
+    if (status == FFTStatus::SUCCESS && normalize) {
+        scaleView(output, 1.0f / n);
+    }
+    return status;
+}
+
+FFTStatus FFTWrapper::performFFT2D(const TensorView<const float>& input, const TensorView<std::complex<float>>& output, Flags flags) {
+    ScopedStage stage(Stage::FORWARD_FFT);
+    int dims[2] = {input.rows(), input.cols()};
+    if (input.empty() || !sameBatchShape(input, output) || output.cols() != dims[1] / 2 + 1 ||
+        !pitchFits(input.rowStride()) || !pitchFits(output.rowStride())) {
+        return FFTStatus::FAILURE;
+    }
+
+    std::vector<BatchLevel> levels = {
+        {input.channels(), input.channelStride(), output.channelStride()},
+        {input.batch(), input.batchStride(), output.batchStride()},
+    };
+    float* in = const_cast<float*>(input.data());
+    fftwf_complex* out = reinterpret_cast<fftwf_complex*>(output.data());
+    PlanLayout pitches{1, static_cast<int>(input.rowStride()), 0, static_cast<int>(output.rowStride()), 0};
+
+    return forEachBatch(levels, pitches, [&](const PlanLayout& layout, std::ptrdiff_t inOffset, std::ptrdiff_t outOffset) {
+        fftwf_plan plan = FFTPlanCache::instance().getForwardPlan(2, dims, layout, in + inOffset, out + outOffset,
+                                                                  static_cast<unsigned int>(flags));
+        if (!plan) {
+            return FFTStatus::FAILURE;
+        }
+        fftwf_execute_dft_r2c(plan, in + inOffset, out + outOffset);
+        return FFTStatus::SUCCESS;
+    });
+}
+
+FFTStatus FFTWrapper::performInverseFFT2D(const TensorView<std::complex<float>>& input, const TensorView<float>& output, Flags flags,
+                                          bool normalize) {
+    ScopedStage stage(Stage::INVERSE_FFT);
+    int dims[2] = {output.rows(), output.cols()};
+    if (output.empty() || !sameBatchShape(input, output) || input.cols() != dims[1] / 2 + 1 ||
+        !pitchFits(input.rowStride()) || !pitchFits(output.rowStride())) {
+        return FFTStatus::FAILURE;
+    }
+
+    std::vector<BatchLevel> levels = {
+        {input.channels(), input.channelStride(), output.channelStride()},
+        {input.batch(), input.batchStride(), output.batchStride()},
+    };
+    fftwf_complex* in = reinterpret_cast<fftwf_complex*>(input.data());
+    float* out = output.data();
+    PlanLayout pitches{1, static_cast<int>(input.rowStride()), 0, static_cast<int>(output.rowStride()), 0};
+
+    FFTStatus status = forEachBatch(levels, pitches, [&](const PlanLayout& layout, std::ptrdiff_t inOffset, std::ptrdiff_t outOffset) {
+        fftwf_plan plan = FFTPlanCache::instance().getInversePlan(2, dims, layout, in + inOffset, out + outOffset,
+                                                                  static_cast<unsigned int>(flags));
+        if (!plan) {
+            return FFTStatus::FAILURE;
+        }
+        fftwf_execute_dft_c2r(plan, in + inOffset, out + outOffset);
+        return FFTStatus::SUCCESS;
+    });
+
+    if (status == FFTStatus::SUCCESS && normalize) {
+        scaleView(output, 1.0f / (static_cast<float>(dims[0]) * dims[1]));
+    }
+    return status;
+}
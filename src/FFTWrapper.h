@@ -2,26 +2,121 @@
 #define FFTWRAPPER_H
 
 #include <fftw3.h>
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <complex>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Tensor.h"
 
 enum class Flags {
     ESTIMATE = FFTW_ESTIMATE,
-    MEASURE = FFTW_MEASURE
+    MEASURE = FFTW_MEASURE,
+    PATIENT = FFTW_PATIENT,
+    WISDOM_ONLY = FFTW_WISDOM_ONLY  // only create plans for which wisdom is available
 };
 
+// Combine planner flags, e.g. Flags::PATIENT | Flags::WISDOM_ONLY
+inline Flags operator|(Flags a, Flags b) {
+    return static_cast<Flags>(static_cast<unsigned int>(a) | static_cast<unsigned int>(b));
+}
+
 enum class FFTStatus {
     SUCCESS,
     FAILURE
 };
 
-class FFTWrapper {
+enum class FFTDirection {
+    FORWARD,  // real to complex
+    INVERSE   // complex to real
+};
+
+// Memory layout of a batch of transforms in FFTW's advanced-interface terms:
+// `howmany` transforms, rows `pitch` elements apart (last dimension is
+// contiguous) and consecutive transforms `dist` elements apart.
+struct PlanLayout {
+    int howmany;
+    int inPitch;
+    int inDist;
+    int outPitch;
+    int outDist;
+};
+
+// Geometry of a cached plan. FFTW plans may only be re-executed on arrays
+// with the same SIMD alignment and in-place-ness as the ones they were
+// created with, so those are part of the key, as is the number of threads
+// the plan was created for.
+struct PlanKey {
+    int rank;
+    int dims[2];
+    PlanLayout layout;
+    bool inPlace;
+    FFTDirection direction;
+    unsigned flags;
+    int inAlignment;
+    int outAlignment;
+    int threads;
+
+    bool operator==(const PlanKey& other) const;
+};
+
+struct PlanKeyHash {
+    std::size_t operator()(const PlanKey& key) const;
+};
+
+// Process-wide, thread-safe cache of FFTW plans. Plans are created once per
+// geometry on private scratch buffers (so MEASURE never clobbers caller data)
+// and executed through the new-array interface on whatever buffers the caller
+// passes in.
+class FFTPlanCache {
 private:
-    fftwf_plan forwardPlan1D;
-    fftwf_plan inversePlan1D;
-    fftwf_plan forwardPlan2D;
-    fftwf_plan inversePlan2D;
+    std::unordered_map<PlanKey, fftwf_plan, PlanKeyHash> plans;
+    mutable std::mutex mutex;
+    std::atomic<std::uint64_t> clears{0};
+
+    FFTPlanCache() = default;
+    fftwf_plan createPlan(const PlanKey& key);
+    fftwf_plan getPlan(const PlanKey& key);
 
+public:
+    ~FFTPlanCache();
+    FFTPlanCache(const FFTPlanCache&) = delete;
+    FFTPlanCache& operator=(const FFTPlanCache&) = delete;
+
+    static FFTPlanCache& instance();
+
+    // Look up (or create) a plan for a single densely packed real-to-complex transform
+    fftwf_plan getForwardPlan(int rank, const int* dims, float* in, fftwf_complex* out, unsigned flags);
+
+    // Look up (or create) a plan for a single densely packed complex-to-real transform
+    fftwf_plan getInversePlan(int rank, const int* dims, fftwf_complex* in, float* out, unsigned flags);
+
+    // Same, for a batch of transforms with an explicit layout
+    fftwf_plan getForwardPlan(int rank, const int* dims, const PlanLayout& layout, float* in, fftwf_complex* out, unsigned flags);
+    fftwf_plan getInversePlan(int rank, const int* dims, const PlanLayout& layout, fftwf_complex* in, float* out, unsigned flags);
+
+    // Number of cached plans
+    std::size_t size() const;
+
+    // Destroy every cached plan
+    void clear();
+
+    // Bumped by clear(): callers that keep plans between calls look them
+    // up again when it changes, without taking the lock on every call
+    std::uint64_t generation() const { return clears.load(std::memory_order_acquire); }
+
+    // FFTW wisdom shares the planner's state, so it is read and written
+    // under the same lock as planning. importWisdom returns false if FFTW
+    // rejects the text; exportWisdom leaves `wisdom` alone on failure.
+    bool importWisdom(const std::string& wisdom);
+    bool exportWisdom(std::string& wisdom);
+    void forgetWisdom();
+};
+
+class FFTWrapper {
 public:
     FFTWrapper();
     ~FFTWrapper();
@@ -37,6 +132,27 @@ public:
 
     // Perform 2D Inverse FFT (Complex to Real)
     FFTStatus performInverseFFT2D(const std::vector<std::vector<std::complex<float>>>& input, std::vector<std::vector<float>>& output, Flags flags);
+
+    // Tensor overloads run FFTW directly on the views' memory, with no
+    // staging copies. Spectra are rows x (cols / 2 + 1); input and output may
+    // alias for an in-place transform if the real rows are padded to
+    // 2 * (cols / 2 + 1) floats. Inverse transforms use their input as
+    // scratch space and are normalized, unless `normalize` is false for a
+    // caller that folded the 1/N into its spectrum multiply.
+
+    // Perform 1D FFT along every row (Real to Complex)
+    FFTStatus performFFT1D(const TensorView<const float>& input, const TensorView<std::complex<float>>& output, Flags flags);
+
+    // Perform 1D Inverse FFT along every row (Complex to Real)
+    FFTStatus performInverseFFT1D(const TensorView<std::complex<float>>& input, const TensorView<float>& output, Flags flags,
+                                  bool normalize = true);
+
+    // Perform 2D FFT on every image (Real to Complex)
+    FFTStatus performFFT2D(const TensorView<const float>& input, const TensorView<std::complex<float>>& output, Flags flags);
+
+    // Perform 2D Inverse FFT on every image (Complex to Real)
+    FFTStatus performInverseFFT2D(const TensorView<std::complex<float>>& input, const TensorView<float>& output, Flags flags,
+                                  bool normalize = true);
 };
 
 #endif  // FFTWRAPPER_H
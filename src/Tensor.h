@@ -0,0 +1,160 @@
+#ifndef TENSOR_H
+#define TENSOR_H
+
+#include <fftw3.h>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include "instrumentation.h"
+
+// Non-owning, strided view over a [batch][channels][rows][cols] block of
+// elements. Columns are always contiguous; rows, channels and batch items
+// may be separated by arbitrary strides (in elements), so a view can wrap
+// caller memory such as a numpy array, a sub-image or a row-padded buffer.
+template <typename T>
+class TensorView {
+private:
+    T* ptr;
+    int nRows;
+    int nCols;
+    int nChannels;
+    int nBatch;
+    std::ptrdiff_t rowPitch;
+    std::ptrdiff_t channelPitch;
+    std::ptrdiff_t batchPitch;
+
+public:
+    TensorView()
+        : ptr(nullptr), nRows(0), nCols(0), nChannels(0), nBatch(0), rowPitch(0), channelPitch(0), batchPitch(0) {}
+
+    // Densely packed view
+    TensorView(T* data, int rows, int cols, int channels = 1, int batch = 1)
+        : TensorView(data, rows, cols, channels, batch, cols,
+                     static_cast<std::ptrdiff_t>(rows) * cols,
+                     static_cast<std::ptrdiff_t>(rows) * cols * channels) {}
+
+    // Strided view; strides are in elements
+    TensorView(T* data, int rows, int cols, int channels, int batch,
+               std::ptrdiff_t rowStride, std::ptrdiff_t channelStride, std::ptrdiff_t batchStride)
+        : ptr(data), nRows(rows), nCols(cols), nChannels(channels), nBatch(batch),
+          rowPitch(rowStride), channelPitch(channelStride), batchPitch(batchStride) {
+        if (rows < 0 || cols < 0 || channels < 0 || batch < 0 || rowStride < cols) {
+            throw std::invalid_argument("Invalid tensor shape or strides");
+        }
+    }
+
+    // Views of non-const data convert to views of const data
+    template <typename U>
+    TensorView(const TensorView<U>& other)
+        : TensorView(other.data(), other.rows(), other.cols(), other.channels(), other.batch(),
+                     other.rowStride(), other.channelStride(), other.batchStride()) {}
+
+    T* data() const { return ptr; }
+    int rows() const { return nRows; }
+    int cols() const { return nCols; }
+    int channels() const { return nChannels; }
+    int batch() const { return nBatch; }
+    std::ptrdiff_t rowStride() const { return rowPitch; }
+    std::ptrdiff_t channelStride() const { return channelPitch; }
+    std::ptrdiff_t batchStride() const { return batchPitch; }
+    bool empty() const { return nRows == 0 || nCols == 0 || nChannels == 0 || nBatch == 0; }
+
+    T* row(int b, int c, int i) const {
+        return ptr + b * batchPitch + c * channelPitch + i * rowPitch;
+    }
+
+    T& operator()(int b, int c, int i, int j) const {
+        return row(b, c, i)[j];
+    }
+
+    // Single-image access for views with one batch item and one channel
+    T& operator()(int i, int j) const {
+        return ptr[i * rowPitch + j];
+    }
+
+    // View of one rows x cols image
+    TensorView image(int b, int c) const {
+        return TensorView(row(b, c, 0), nRows, nCols, 1, 1, rowPitch, channelPitch, batchPitch);
+    }
+
+    // View of a rectangular window of every image
+    TensorView window(int top, int left, int rows, int cols) const {
+        if (top < 0 || left < 0 || top + rows > nRows || left + cols > nCols) {
+            throw std::out_of_range("Tensor window out of range");
+        }
+        return TensorView(ptr + top * rowPitch + left, rows, cols, nChannels, nBatch,
+                          rowPitch, channelPitch, batchPitch);
+    }
+
+    // True when every image is a dense rows x cols block
+    bool rowsContiguous() const {
+        return rowPitch == nCols;
+    }
+};
+
+// Owning tensor backed by fftwf_malloc, so the base pointer has the SIMD
+// alignment FFTW expects. Rows may be padded to a wider pitch (e.g. the
+// 2 * (cols / 2 + 1) floats needed for an in-place real-to-complex FFT).
+template <typename T>
+class Tensor {
+private:
+    T* ptr;
+    TensorView<T> fullView;
+
+public:
+    Tensor() : ptr(nullptr) {}
+
+    Tensor(int rows, int cols, int channels = 1, int batch = 1)
+        : Tensor(rows, cols, channels, batch, cols) {}
+
+    Tensor(int rows, int cols, int channels, int batch, int rowPitch) : ptr(nullptr) {
+        std::ptrdiff_t channelPitch = static_cast<std::ptrdiff_t>(rows) * rowPitch;
+        std::size_t count = static_cast<std::size_t>(channelPitch) * channels * batch;
+        ptr = static_cast<T*>(fftwf_malloc(count * sizeof(T)));
+        if (!ptr && count > 0) {
+            throw std::bad_alloc();
+        }
+        countAllocation(count * sizeof(T));
+        for (std::size_t i = 0; i < count; ++i) {
+            new (ptr + i) T();
+        }
+        fullView = TensorView<T>(ptr, rows, cols, channels, batch, rowPitch, channelPitch, channelPitch * channels);
+    }
+
+    ~Tensor() {
+        fftwf_free(ptr);
+    }
+
+    Tensor(const Tensor&) = delete;
+    Tensor& operator=(const Tensor&) = delete;
+
+    Tensor(Tensor&& other) noexcept : ptr(other.ptr), fullView(other.fullView) {
+        other.ptr = nullptr;
+        other.fullView = TensorView<T>();
+    }
+
+    Tensor& operator=(Tensor&& other) noexcept {
+        if (this != &other) {
+            fftwf_free(ptr);
+            ptr = other.ptr;
+            fullView = other.fullView;
+            other.ptr = nullptr;
+            other.fullView = TensorView<T>();
+        }
+        return *this;
+    }
+
+    const TensorView<T>& view() const { return fullView; }
+    operator TensorView<T>() const { return fullView; }
+    operator TensorView<const T>() const { return fullView; }
+
+    T* data() const { return ptr; }
+    int rows() const { return fullView.rows(); }
+    int cols() const { return fullView.cols(); }
+    int channels() const { return fullView.channels(); }
+    int batch() const { return fullView.batch(); }
+    T& operator()(int i, int j) const { return fullView(i, j); }
+    T& operator()(int b, int c, int i, int j) const { return fullView(b, c, i, j); }
+};
+
+#endif  // TENSOR_H
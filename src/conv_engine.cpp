@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include "conv_engine.h"
+#include "convolution.h"
+#include "direct_convolution.h"
+#include "direct_kernels.h"
+#include "parallel.h"
+#include "fft_convolution.h"
+#include "separable_convolution.h"
+#include "tiled_convolution.h"
+#include "winograd.h"
+
+static const char* COST_MODEL_MAGIC = "kernel-flow-costmodel";
+static const int COST_MODEL_VERSION = 3;
+
+static std::atomic<ConvAlgorithm> conv_algorithm{ConvAlgorithm::AUTO};
+static std::atomic<std::size_t> fft_memory_limit{static_cast<std::size_t>(512) << 20};
+static std::mutex cost_model_mutex;
+static CostModel cost_model;
+
+void setConvAlgorithm(ConvAlgorithm algorithm) {
+    conv_algorithm.store(algorithm);
+}
+
+ConvAlgorithm getConvAlgorithm() {
+    return conv_algorithm.load();
+}
+
+void setFFTMemoryLimit(std::size_t bytes) {
+    fft_memory_limit.store(bytes);
+}
+
+std::size_t getFFTMemoryLimit() {
+    return fft_memory_limit.load();
+}
+
+void setCostModel(const CostModel& model) {
+    std::lock_guard<std::mutex> lock(cost_model_mutex);
+    cost_model = model;
+}
+
+CostModel getCostModel() {
+    std::lock_guard<std::mutex> lock(cost_model_mutex);
+    return cost_model;
+}
+
+// ------------------- Cost Model -------------------
+
+static bool winogradSupported(const ConvProblem& problem) {
+    return problem.kernel_rows == 3 && problem.kernel_cols == 3;
+}
+
+// Staging buffers of the whole-image FFT backend at the full transform
+// size, rows padded for in-place spectra: every input and filter, plus the
+// accumulated outputs of a layer (single kernels crop from the input)
+static double fftWorkingSet(const ConvProblem& problem) {
+    double rows = fftConvolutionSize(problem.rows, problem.kernel_rows, problem.padding);
+    double pitch = 2 * (fftConvolutionSize(problem.cols, problem.kernel_cols, problem.padding) / 2 + 1);
+    double filters = static_cast<double>(problem.in_channels) * problem.out_channels;
+    double spectra = static_cast<double>(problem.images) * problem.in_channels + filters;
+    if (filters > 1) {
+        spectra += static_cast<double>(problem.images) * problem.out_channels;
+    }
+    return rows * pitch * sizeof(float) * spectra;
+}
+
+// Cost of the spectral path over `repeats` transforms (tiles) of `points`
+// each per image
+static double spectralCost(const CostModel& model, const ConvProblem& problem, double points, double repeats) {
+    double in_channels = problem.in_channels;
+    double out_channels = problem.out_channels;
+    double threads = std::max(problem.threads, 1);
+    // A forward transform per input, an inverse per output and one per filter
+    double transforms = repeats * problem.images * (in_channels + out_channels) + in_channels * out_channels;
+    double speedup = 1 + (threads - 1) * model.fft_parallel_efficiency;
+    return (model.fft_per_point_log * points * std::log2(std::max(points, 2.0)) * transforms +
+            model.fft_per_point * points * repeats * problem.images * in_channels * out_channels) / speedup;
+}
+
+// Polyphase transform extent along one axis of a strided FFT convolution
+static double polyphaseSize(int size, int kernel_size, Padding padding, int stride) {
+    int padded = convolutionOutputSize(size, kernel_size, padding) + kernel_size - 1;
+    return nextSmoothSize((padded + stride - 1) / stride + (kernel_size + stride - 1) / stride);
+}
+
+static double costWith(const CostModel& model, const ConvProblem& problem, ConvAlgorithm algorithm) {
+    int stride = std::max(problem.stride, 1);
+    double output_pixels = static_cast<double>(convolutionOutputSize(problem.rows, problem.kernel_rows, problem.padding, stride)) *
+                           convolutionOutputSize(problem.cols, problem.kernel_cols, problem.padding, stride) * problem.images;
+    double threads = std::max(problem.threads, 1);
+    double in_channels = problem.in_channels;
+    double out_channels = problem.out_channels;
+
+    if (algorithm == ConvAlgorithm::DIRECT) {
+        bool fixed = stride == 1 && fixedDirectKernel(problem.kernel_rows, problem.kernel_cols) != nullptr;
+        return (fixed ? model.direct_fixed_per_mac : model.direct_per_mac) * output_pixels * problem.kernel_rows * problem.kernel_cols *
+               in_channels * out_channels / threads;
+    } else if (algorithm == ConvAlgorithm::SEPARABLE) {
+        if (problem.kernel_rank <= 0 || stride > 1 || in_channels * out_channels > 1) {
+            return -1;
+        }
+        // A row pass over the padded rows and a column pass per term
+        return model.direct_per_mac * output_pixels * problem.kernel_rank *
+               (problem.kernel_rows + problem.kernel_cols) / threads;
+    } else if (algorithm == ConvAlgorithm::WINOGRAD) {
+        if (!winogradSupported(problem) || stride > 1) {
+            return -1;
+        }
+        // Tile transforms per input and output channel, products per channel pair
+        int output_rows = convolutionOutputSize(problem.rows, 3, problem.padding);
+        int output_cols = convolutionOutputSize(problem.cols, 3, problem.padding);
+        double products_per_output = defaultWinogradVariant(output_rows, output_cols) == WinogradVariant::F4x4_3x3
+                                         ? 36.0 / 16 : 16.0 / 4;
+        return output_pixels * (model.winograd_per_transform * (in_channels + out_channels) +
+                                model.winograd_per_mac * products_per_output * in_channels * out_channels) / threads;
+    } else if (algorithm == ConvAlgorithm::FFT) {
+        if (fftWorkingSet(problem) > static_cast<double>(getFFTMemoryLimit())) {
+            return -1;
+        }
+        if (stride > 1) {
+            // stride^2 smaller transforms per image and kernel, one inverse per image
+            double phases = static_cast<double>(std::min(stride, problem.kernel_rows)) * std::min(stride, problem.kernel_cols);
+            double points = polyphaseSize(problem.rows, problem.kernel_rows, problem.padding, stride) *
+                            polyphaseSize(problem.cols, problem.kernel_cols, problem.padding, stride);
+            double speedup = 1 + (std::max(problem.threads, 1) - 1) * model.fft_parallel_efficiency;
+            double transforms = problem.images * (phases + 1) + phases;
+            return (model.fft_per_point_log * points * std::log2(std::max(points, 2.0)) * transforms +
+                    model.fft_per_point * points * problem.images * phases) / speedup;
+        }
+        double points = static_cast<double>(fftConvolutionSize(problem.rows, problem.kernel_rows, problem.padding)) *
+                        fftConvolutionSize(problem.cols, problem.kernel_cols, problem.padding);
+        return spectralCost(model, problem, points, 1);
+    } else if (algorithm == ConvAlgorithm::TILED_FFT) {
+        if (stride > 1) {
+            return -1;
+        }
+        int output_rows = convolutionOutputSize(problem.rows, problem.kernel_rows, problem.padding);
+        int output_cols = convolutionOutputSize(problem.cols, problem.kernel_cols, problem.padding);
+        int tile_size = std::max(defaultTileSize(problem.kernel_rows), defaultTileSize(problem.kernel_cols));
+        int fft_rows = tileFFTSize(std::min(tile_size, output_rows), problem.kernel_rows);
+        int fft_cols = tileFFTSize(std::min(tile_size, output_cols), problem.kernel_cols);
+        double tiles = std::ceil(static_cast<double>(output_rows) / (fft_rows - problem.kernel_rows + 1)) *
+                       std::ceil(static_cast<double>(output_cols) / (fft_cols - problem.kernel_cols + 1));
+        return spectralCost(model, problem, static_cast<double>(fft_rows) * fft_cols, tiles);
+    }
+    return -1;
+}
+
+double estimateCost(const ConvProblem& problem, ConvAlgorithm algorithm) {
+    return costWith(getCostModel(), problem, algorithm);
+}
+
+static ConvAlgorithm selectWith(const CostModel& model, const ConvProblem& problem) {
+    ConvAlgorithm best = ConvAlgorithm::FFT;
+    double best_cost = costWith(model, problem, ConvAlgorithm::FFT);
+    if (best_cost < 0) {
+        // The whole-image spectra would not fit in memory
+        best = ConvAlgorithm::TILED_FFT;
+        best_cost = costWith(model, problem, ConvAlgorithm::TILED_FFT);
+    }
+    for (ConvAlgorithm candidate : {ConvAlgorithm::DIRECT, ConvAlgorithm::WINOGRAD, ConvAlgorithm::SEPARABLE}) {
+        double cost = costWith(model, problem, candidate);
+        if (cost >= 0 && cost < best_cost) {
+            best = candidate;
+            best_cost = cost;
+        }
+    }
+    return best;
+}
+
+ConvAlgorithm selectAlgorithm(const ConvProblem& problem) {
+    return selectWith(getCostModel(), problem);
+}
+
+// Most rank-1 terms a kernel can have for SEPARABLE to still beat every
+// other backend on `problem`; 0 when even a rank-1 kernel loses, so large
+// kernels, which the spectral paths are for, are never decomposed
+static int separableBreakEvenRank(const CostModel& model, ConvProblem problem) {
+    problem.kernel_rank = 0;
+    double other = costWith(model, problem, selectWith(model, problem));
+    int limit = std::min(problem.kernel_rows, problem.kernel_cols);
+    int rank = 0;
+    while (rank < limit) {
+        problem.kernel_rank = rank + 1;
+        double cost = costWith(model, problem, ConvAlgorithm::SEPARABLE);
+        if (cost < 0 || cost >= other) break;
+        ++rank;
+    }
+    return rank;
+}
+
+// ------------------- Dispatch -------------------
+
+std::size_t convolutionWorkspaceSize(const ConvProblem& problem, ConvAlgorithm algorithm) {
+    if (algorithm == ConvAlgorithm::AUTO) {
+        algorithm = getConvAlgorithm();
+    }
+    if (algorithm == ConvAlgorithm::AUTO) {
+        algorithm = selectAlgorithm(problem);
+    }
+
+    // The same branches as dispatchConvolve2D
+    if (algorithm == ConvAlgorithm::SEPARABLE && problem.kernel_rank > 0 && problem.stride == 1) {
+        return separableConvolutionWorkspace(problem.rows, problem.cols, problem.kernel_rows, problem.kernel_cols,
+                                             problem.kernel_rank, problem.padding);
+    } else if (algorithm == ConvAlgorithm::DIRECT) {
+        return directConvolutionWorkspace(problem.rows, problem.cols, problem.kernel_rows, problem.kernel_cols,
+                                          problem.padding);
+    } else if (problem.stride > 1) {
+        return fftStridedConvolutionWorkspace(problem.rows, problem.cols, problem.kernel_rows, problem.kernel_cols,
+                                              problem.images, problem.padding, problem.stride, problem.stride);
+    } else if (algorithm == ConvAlgorithm::WINOGRAD && winogradSupported(problem)) {
+        int output_rows = convolutionOutputSize(problem.rows, 3, problem.padding);
+        int output_cols = convolutionOutputSize(problem.cols, 3, problem.padding);
+        return winogradConvolutionWorkspace(problem.rows, problem.cols, 1, 1, problem.padding,
+                                            defaultWinogradVariant(output_rows, output_cols));
+    } else if (algorithm == ConvAlgorithm::TILED_FFT) {
+        return tiledConvolutionWorkspace(problem.rows, problem.cols, problem.kernel_rows, problem.kernel_cols,
+                                         problem.padding);
+    }
+    return fftConvolutionWorkspace(problem.rows, problem.cols, problem.kernel_rows, problem.kernel_cols,
+                                   problem.images, problem.padding);
+}
+
+void dispatchConvolve2D(const TensorView<const float>& image,
+                        const TensorView<const float>& kernel,
+                        const TensorView<float>& output,
+                        Padding padding,
+                        float pad_val,
+                        ConvAlgorithm algorithm,
+                        int stride) {
+    if (algorithm == ConvAlgorithm::AUTO) {
+        algorithm = getConvAlgorithm();
+    }
+    if (stride < 1) {
+        throw std::invalid_argument("Stride must be positive");
+    }
+    ConvProblem problem{image.rows(), image.cols(), kernel.rows(), kernel.cols(),
+                        image.batch() * image.channels(), padding, getNumThreads(), 1, 1, stride};
+
+    // The rank of a genuinely 2D kernel decides whether two-pass execution
+    // pays. AUTO only decomposes kernels that could be cheap enough, and
+    // stops as soon as the rank is past break-even; decompositions are
+    // cached, so repeat calls neither run the SVD nor allocate.
+    CostModel model = getCostModel();
+    std::shared_ptr<const SeparableKernel> separable;
+    bool separable_candidate = kernel.rows() > 1 && kernel.cols() > 1 && stride == 1;
+    if (separable_candidate && algorithm == ConvAlgorithm::SEPARABLE) {
+        separable = cachedSeparableKernel(kernel, getSeparabilityTolerance());
+        problem.kernel_rank = separable->rank();
+    } else if (separable_candidate && algorithm == ConvAlgorithm::AUTO) {
+        int max_rank = separableBreakEvenRank(model, problem);
+        if (max_rank > 0) {
+            separable = cachedSeparableKernel(kernel, getSeparabilityTolerance(), max_rank);
+            problem.kernel_rank = separable->rank();
+        }
+    }
+    if (algorithm == ConvAlgorithm::AUTO) {
+        algorithm = selectWith(model, problem);
+    }
+
+    if (algorithm == ConvAlgorithm::SEPARABLE && problem.kernel_rank > 0) {
+        separableConvolve2D(image, *separable, output, padding, pad_val);
+    } else if (algorithm == ConvAlgorithm::DIRECT) {
+        directConvolve2D(image, kernel, output, padding, pad_val, stride);
+    } else if (stride > 1) {
+        // Strided problems have no Winograd or tiled path; the polyphase
+        // FFT already works on stride-times smaller transforms
+        if (algorithm != ConvAlgorithm::FFT && algorithm != ConvAlgorithm::TILED_FFT) {
+            throw std::invalid_argument("Convolution algorithm not available for this problem");
+        }
+        fftConvolveStrided2D(image, kernel, output, padding, pad_val, stride, stride, getPlanFlags());
+    } else if (algorithm == ConvAlgorithm::WINOGRAD && winogradSupported(problem)) {
+        winogradConvolve2D(image, kernel, output, padding, pad_val,
+                           defaultWinogradVariant(output.rows(), output.cols()));
+    } else if (algorithm == ConvAlgorithm::FFT) {
+        fftConvolve2D(image, kernel, output, padding, pad_val, getPlanFlags());
+    } else if (algorithm == ConvAlgorithm::TILED_FFT) {
+        tiledConvolve2D(image, kernel, output, padding, pad_val, getPlanFlags());
+    } else {
+        throw std::invalid_argument("Convolution algorithm not available for this problem");
+    }
+}
+
+// ------------------- Autotuning -------------------
+
+// Median wall time (ns) of `repeats` runs of a backend, after one warm-up
+// run so FFT planning is excluded. Runs on one thread: the coefficients are
+// per-core rates, and costWith() divides by problem.threads at dispatch.
+static double timeBackend(ConvAlgorithm algorithm, int size, int kernel_size, int repeats) {
+    ThreadLimit limit(1);
+    Tensor<float> image(size, size);
+    Tensor<float> kernel(kernel_size, kernel_size);
+    Tensor<float> output(size, size);
+    for (int i = 0; i < size; ++i)
+        for (int j = 0; j < size; ++j)
+            image(i, j) = static_cast<float>((i * 7 + j * 13) % 17);
+    for (int i = 0; i < kernel_size; ++i)
+        for (int j = 0; j < kernel_size; ++j)
+            kernel(i, j) = 1.0f / (kernel_size * kernel_size);
+
+    std::vector<double> times;
+    for (int r = 0; r <= repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        dispatchConvolve2D(image, kernel, output, Padding::ZERO, 0, algorithm);
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (r > 0) times.push_back(elapsed);
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+CostModel autotuneCostModel(int repeats) {
+    CostModel model = getCostModel();
+    const int size = 256;
+
+    // Each coefficient is the measured time divided by the work the model
+    // charges for it. 4x4 and 6x6 kernels run the generic direct loops,
+    // 3x3 and 5x5 fixed-size kernels (when the SIMD level has them).
+    std::vector<double> direct_rates;
+    for (int kernel_size : {4, 6, 3, 5}) {
+        ConvProblem problem{size, size, kernel_size, kernel_size, 1, Padding::ZERO, 1};
+        double predicted = costWith(model, problem, ConvAlgorithm::DIRECT);
+        direct_rates.push_back(timeBackend(ConvAlgorithm::DIRECT, size, kernel_size, repeats) / predicted);
+    }
+    model.direct_per_mac *= (direct_rates[0] + direct_rates[1]) / 2;
+    if (fixedDirectKernel(3, 3)) {
+        model.direct_fixed_per_mac *= (direct_rates[2] + direct_rates[3]) / 2;
+    } else {
+        model.direct_fixed_per_mac = model.direct_per_mac;
+    }
+
+    ConvProblem fft_problem{size, size, 7, 7, 1, Padding::ZERO, 1};
+    double fft_rate = timeBackend(ConvAlgorithm::FFT, size, 7, repeats) / costWith(model, fft_problem, ConvAlgorithm::FFT);
+    model.fft_per_point_log *= fft_rate;
+    model.fft_per_point *= fft_rate;
+
+    ConvProblem winograd_problem{size, size, 3, 3, 1, Padding::ZERO, 1};
+    double winograd_rate = timeBackend(ConvAlgorithm::WINOGRAD, size, 3, repeats) /
+                           costWith(model, winograd_problem, ConvAlgorithm::WINOGRAD);
+    model.winograd_per_transform *= winograd_rate;
+    model.winograd_per_mac *= winograd_rate;
+
+    setCostModel(model);
+    return model;
+}
+
+FFTStatus saveCostModel(const std::string& path) {
+    CostModel model = getCostModel();
+    std::ofstream file(path, std::ios::trunc);
+    file << COST_MODEL_MAGIC << " " << COST_MODEL_VERSION << "\n"
+         << "direct_per_mac " << model.direct_per_mac << "\n"
+         << "direct_fixed_per_mac " << model.direct_fixed_per_mac << "\n"
+         << "winograd_per_transform " << model.winograd_per_transform << "\n"
+         << "winograd_per_mac " << model.winograd_per_mac << "\n"
+         << "fft_per_point_log " << model.fft_per_point_log << "\n"
+         << "fft_per_point " << model.fft_per_point << "\n"
+         << "fft_parallel_efficiency " << model.fft_parallel_efficiency << "\n";
+    return file ? FFTStatus::SUCCESS : FFTStatus::FAILURE;
+}
+
+FFTStatus loadCostModel(const std::string& path) {
+    std::ifstream file(path);
+    std::string magic;
+    int version = 0;
+    if (!(file >> magic >> version) || magic != COST_MODEL_MAGIC || version != COST_MODEL_VERSION) {
+        return FFTStatus::FAILURE;
+    }
+
+    CostModel model = getCostModel();
+    std::string name;
+    double value = 0;
+    while (file >> name >> value) {
+        if (name == "direct_per_mac") model.direct_per_mac = value;
+        else if (name == "direct_fixed_per_mac") model.direct_fixed_per_mac = value;
+        else if (name == "winograd_per_transform") model.winograd_per_transform = value;
+        else if (name == "winograd_per_mac") model.winograd_per_mac = value;
+        else if (name == "fft_per_point_log") model.fft_per_point_log = value;
+        else if (name == "fft_per_point") model.fft_per_point = value;
+        else if (name == "fft_parallel_efficiency") model.fft_parallel_efficiency = value;
+        else return FFTStatus::FAILURE;
+    }
+    if (!file.eof()) {
+        return FFTStatus::FAILURE;
+    }
+
+    setCostModel(model);
+    return FFTStatus::SUCCESS;
+}
@@ -0,0 +1,91 @@
+#ifndef CONV_ENGINE_H
+#define CONV_ENGINE_H
+
+#include <cstddef>
+#include <string>
+#include "FFTWrapper.h"
+#include "Tensor.h"
+#include "padding.h"
+
+enum class ConvAlgorithm {
+    AUTO,      // pick per call from the cost model
+    DIRECT,    // spatial-domain multiply-add
+    WINOGRAD,  // minimal filtering, 3x3 kernels only
+    SEPARABLE, // row and column passes per rank-1 term of low-rank kernels
+    FFT,       // spectral convolution
+    TILED_FFT  // overlap-save spectral convolution in tiles, O(tile) memory
+};
+
+// Shape of one convolution call, as seen by the dispatcher
+struct ConvProblem {
+    int rows;
+    int cols;
+    int kernel_rows;
+    int kernel_cols;
+    int images;   // batch * channels
+    Padding padding;
+    int threads;
+    int in_channels = 1;   // channels summed into each output (layers)
+    int out_channels = 1;  // filters applied to each input (layers)
+    int stride = 1;        // every stride-th output row and column is kept
+    int kernel_rank = 0;   // rank-1 terms of the kernel, 0 if not known
+};
+
+// Per-unit costs (nanoseconds) of each backend. The defaults are rough
+// figures for a current x86 core; autotuneCostModel() measures them.
+struct CostModel {
+    double direct_per_mac = 0.3;          // per output pixel per kernel tap
+    double direct_fixed_per_mac = 0.1;    // the same, for sizes with a fixed-size kernel (direct_kernels.h)
+    double winograd_per_transform = 1.2;  // per output pixel per tile transform (3x3 kernels)
+    double winograd_per_mac = 0.3;        // per transformed point per channel pair
+    double fft_per_point_log = 0.25;      // per N log2 N of one real transform
+    double fft_per_point = 1.0;           // per spectrum point (staging, product, crop)
+    double fft_parallel_efficiency = 0.7; // fraction of ideal speedup FFTW gets from threads
+};
+
+// Algorithm used by convolve() (AUTO by default)
+void setConvAlgorithm(ConvAlgorithm algorithm);
+ConvAlgorithm getConvAlgorithm();
+
+// Largest working set (bytes) the whole-image FFT backend may allocate
+// before the dispatcher switches to tiles (512 MiB by default)
+void setFFTMemoryLimit(std::size_t bytes);
+std::size_t getFFTMemoryLimit();
+
+// Active cost model
+void setCostModel(const CostModel& model);
+CostModel getCostModel();
+
+// Predicted time (ns) of running `problem` with `algorithm`, or a negative
+// value when the backend cannot handle the problem
+double estimateCost(const ConvProblem& problem, ConvAlgorithm algorithm);
+
+// Cheapest supported backend for `problem` under the active cost model
+ConvAlgorithm selectAlgorithm(const ConvProblem& problem);
+
+// Calibrate the cost model by timing every backend on a few problems;
+// the result is installed as the active model and returned
+CostModel autotuneCostModel(int repeats = 3);
+
+// Persist or restore a calibrated model
+FFTStatus saveCostModel(const std::string& path);
+FFTStatus loadCostModel(const std::string& path);
+
+// Run a 2D convolution with the given (or automatically selected) backend.
+// With a stride, `output` has convolutionOutputSize(..., stride) rows and
+// cols and only the retained outputs are computed.
+void dispatchConvolve2D(const TensorView<const float>& image,
+                        const TensorView<const float>& kernel,
+                        const TensorView<float>& output,
+                        Padding padding,
+                        float pad_val,
+                        ConvAlgorithm algorithm = ConvAlgorithm::AUTO,
+                        int stride = 1);
+
+// Workspace bytes (see workspace.h) dispatchConvolve2D takes from the
+// calling thread's workspace for `problem` (whose kernel_rank should be
+// the one the dispatcher finds); reserve them to skip growing the workspace
+// on the first call. Tiled workers draw on their own threads' workspaces.
+std::size_t convolutionWorkspaceSize(const ConvProblem& problem, ConvAlgorithm algorithm = ConvAlgorithm::AUTO);
+
+#endif  // CONV_ENGINE_H
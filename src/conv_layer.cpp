@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <stdexcept>
+#include "conv_layer.h"
+#include "convolution.h"
+#include "direct_convolution.h"
+#include "parallel.h"
+#include "winograd.h"
+#include "workspace.h"
+
+ConvLayer::ConvLayer(const TensorView<const float>& filters,
+                     Padding padding,
+                     float pad_val,
+                     ConvAlgorithm algorithm)
+    : weights(filters.rows(), filters.cols(), filters.channels(), filters.batch()),
+      layerPadding(padding), padValue(pad_val), layerAlgorithm(algorithm) {
+    if (filters.empty()) {
+        throw std::invalid_argument("Filter bank must not be empty");
+    }
+    for (int k = 0; k < filters.batch(); ++k)
+        for (int c = 0; c < filters.channels(); ++c)
+            for (int i = 0; i < filters.rows(); ++i)
+                std::copy(filters.row(k, c, i), filters.row(k, c, i) + filters.cols(), weights.view().row(k, c, i));
+}
+
+ConvAlgorithm ConvLayer::algorithmFor(int rows, int cols, int batch) const {
+    ConvAlgorithm algorithm = layerAlgorithm == ConvAlgorithm::AUTO ? getConvAlgorithm() : layerAlgorithm;
+    if (algorithm == ConvAlgorithm::AUTO) {
+        algorithm = selectAlgorithm(ConvProblem{rows, cols, kernelRows(), kernelCols(), batch, layerPadding,
+                                                getNumThreads(), inChannels(), outChannels()});
+    }
+    // Layers have no tiled path; the FFT path splits the batch instead
+    return algorithm == ConvAlgorithm::TILED_FFT ? ConvAlgorithm::FFT : algorithm;
+}
+
+std::size_t ConvLayer::workspaceSize(int rows, int cols, int batch) const {
+    ConvAlgorithm algorithm = algorithmFor(rows, cols, batch);
+    int output_rows = outputRows(rows);
+    int output_cols = outputCols(cols);
+    if (algorithm == ConvAlgorithm::DIRECT) {
+        return workspaceTensorBytes(output_rows, output_cols) +
+               directConvolutionWorkspace(rows, cols, kernelRows(), kernelCols(), layerPadding);
+    }
+    if (algorithm == ConvAlgorithm::WINOGRAD) {
+        return winogradConvolutionWorkspace(rows, cols, inChannels(), outChannels(), layerPadding,
+                                            defaultWinogradVariant(output_rows, output_cols));
+    }
+    return fftLayerWorkspace(rows, cols, kernelRows(), kernelCols(), inChannels(), outChannels(),
+                             fftBatchChunk(rows, cols, batch), layerPadding);
+}
+
+void ConvLayer::forward(const TensorView<const float>& input, const TensorView<float>& output) {
+    if (input.channels() != inChannels()) {
+        throw std::invalid_argument("Input has the wrong number of channels");
+    }
+    if (output.rows() != outputRows(input.rows()) || output.cols() != outputCols(input.cols()) ||
+        output.channels() != outChannels() || output.batch() != input.batch()) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
+
+    ConvAlgorithm algorithm = algorithmFor(input.rows(), input.cols(), input.batch());
+    if (algorithm == ConvAlgorithm::DIRECT) {
+        forwardDirect(input, output);
+    } else if (algorithm == ConvAlgorithm::WINOGRAD && kernelRows() == 3 && kernelCols() == 3) {
+        winogradConvolveLayer(input, weights, output, layerPadding, padValue,
+                              defaultWinogradVariant(output.rows(), output.cols()));
+    } else if (algorithm == ConvAlgorithm::FFT) {
+        forwardFFT(input, output);
+    } else {
+        throw std::invalid_argument("Convolution algorithm not available for this problem");
+    }
+}
+
+// One direct convolution per channel pair, summed per output channel
+void ConvLayer::forwardDirect(const TensorView<const float>& input, const TensorView<float>& output) {
+    WorkspaceFrame frame;
+    TensorView<float> partial = frame.tensor(output.rows(), output.cols());
+    for (int b = 0; b < input.batch(); ++b) {
+        for (int k = 0; k < outChannels(); ++k) {
+            TensorView<float> out = output.image(b, k);
+            for (int c = 0; c < inChannels(); ++c) {
+                directConvolve2D(input.image(b, c), weights.view().image(k, c), c == 0 ? out : partial,
+                                 layerPadding, padValue);
+                if (c == 0) continue;
+                for (int i = 0; i < out.rows(); ++i) {
+                    float* dst = out.row(0, 0, i);
+                    const float* src = partial.row(0, 0, i);
+                    for (int j = 0; j < out.cols(); ++j) dst[j] += src[j];
+                }
+            }
+        }
+    }
+}
+
+// Split the batch so the staged input and output spectra stay within the
+// FFT memory limit (at least one image at a time)
+int ConvLayer::fftBatchChunk(int rows, int cols, int batch) const {
+    int fft_rows = fftConvolutionSize(rows, kernelRows(), layerPadding);
+    int fft_cols = fftConvolutionSize(cols, kernelCols(), layerPadding);
+    double spectrum_bytes = static_cast<double>(fft_rows) * 2 * (fft_cols / 2 + 1) * sizeof(float);
+    double per_image = spectrum_bytes * (inChannels() + outChannels());
+    double budget = static_cast<double>(getFFTMemoryLimit()) - spectrum_bytes * inChannels() * outChannels();
+    return static_cast<int>(std::min<double>(batch, std::max(1.0, budget / per_image)));
+}
+
+void ConvLayer::forwardFFT(const TensorView<const float>& input, const TensorView<float>& output) {
+    int fft_rows = fftConvolutionSize(input.rows(), kernelRows(), layerPadding);
+    int fft_cols = fftConvolutionSize(input.cols(), kernelCols(), layerPadding);
+    if (!spectra || spectra->fft_rows != fft_rows || spectra->fft_cols != fft_cols) {
+        spectra.reset(new FilterSpectra(fftTransformFilters(weights, input.rows(), input.cols(),
+                                                            layerPadding, getPlanFlags())));
+    }
+
+    int chunk = fftBatchChunk(input.rows(), input.cols(), input.batch());
+    for (int b = 0; b < input.batch(); b += chunk) {
+        int count = std::min(chunk, input.batch() - b);
+        TensorView<const float> in(input.row(b, 0, 0), input.rows(), input.cols(), input.channels(), count,
+                                   input.rowStride(), input.channelStride(), input.batchStride());
+        TensorView<float> out(output.row(b, 0, 0), output.rows(), output.cols(), output.channels(), count,
+                              output.rowStride(), output.channelStride(), output.batchStride());
+        fftConvolveLayer(in, *spectra, out, layerPadding, padValue, getPlanFlags());
+    }
+}
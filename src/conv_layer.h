@@ -0,0 +1,53 @@
+#ifndef CONV_LAYER_H
+#define CONV_LAYER_H
+
+#include <cstddef>
+#include <memory>
+#include "conv_engine.h"
+#include "fft_convolution.h"
+#include "Tensor.h"
+#include "padding.h"
+
+// A convolution layer: input [batch][in][rows][cols] convolved with a
+// filter bank [out][in][kh][kw] gives output [batch][out][...], where each
+// output channel is the sum over input channels of their 2D convolutions.
+// The backend is picked per call from the cost model (with the layer's
+// channel counts) unless one is forced. The filter bank is copied, and its
+// spectra are kept for reuse while the input extent stays the same.
+// forward() must not be called concurrently on one layer.
+class ConvLayer {
+private:
+    Tensor<float> weights;
+    Padding layerPadding;
+    float padValue;
+    ConvAlgorithm layerAlgorithm;
+    std::unique_ptr<FilterSpectra> spectra;  // for the last input extent
+
+    void forwardDirect(const TensorView<const float>& input, const TensorView<float>& output);
+    void forwardFFT(const TensorView<const float>& input, const TensorView<float>& output);
+    int fftBatchChunk(int rows, int cols, int batch) const;
+
+public:
+    ConvLayer(const TensorView<const float>& filters,
+              Padding padding,
+              float pad_val = 0.0,
+              ConvAlgorithm algorithm = ConvAlgorithm::AUTO);
+
+    int inChannels() const { return weights.channels(); }
+    int outChannels() const { return weights.batch(); }
+    int kernelRows() const { return weights.rows(); }
+    int kernelCols() const { return weights.cols(); }
+    int outputRows(int rows) const { return convolutionOutputSize(rows, kernelRows(), layerPadding); }
+    int outputCols(int cols) const { return convolutionOutputSize(cols, kernelCols(), layerPadding); }
+
+    // Backend forward() uses for a batch of `batch` rows x cols inputs
+    ConvAlgorithm algorithmFor(int rows, int cols, int batch) const;
+
+    // Workspace bytes (see workspace.h) forward() takes from the calling
+    // thread's workspace for a batch of `batch` rows x cols inputs
+    std::size_t workspaceSize(int rows, int cols, int batch) const;
+
+    void forward(const TensorView<const float>& input, const TensorView<float>& output);
+};
+
+#endif  // CONV_LAYER_H
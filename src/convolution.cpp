@@ -1,219 +1,86 @@
-#include <iostream>
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <complex>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <fftw3.h>
-#include "FFTWrapper.h"
-#include <iomanip>
+#include "convolution.h"
+#include "conv_engine.h"
+#include "direct_convolution.h"
+#include "fft_convolution.h"
+#include "parallel.h"
+#include "workspace.h"
 
-enum class Padding {
-    VALID,      // no padding
-    ZERO,       // pads the image or feature map with zeros
-    CONSTANT,   // pads with a user-specified constant
-    REPLICATE,  // pads by replicating the edge pixels of the image or feature map
-    REFLECT,    // pads by reflecting border pixels
-};
+static std::atomic<Flags> plan_flags{Flags::MEASURE};
 
-// 1D Padding function
-static void pad1D(const std::vector<float>& input,
-                  std::vector<float>& output,
-                  Padding padding,
-                  float pad_val = 0.0) {
-    int len = input.size();
-    int klen = output.size() - len;
-    int pad_left = klen / 2;
-    int pad_right = klen - pad_left;
-
-    // Copy input data
-    for (int i = 0; i < len; i++) output[pad_left + i] = input[i];
-
-    // Apply padding
-    if (padding == Padding::ZERO) {
-        std::fill(output.begin(), output.begin() + pad_left, 0);
-        std::fill(output.end() - pad_right, output.end(), 0);
-    } else if (padding == Padding::CONSTANT) {
-        std::fill(output.begin(), output.begin() + pad_left, pad_val);
-        std::fill(output.end() - pad_right, output.end(), pad_val);
-    } else if (padding == Padding::REPLICATE) {
-        std::fill(output.begin(), output.begin() + pad_left, input[0]);
-        std::fill(output.end() - pad_right, output.end(), input[len - 1]);
-    } else if (padding == Padding::REFLECT) {
-        for (int i = 0; i < pad_left; i++) output[i] = input[pad_left - i - 1];
-        for (int i = 0; i < pad_right; i++) output[output.size() - 1 - i] = input[len - pad_right + i];
-    } else {
-        throw std::invalid_argument("Unsupported padding type");
-    }
-}
-
-// 2D Padding function
-static void pad2D(const std::vector<std::vector<float>>& input, 
-                  std::vector<std::vector<float>>& output, 
-                  Padding padding, float pad_val = 0.0) {
-    int rows = input.size();
-    int cols = input[0].size();
-    int krows = output.size() - rows;
-    int kcols = output[0].size() - cols;
-    int pad_top = krows / 2;
-    int pad_left = kcols / 2;
-
-    // Copy input data
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            output[pad_top + i][pad_left + j] = input[i][j];
-        }
-    }
-
-    // Apply padding
-    if (padding == Padding::ZERO) {
-        for (std::vector<std::vector<float>>::size_type i = 0; i < output.size(); i++) {
-            for (std::vector<float>::size_type j = 0; j < output[i].size(); j++) {
-                if (i < pad_top || i >= rows + pad_top || j < pad_left || j >= cols + pad_left) {
-                    output[i][j] = 0;
-                }
-            }
-        }
-    } else if (padding == Padding::CONSTANT) {
-        for (std::vector<std::vector<float>>::size_type i = 0; i < output.size(); i++) {
-            for (std::vector<float>::size_type j = 0; j < output[i].size(); j++) {
-                if (i < pad_top || i >= rows + pad_top || j < pad_left || j >= cols + pad_left) {
-                    output[i][j] = pad_val;
-                }
-            }
-        }
-    } else if (padding == Padding::REPLICATE) {
-        for (int i = 0; i < pad_top; i++) {
-            for (std::vector<float>::size_type j = 0; j < output[0].size(); j++) {
-                output[i][j] = input[0][j];
-                output[output.size() - 1 - i][j] = input[rows - 1][j];
-            }
-        }
-        for (int j = 0; j < pad_left; j++) {
-            for (std::vector<std::vector<float>>::size_type i = 0; i < output.size(); i++) {
-                output[i][j] = input[i][0];
-                output[i][output[0].size() - 1 - j] = input[i][cols - 1];
-            }
-        }
-    } else if (padding == Padding::REFLECT) {
-        for (int i = 0; i < pad_top; i++) {
-            for (std::vector<float>::size_type j = 0; j < output[0].size(); j++) {
-                output[i][j] = input[pad_top - i - 1][j];
-                output[output.size() - 1 - i][j] = input[rows - pad_top + i][j];
-            }
-        }
-        for (int j = 0; j < pad_left; j++) {
-            for (std::vector<std::vector<float>>::size_type i = 0; i < output.size(); i++) {
-                output[i][j] = input[i][pad_left - j - 1];
-                output[i][output[0].size() - 1 - j] = input[i][cols - pad_left + j];
-            }
-        }
-    } else {
-        throw std::invalid_argument("Unsupported padding type");
-    }
+void setPlanFlags(Flags flags) {
+    plan_flags.store(flags);
 }
 
-
-static void convolve1D(const std::vector<float>& input_signal, 
-                       const std::vector<float>& kernel,
-                       std::vector<float>& output_signal,
-                       FFTWrapper& fftWrapper) {
-    int signal_size = input_signal.size();
-    int kernel_size = kernel.size();
-
-    int padded_size = signal_size + kernel_size - 1;
-
-    std::vector<float> padded_signal(padded_size, 0);
-    std::vector<float> padded_kernel(padded_size, 0);
-
-    // Copy signal and kernel
-    std::copy(input_signal.begin(), input_signal.end(), padded_signal.begin());
-    std::copy(kernel.begin(), kernel.end(), padded_kernel.begin());
-
-    std::vector<std::complex<float>> fft_signal(padded_size);
-    std::vector<std::complex<float>> fft_kernel(padded_size);
-    std::vector<std::complex<float>> fft_result(padded_size);
-
-    fftWrapper.performFFT1D(padded_signal, fft_signal, Flags::ESTIMATE);
-    fftWrapper.performFFT1D(padded_kernel, fft_kernel, Flags::ESTIMATE);
-
-    for (int i = 0; i < padded_size; ++i) {
-        fft_result[i] = fft_signal[i] * fft_kernel[i];
-    }
-
-    fftWrapper.performInverseFFT1D(fft_result, output_signal, Flags::ESTIMATE);
-}
-
-static void convolve2D(const std::vector<std::vector<float>>& input_image,
-                       const std::vector<std::vector<float>>& kernel,
-                       std::vector<std::vector<float>>& output_image,
-                       FFTWrapper& fftWrapper) {
-    int image_rows = input_image.size();
-    int image_cols = input_image[0].size();
-    int kernel_rows = kernel.size();
-    int kernel_cols = kernel[0].size();
-
-    int padded_rows = image_rows + kernel_rows - 1;
-    int padded_cols = image_cols + kernel_cols - 1;
-
-    std::vector<std::vector<float>> padded_image(padded_rows, std::vector<float>(padded_cols, 0));
-    std::vector<std::vector<float>> padded_kernel(padded_rows, std::vector<float>(padded_cols, 0));
-
-    // Copy image and kernel
-    for (int i = 0; i < image_rows; ++i) {
-        for (int j = 0; j < image_cols; ++j) {
-            padded_image[i + (kernel_rows - 1) / 2][j + (kernel_cols - 1) / 2] = input_image[i][j];
-        }
-    }
-
-    for (int i = 0; i < kernel_rows; ++i) {
-        for (int j = 0; j < kernel_cols; ++j) {
-            padded_kernel[i][j] = kernel[kernel_rows - i - 1][kernel_cols - j - 1];
-        }
-    }
-
-    std::vector<std::vector<std::complex<float>>> fft_image(padded_rows, std::vector<std::complex<float>>(padded_cols));
-    std::vector<std::vector<std::complex<float>>> fft_kernel(padded_rows, std::vector<std::complex<float>>(padded_cols));
-    std::vector<std::vector<std::complex<float>>> fft_result(padded_rows, std::vector<std::complex<float>>(padded_cols));
-
-    for (int i = 0; i < padded_rows; ++i) {
-        fftWrapper.performFFT1D(padded_image[i], fft_image[i], Flags::ESTIMATE);
-        fftWrapper.performFFT1D(padded_kernel[i], fft_kernel[i], Flags::ESTIMATE);
-    }
-
-    for (int i = 0; i < padded_rows; ++i) {
-        for (int j = 0; j < padded_cols; ++j) {
-            fft_result[i][j] = fft_image[i][j] * fft_kernel[i][j];
-        }
-    }
-
-    for (int i = 0; i < padded_rows; ++i) {
-        fftWrapper.performInverseFFT1D(fft_result[i], output_image[i], Flags::ESTIMATE);
-    }
+Flags getPlanFlags() {
+    return plan_flags.load();
 }
 
-
 // Overloaded function for 1D convolution
 std::vector<float> convolve(const std::vector<float>& signal,
                             const std::vector<float>& kernel,
                             int stride,
                             Padding padding,
-                            float pad_val = 0.0) {
-    
-    FFTWrapper fftWrapper;
-
+                            float pad_val) {
     int input_size = signal.size();
     int kernel_size = kernel.size();
-
-    if (padding != Padding::VALID) {
-        int padded_size = input_size + kernel_size - 1;
-        std::vector<float> padded_input(padded_size, 0);
-        std::vector<float> output_signal(input_size);
-        pad1D(signal, padded_input, padding, pad_val);
-        convolve1D(padded_input, kernel, output_signal, fftWrapper);
+    int output_size = convolutionOutputSize(input_size, kernel_size, padding);
+
+    // Strided signals go through the 2D engine as one-row images, which
+    // only computes the retained samples
+    if (stride != 1) {
+        output_size = convolutionOutputSize(input_size, kernel_size, padding, stride);
+        std::vector<float> output_signal(std::max(output_size, 0));
+        ConvAlgorithm algorithm = getConvAlgorithm();
+        if (algorithm == ConvAlgorithm::AUTO) {
+            algorithm = selectAlgorithm(ConvProblem{1, input_size, 1, kernel_size, 1, padding, getNumThreads(), 1, 1, stride});
+        }
+        if (algorithm == ConvAlgorithm::DIRECT) {
+            directConvolve2D(TensorView<const float>(signal.data(), 1, input_size),
+                             TensorView<const float>(kernel.data(), 1, kernel_size),
+                             TensorView<float>(output_signal.data(), 1, output_size), padding, pad_val, stride);
+        } else {
+            fftConvolveStrided2D(TensorView<const float>(signal.data(), 1, input_size),
+                                 TensorView<const float>(kernel.data(), 1, kernel_size),
+                                 TensorView<float>(output_signal.data(), 1, output_size), padding, pad_val,
+                                 1, stride, getPlanFlags());
+        }
         return output_signal;
-    } else {
-        auto padded_input = signal;
-        std::vector<float> output_signal(input_size - kernel_size + 1);
-        convolve1D(padded_input, kernel, output_signal, fftWrapper);
+    }
+
+    // Short kernels are cheaper to apply directly, as a one-row image
+    ConvAlgorithm algorithm = getConvAlgorithm();
+    if (algorithm == ConvAlgorithm::AUTO) {
+        algorithm = selectAlgorithm(ConvProblem{1, input_size, 1, kernel_size, 1, padding, getNumThreads()});
+    }
+    if (algorithm == ConvAlgorithm::DIRECT) {
+        std::vector<float> output_signal(std::max(output_size, 0));
+        directConvolve2D(TensorView<const float>(signal.data(), 1, input_size),
+                         TensorView<const float>(kernel.data(), 1, kernel_size),
+                         TensorView<float>(output_signal.data(), 1, output_size), padding, pad_val);
         return output_signal;
     }
+
+    // The kernel spectrum comes from the spectrum cache, so a kernel applied
+    // repeatedly is only transformed once
+    if (output_size <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the signal");
+    }
+    TensorView<const float> taps(kernel.data(), 1, kernel_size);
+    std::shared_ptr<const KernelSpectrum> spectrum =
+        cachedKernelSpectrum(taps, 1, 1, fftConvolutionSize(input_size, kernel_size, padding), getPlanFlags());
+    std::vector<float> output_signal(output_size);
+    fftConvolve1D(TensorView<const float>(signal.data(), 1, input_size), *spectrum,
+                  TensorView<float>(output_signal.data(), 1, output_size), padding, pad_val, getPlanFlags());
+    return output_signal;
 }
 
 // Overloaded function for 2D convolution
@@ -221,106 +88,113 @@ std::vector<std::vector<float>> convolve(const std::vector<std::vector<float>>&
                                          const std::vector<std::vector<float>>& kernel,
                                          int stride,
                                          Padding padding,
-                                         float pad_val = 0.0) {
+                                         float pad_val) {
 
     int image_rows = image.size();
     int image_cols = image[0].size();
     int kernel_rows = kernel.size();
     int kernel_cols = kernel[0].size();
-    
-    if (padding != Padding::VALID) {
-        int padded_rows = image_rows + kernel_rows - 1;
-        int padded_cols = image_cols + kernel_cols - 1;
-        
-        std::vector<std::vector<float>> padded_image(padded_rows, std::vector<float>(padded_cols, 0));
-        std::vector<std::vector<float>> output_image(image_rows, std::vector<float>(image_cols, 0));
-        pad2D(image, padded_image, padding, pad_val);
-        FFTWrapper fftWrapper;
-        convolve2D(padded_image, kernel, output_image, fftWrapper);
-        return output_image;
-    } else {
-        auto padded_image = image;
-        std::vector<std::vector<float>> output_image(image_rows - kernel_rows + 1, std::vector<float>(image_cols - kernel_cols + 1, 0));
-        FFTWrapper fftWrapper;
-        convolve2D(padded_image, kernel, output_image, fftWrapper);
-        return output_image;
+    int output_rows = convolutionOutputSize(image_rows, kernel_rows, padding, stride);
+    int output_cols = convolutionOutputSize(image_cols, kernel_cols, padding, stride);
+
+    // Nested rows are not evenly strided, so gather them into contiguous tensors
+    WorkspaceFrame frame;
+    TensorView<float> input = frame.tensor(image_rows, image_cols);
+    TensorView<float> filter = frame.tensor(kernel_rows, kernel_cols);
+    TensorView<float> output = frame.tensor(std::max(output_rows, 0), std::max(output_cols, 0));
+    for (int i = 0; i < image_rows; ++i) {
+        std::copy(image[i].begin(), image[i].end(), input.row(0, 0, i));
+    }
+    for (int i = 0; i < kernel_rows; ++i) {
+        std::copy(kernel[i].begin(), kernel[i].end(), filter.row(0, 0, i));
     }
-}
-
-
 
+    convolve(input, filter, output, stride, padding, pad_val);
 
-// Function to print a 1D vector
-void print1DVector(const std::vector<float>& vec) {
-    for (const auto& val : vec) {
-        std::cout << std::fixed << std::setprecision(2) << val << " ";
+    std::vector<std::vector<float>> output_image(output_rows);
+    for (int i = 0; i < output_rows; ++i) {
+        const float* row = output.row(0, 0, i);
+        output_image[i].assign(row, row + output_cols);
     }
-    std::cout << std::endl;
+    return output_image;
 }
 
-// Function to print a 2D vector
-void print2DVector(const std::vector<std::vector<float>>& mat) {
-    for (const auto& row : mat) {
-        for (const auto& val : row) {
-            std::cout << std::fixed << std::setprecision(2) << val << " ";
-        }
-        std::cout << std::endl;
-    }
+// 2D convolution of tensors: every image is convolved with the same kernel
+// straight out of and into the caller's views, computing only the outputs
+// a stride keeps
+void convolve(const TensorView<const float>& image,
+              const TensorView<const float>& kernel,
+              const TensorView<float>& output,
+              int stride,
+              Padding padding,
+              float pad_val) {
+    dispatchConvolve2D(image, kernel, output, padding, pad_val, ConvAlgorithm::AUTO, stride);
 }
 
-int main() {
-    FFTWrapper fftWrapper;
-
-    // Test 1D Convolution
-    std::vector<float> signal = {1, 2, 3, 4};
-    std::vector<float> kernel = {1, 0, -1};
-    
-    std::cout << "1D Convolution Test:" << std::endl;
-
-    std::vector<float> output_signal = convolve(signal, kernel, 1, Padding::ZERO);
-    std::cout << "Output with ZERO padding:" << std::endl;
-    print1DVector(output_signal);
-
-    output_signal = convolve(signal, kernel, 1, Padding::CONSTANT, 2.0);
-    std::cout << "Output with CONSTANT padding (value 2.0):" << std::endl;
-    print1DVector(output_signal);
-
-    output_signal = convolve(signal, kernel, 1, Padding::REPLICATE);
-    std::cout << "Output with REPLICATE padding:" << std::endl;
-    print1DVector(output_signal);
-
-    output_signal = convolve(signal, kernel, 1, Padding::REFLECT);
-    std::cout << "Output with REFLECT padding:" << std::endl;
-    print1DVector(output_signal);
-
-    // Test 2D Convolution
-    std::vector<std::vector<float>> image = {
-        {1, 2, 3},
-        {4, 5, 6},
-        {7, 8, 9}
-    };
-    std::vector<std::vector<float>> kernel2D = {
-        {1, 0},
-        {-1, 1}
-    };
-
-    std::cout << "\n2D Convolution Test:" << std::endl;
+// Batched 1D convolution: the cost model weighs direct application
+// against one batched transform pair per slice of the batch
+void convolveBatch1D(const TensorView<const float>& signals,
+                     const TensorView<const float>& kernels,
+                     const TensorView<float>& output,
+                     Padding padding,
+                     float pad_val) {
+    if (signals.channels() != 1 || signals.batch() != 1 || kernels.channels() != 1 || kernels.batch() != 1) {
+        throw std::invalid_argument("Batched 1D convolution takes [signals][length] views");
+    }
+    if (kernels.rows() != 1 && kernels.rows() != signals.rows()) {
+        throw std::invalid_argument("Expected one kernel, or one kernel per signal");
+    }
 
-    std::vector<std::vector<float>> output_image = convolve(image, kernel2D, 1, Padding::ZERO);
-    std::cout << "Output with ZERO padding:" << std::endl;
-    print2DVector(output_image);
+    ConvAlgorithm algorithm = getConvAlgorithm();
+    if (algorithm == ConvAlgorithm::AUTO) {
+        algorithm = selectAlgorithm(ConvProblem{1, signals.cols(), 1, kernels.cols(), signals.rows(), padding,
+                                                getNumThreads()});
+    }
+    if (algorithm != ConvAlgorithm::DIRECT) {
+        fftConvolveBatch1D(signals, kernels, output, padding, pad_val, getPlanFlags());
+        return;
+    }
 
-    output_image = convolve(image, kernel2D, 1, Padding::CONSTANT, 2.0);
-    std::cout << "Output with CONSTANT padding (value 2.0):" << std::endl;
-    print2DVector(output_image);
+    // A shared kernel is a 1 x n kernel over the [signals][length] image
+    if (kernels.rows() == 1) {
+        directConvolve2D(signals, kernels, output, padding, pad_val);
+        return;
+    }
+    int output_size = convolutionOutputSize(signals.cols(), kernels.cols(), padding);
+    if (signals.empty() || output_size <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the signal");
+    }
+    if (output.rows() != signals.rows() || output.cols() != output_size || output.channels() != 1 ||
+        output.batch() != 1) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
 
-    output_image = convolve(image, kernel2D, 1, Padding::REPLICATE);
-    std::cout << "Output with REPLICATE padding:" << std::endl;
-    print2DVector(output_image);
+    // Per-signal kernels: one one-row convolution per signal, the signals
+    // split across threads; no exception escapes the parallel region
+    int threads = parallelThreads(static_cast<double>(signals.rows()) * output_size * kernels.cols());
+    std::exception_ptr failure;
+    std::mutex failure_mutex;
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (int r = 0; r < signals.rows(); ++r) {
+        try {
+            directConvolve2D(signals.window(r, 0, 1, signals.cols()), kernels.window(r, 0, 1, kernels.cols()),
+                             output.window(r, 0, 1, output_size), padding, pad_val);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failure_mutex);
+            if (!failure) failure = std::current_exception();
+        }
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
 
-    output_image = convolve(image, kernel2D, 1, Padding::REFLECT);
-    std::cout << "Output with REFLECT padding:" << std::endl;
-    print2DVector(output_image);
+// FFT shapes planned by the 1D path: one in-place r2c/c2r pair at a smooth length
+std::vector<FFTShape> convolutionFFTShapes(int length, int kernel_length, Padding padding) {
+    return {FFTShape{1, {fftConvolutionSize(length, kernel_length, padding), 1}, true}};
+}
 
-    return 0;
-}
\ No newline at end of file
+// FFT shapes planned by the 2D path: one in-place r2c_2d/c2r_2d pair at smooth extents
+std::vector<FFTShape> convolutionFFTShapes(int rows, int cols, int kernel_rows, int kernel_cols, Padding padding) {
+    return {FFTShape{2, {fftConvolutionSize(rows, kernel_rows, padding), fftConvolutionSize(cols, kernel_cols, padding)}, true}};
+}
@@ -0,0 +1,55 @@
+#ifndef CONVOLUTION_H
+#define CONVOLUTION_H
+
+#include <vector>
+#include "FFTWrapper.h"
+#include "FFTWisdom.h"
+#include "Tensor.h"
+#include "padding.h"
+
+// 1D convolution
+std::vector<float> convolve(const std::vector<float>& signal,
+                            const std::vector<float>& kernel,
+                            int stride,
+                            Padding padding,
+                            float pad_val = 0.0);
+
+// 2D convolution
+std::vector<std::vector<float>> convolve(const std::vector<std::vector<float>>& image,
+                                         const std::vector<std::vector<float>>& kernel,
+                                         int stride,
+                                         Padding padding,
+                                         float pad_val = 0.0);
+
+// 2D convolution of every image of a tensor with a single-image kernel,
+// written into a caller-provided output view of convolutionOutputSize()
+// rows and cols (with the stride)
+void convolve(const TensorView<const float>& image,
+              const TensorView<const float>& kernel,
+              const TensorView<float>& output,
+              int stride,
+              Padding padding,
+              float pad_val = 0.0);
+
+// Batched 1D convolution of every row of `signals` ([signals][length],
+// rows any pitch apart) with `kernels`: a single kernel row shared by all
+// signals, or one row per signal. `output` holds one row per signal of
+// convolutionOutputSize(length, kernel_length, padding) samples. Short
+// kernels are applied directly; otherwise the batch is split across
+// threads and each slice goes through one batched transform pair (see
+// fftConvolveBatch1D), so the per-call overhead is paid once per batch.
+void convolveBatch1D(const TensorView<const float>& signals,
+                     const TensorView<const float>& kernels,
+                     const TensorView<float>& output,
+                     Padding padding,
+                     float pad_val = 0.0);
+
+// FFTW planner flags used by convolve() (MEASURE by default)
+void setPlanFlags(Flags flags);
+Flags getPlanFlags();
+
+// FFT shapes that convolve() plans for a given problem, for pre-planning with FFTWisdom
+std::vector<FFTShape> convolutionFFTShapes(int length, int kernel_length, Padding padding);
+std::vector<FFTShape> convolutionFFTShapes(int rows, int cols, int kernel_rows, int kernel_cols, Padding padding);
+
+#endif  // CONVOLUTION_H
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <stdexcept>
+#include "convolution_service.h"
+#include "parallel.h"
+#include "workspace.h"
+
+// Jobs whose latencies the statistics keep
+static const std::size_t LATENCY_WINDOW = 4096;
+
+// Copy `count` batch items of `src` from `src_first` on to `dst` from
+// `dst_first` on
+static void copyBatch(const TensorView<const float>& src, int src_first, const TensorView<float>& dst, int dst_first,
+                      int count) {
+    for (int b = 0; b < count; ++b) {
+        for (int c = 0; c < src.channels(); ++c) {
+            for (int i = 0; i < src.rows(); ++i) {
+                const float* row = src.row(src_first + b, c, i);
+                std::copy(row, row + src.cols(), dst.row(dst_first + b, c, i));
+            }
+        }
+    }
+}
+
+static double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::size_t k = std::min(values.size() - 1, static_cast<std::size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+ConvolutionService::ConvolutionService(const ServiceOptions& options)
+    : options(options), running(0), lingering(0), stopping(false), latencyCursor(0) {
+    if (options.workers < 0 || options.queue_capacity == 0 || options.max_batch < 1) {
+        throw std::invalid_argument("Invalid service options");
+    }
+    int workers = options.workers > 0 ? options.workers : getNumThreads();
+    threadsPerWorker = std::max(1, getNumThreads() / workers);
+    queueLatencies.reserve(LATENCY_WINDOW);
+    totalLatencies.reserve(LATENCY_WINDOW);
+    for (int i = 0; i < workers; ++i) {
+        threads.emplace_back(&ConvolutionService::workerLoop, this);
+    }
+}
+
+ConvolutionService::~ConvolutionService() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    notEmpty.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// ------------------- Submission -------------------
+
+void ConvolutionService::checkJob(const Tensor<float>& image, const PreparedKernel& kernel) {
+    if (image.view().empty()) {
+        throw std::invalid_argument("Image must not be empty");
+    }
+    if (kernel.rank() == 1 ? image.cols() != kernel.inputCols()
+                           : image.rows() != kernel.inputRows() || image.cols() != kernel.inputCols()) {
+        throw std::invalid_argument("Kernel was prepared for a different image size");
+    }
+}
+
+// Takes ownership of `image`; checkJob() has accepted it
+ConvolutionService::Job ConvolutionService::makeJob(Tensor<float>& image, const PreparedKernel& kernel, float pad_val) {
+    return Job{std::move(image), kernel, pad_val, std::promise<Tensor<float>>(), Clock::time_point()};
+}
+
+void ConvolutionService::enqueue(Job& job, std::unique_lock<std::mutex>&) {
+    job.submitted = Clock::now();
+    queue.push_back(std::move(job));
+    ++counters.submitted;
+    counters.peak_queue_depth = std::max(counters.peak_queue_depth, queue.size());
+    // Every worker looks: a lingering one may be waiting for this shape
+    notEmpty.notify_all();
+}
+
+std::future<Tensor<float>> ConvolutionService::submit(Tensor<float> image, const PreparedKernel& kernel,
+                                                      float pad_val) {
+    checkJob(image, kernel);
+    Job job = makeJob(image, kernel, pad_val);
+    std::future<Tensor<float>> result = job.result.get_future();
+    std::unique_lock<std::mutex> lock(mutex);
+    if (queue.size() >= options.queue_capacity) {
+        ++counters.blocked_submits;
+        notFull.wait(lock, [this]() { return queue.size() < options.queue_capacity; });
+    }
+    enqueue(job, lock);
+    return result;
+}
+
+std::optional<std::future<Tensor<float>>> ConvolutionService::trySubmit(Tensor<float>&& image,
+                                                                        const PreparedKernel& kernel, float pad_val) {
+    checkJob(image, kernel);
+    std::unique_lock<std::mutex> lock(mutex);
+    if (queue.size() >= options.queue_capacity) {
+        return std::nullopt;  // `image` untouched
+    }
+    Job job = makeJob(image, kernel, pad_val);
+    std::future<Tensor<float>> result = job.result.get_future();
+    enqueue(job, lock);
+    return result;
+}
+
+void ConvolutionService::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return queue.empty() && running == 0; });
+}
+
+// ------------------- Workers -------------------
+
+// Move the oldest job and up to max_batch - 1 queued jobs it can be
+// batched with into `batch`, lingering for more if so configured
+void ConvolutionService::takeBatch(std::vector<Job>& batch, std::unique_lock<std::mutex>& lock) {
+    // Jobs count as running from the moment they leave the queue, so wait()
+    // does not return while they sit in a lingering batch
+    batch.clear();
+    batch.push_back(std::move(queue.front()));
+    queue.pop_front();
+    ++running;
+
+    // Copied, not referenced: `batch` reallocates as it grows
+    const KernelSpectrum* spectrum = &batch.front().kernel.spectrum();
+    Padding padding = batch.front().kernel.padding();
+    float pad_val = batch.front().pad_val;
+    int rows = batch.front().image.rows(), cols = batch.front().image.cols();
+    int channels = batch.front().image.channels();
+    auto batchable = [&](const Job& job) {
+        return &job.kernel.spectrum() == spectrum && job.kernel.padding() == padding && job.pad_val == pad_val &&
+               job.image.rows() == rows && job.image.cols() == cols && job.image.channels() == channels;
+    };
+    std::size_t max_batch = static_cast<std::size_t>(options.max_batch);
+    Clock::time_point deadline = Clock::now() + options.batch_linger;
+    std::size_t held = 0;  // this batch's share of `lingering`
+    for (;;) {
+        for (auto it = queue.begin(); it != queue.end() && batch.size() < max_batch;) {
+            if (batchable(*it)) {
+                batch.push_back(std::move(*it));
+                it = queue.erase(it);
+                ++running;
+            } else {
+                ++it;
+            }
+        }
+        if (batch.size() >= max_batch || stopping || Clock::now() >= deadline) {
+            lingering -= held;
+            notFull.notify_all();
+            return;
+        }
+        // Blocked submitters need not wait out the linger for freed space
+        if (batch.size() > held) {
+            lingering += batch.size() - held;
+            held = batch.size();
+            notFull.notify_all();
+        }
+        notEmpty.wait_until(lock, deadline);
+    }
+}
+
+void ConvolutionService::runBatch(std::vector<Job>& batch) {
+    Clock::time_point start = Clock::now();
+    const Job& first = batch.front();
+    const PreparedKernel& kernel = first.kernel;
+    int out_rows = kernel.rank() == 1 ? first.image.rows() : kernel.outputRows();
+    int out_cols = kernel.outputCols();
+    int channels = first.image.channels();
+
+    bool failed = false;
+    try {
+        std::vector<Tensor<float>> outputs;
+        outputs.reserve(batch.size());
+        for (const Job& job : batch) {
+            outputs.emplace_back(out_rows, out_cols, channels, job.image.batch());
+        }
+        if (batch.size() == 1) {
+            convolve(first.image, kernel, outputs[0], first.pad_val);
+        } else {
+            // Gather the images so one batched call (and plan) covers them
+            int images = 0;
+            for (const Job& job : batch) {
+                images += job.image.batch();
+            }
+            WorkspaceFrame frame;
+            TensorView<float> input =
+                frame.uninitializedTensor(first.image.rows(), first.image.cols(), channels, images);
+            TensorView<float> output = frame.uninitializedTensor(out_rows, out_cols, channels, images);
+            int offset = 0;
+            for (const Job& job : batch) {
+                copyBatch(job.image, 0, input, offset, job.image.batch());
+                offset += job.image.batch();
+            }
+            convolve(input, kernel, output, first.pad_val);
+            offset = 0;
+            for (Tensor<float>& out : outputs) {
+                copyBatch(output, offset, out, 0, out.batch());
+                offset += out.batch();
+            }
+        }
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            batch[i].result.set_value(std::move(outputs[i]));
+        }
+    } catch (...) {
+        failed = true;
+        for (Job& job : batch) {
+            job.result.set_exception(std::current_exception());
+        }
+    }
+    Clock::time_point done = Clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Job& job : batch) {
+        double queued = std::chrono::duration<double, std::micro>(start - job.submitted).count();
+        double total = std::chrono::duration<double, std::micro>(done - job.submitted).count();
+        if (queueLatencies.size() < LATENCY_WINDOW) {
+            queueLatencies.push_back(queued);
+            totalLatencies.push_back(total);
+        } else {
+            queueLatencies[latencyCursor] = queued;
+            totalLatencies[latencyCursor] = total;
+        }
+        latencyCursor = (latencyCursor + 1) % LATENCY_WINDOW;
+    }
+    counters.completed += batch.size();
+    counters.failed += failed ? batch.size() : 0;
+    ++counters.batches;
+    running -= static_cast<int>(batch.size());
+    if (queue.empty() && running == 0) {
+        idle.notify_all();
+    }
+}
+
+void ConvolutionService::workerLoop() {
+    ThreadLimit limit(threadsPerWorker);
+    std::vector<Job> batch;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        notEmpty.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;  // stopping, and every job is done
+        }
+        takeBatch(batch, lock);
+        lock.unlock();
+        runBatch(batch);
+        batch.clear();
+        lock.lock();
+    }
+}
+
+// ------------------- Statistics -------------------
+
+ServiceStats ConvolutionService::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    ServiceStats s = counters;
+    s.queue_depth = queue.size() + lingering;
+    s.mean_batch = s.batches ? static_cast<double>(s.completed) / s.batches : 0;
+    s.queue_p50_us = percentile(queueLatencies, 0.5);
+    s.queue_p99_us = percentile(queueLatencies, 0.99);
+    s.queue_max_us = percentile(queueLatencies, 1.0);
+    s.total_p50_us = percentile(totalLatencies, 0.5);
+    s.total_p99_us = percentile(totalLatencies, 0.99);
+    s.total_max_us = percentile(totalLatencies, 1.0);
+    return s;
+}
+
+void ConvolutionService::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters = ServiceStats();
+    queueLatencies.clear();
+    totalLatencies.clear();
+    latencyCursor = 0;
+}
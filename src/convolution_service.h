@@ -0,0 +1,119 @@
+#ifndef CONVOLUTION_SERVICE_H
+#define CONVOLUTION_SERVICE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "prepared_kernel.h"
+#include "Tensor.h"
+
+struct ServiceOptions {
+    int workers = 0;                  // worker threads; 0 = getNumThreads()
+    std::size_t queue_capacity = 64;  // queued jobs before submit() blocks
+    int max_batch = 8;                // jobs run as one batched call
+    // How long a worker waits for more jobs of its batch's shape before
+    // running a partial batch: throughput against latency
+    std::chrono::microseconds batch_linger{0};
+};
+
+// Queue statistics; latencies (microseconds) cover the most recent jobs
+struct ServiceStats {
+    std::uint64_t submitted = 0;
+    std::uint64_t completed = 0;       // failed jobs included
+    std::uint64_t failed = 0;
+    std::uint64_t batches = 0;
+    std::uint64_t blocked_submits = 0;  // submits that waited for queue space
+    std::size_t queue_depth = 0;       // jobs held by lingering workers included
+    std::size_t peak_queue_depth = 0;
+    double mean_batch = 0;              // jobs per batch
+    double queue_p50_us = 0;            // submit until a worker starts the job
+    double queue_p99_us = 0;
+    double queue_max_us = 0;
+    double total_p50_us = 0;            // submit until the result is ready
+    double total_p99_us = 0;
+    double total_max_us = 0;
+};
+
+// Asynchronous convolution with prepared kernels. Jobs wait in a bounded
+// FIFO queue: submit() blocks while it is full, so producers are slowed to
+// the service's pace. Each worker takes the oldest job together with the
+// queued jobs of the same kernel, padding and image shape, up to
+// max_batch, and runs them as one batched convolution (one batched FFT
+// plan). Workers are capped to an equal share of getNumThreads(), so jobs
+// overlap instead of oversubscribing the cores.
+class ConvolutionService {
+public:
+    explicit ConvolutionService(const ServiceOptions& options = ServiceOptions());
+
+    // Finishes every queued job, then stops the workers
+    ~ConvolutionService();
+
+    ConvolutionService(const ConvolutionService&) = delete;
+    ConvolutionService& operator=(const ConvolutionService&) = delete;
+
+    // Convolve every image of `image` (1D kernels: every row) with `kernel`;
+    // the future holds the output or the exception the convolution threw.
+    // Throws std::invalid_argument at once if the image does not fit the
+    // kernel.
+    std::future<Tensor<float>> submit(Tensor<float> image, const PreparedKernel& kernel, float pad_val = 0.0f);
+
+    // Same, without waiting: empty if the queue is full. `image` is only
+    // moved from when the job is accepted, so a rejected image can be
+    // submitted again.
+    std::optional<std::future<Tensor<float>>> trySubmit(Tensor<float>&& image, const PreparedKernel& kernel,
+                                                        float pad_val = 0.0f);
+
+    // Block until every submitted job has completed
+    void wait();
+
+    ServiceStats stats() const;
+    void resetStats();
+
+    int workers() const { return static_cast<int>(threads.size()); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        Tensor<float> image;
+        PreparedKernel kernel;
+        float pad_val;
+        std::promise<Tensor<float>> result;
+        Clock::time_point submitted;
+    };
+
+    ServiceOptions options;
+    int threadsPerWorker;
+
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::condition_variable idle;
+    std::deque<Job> queue;
+    int running;  // jobs taken by workers and not yet completed
+    std::size_t lingering;  // jobs held in a batch whose worker lingers for more
+    bool stopping;
+
+    ServiceStats counters;
+    std::vector<double> queueLatencies;  // ring buffers of recent jobs
+    std::vector<double> totalLatencies;
+    std::size_t latencyCursor;
+
+    std::vector<std::thread> threads;
+
+    void enqueue(Job& job, std::unique_lock<std::mutex>& lock);
+    static void checkJob(const Tensor<float>& image, const PreparedKernel& kernel);
+    static Job makeJob(Tensor<float>& image, const PreparedKernel& kernel, float pad_val);
+    void takeBatch(std::vector<Job>& batch, std::unique_lock<std::mutex>& lock);
+    void runBatch(std::vector<Job>& batch);
+    void workerLoop();
+};
+
+#endif  // CONVOLUTION_SERVICE_H
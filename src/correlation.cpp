@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include "correlation.h"
+#include "fft_convolution.h"
+#include "instrumentation.h"
+#include "padding.h"
+#include "parallel.h"
+#include "simd.h"
+#include "workspace.h"
+
+// Complex view aliasing a row-padded real staging tensor
+static TensorView<std::complex<float>> spectrumView(const TensorView<float>& real, int fft_rows, int spectrum_cols) {
+    return TensorView<std::complex<float>>(reinterpret_cast<std::complex<float>*>(real.data()),
+                                           fft_rows, spectrum_cols, real.channels(), real.batch(),
+                                           real.rowStride() / 2, real.channelStride() / 2, real.batchStride() / 2);
+}
+
+int correlationFFTSize(int size) {
+    // Window offsets stop at size - template, so a template at any offset
+    // reaches at most the last image sample: a transform of the image's
+    // own extent never wraps into the kept scores
+    return nextSmoothSize(size);
+}
+
+static void checkShapes(const TensorView<const float>& image, const TensorView<const float>& templates) {
+    if (image.empty() || image.channels() != 1 || image.batch() != 1) {
+        throw std::invalid_argument("Template matching needs a single-channel image");
+    }
+    if (templates.empty() || templates.channels() != 1) {
+        throw std::invalid_argument("Templates must be non-empty single-channel images");
+    }
+    if (templates.rows() > image.rows() || templates.cols() > image.cols()) {
+        throw std::invalid_argument("Template does not fit in the image");
+    }
+}
+
+// 1 / sqrt(sum over the window of (image - window mean)^2) for every
+// window, from integral images of the image and its square; 0 where the
+// window is (nearly) constant
+static void windowEnergies(WorkspaceFrame& frame, const TensorView<const float>& image, int template_rows,
+                           int template_cols, const TensorView<float>& inverse) {
+    int rows = image.rows();
+    int cols = image.cols();
+    std::ptrdiff_t pitch = cols + 1;
+    double* sum = frame.array<double>(static_cast<std::size_t>(rows + 1) * pitch);
+    double* sum_sq = frame.array<double>(static_cast<std::size_t>(rows + 1) * pitch);
+    std::fill(sum, sum + pitch, 0.0);
+    std::fill(sum_sq, sum_sq + pitch, 0.0);
+    for (int i = 0; i < rows; ++i) {
+        const float* in = image.row(0, 0, i);
+        double row_sum = 0, row_sum_sq = 0;
+        double* s = sum + (i + 1) * pitch;
+        double* q = sum_sq + (i + 1) * pitch;
+        s[0] = q[0] = 0;
+        for (int j = 0; j < cols; ++j) {
+            row_sum += in[j];
+            row_sum_sq += static_cast<double>(in[j]) * in[j];
+            s[j + 1] = s[j + 1 - pitch] + row_sum;
+            q[j + 1] = q[j + 1 - pitch] + row_sum_sq;
+        }
+    }
+
+    double n = static_cast<double>(template_rows) * template_cols;
+    int threads = parallelThreads(static_cast<double>(inverse.rows()) * inverse.cols());
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (int i = 0; i < inverse.rows(); ++i) {
+        const double* s0 = sum + i * pitch;
+        const double* s1 = sum + (i + template_rows) * pitch;
+        const double* q0 = sum_sq + i * pitch;
+        const double* q1 = sum_sq + (i + template_rows) * pitch;
+        float* out = inverse.row(0, 0, i);
+        for (int j = 0; j < inverse.cols(); ++j) {
+            int k = j + template_cols;
+            double window_sum = s1[k] - s1[j] - s0[k] + s0[j];
+            double window_sq = q1[k] - q1[j] - q0[k] + q0[j];
+            double energy = window_sq - window_sum * window_sum / n;
+            out[j] = energy > 1e-9 * window_sq && energy > 0 ? static_cast<float>(1.0 / std::sqrt(energy)) : 0.0f;
+        }
+    }
+}
+
+// Score maps of every template, left in rows [0, rows - template_rows]
+// and cols [0, cols - template_cols] of each image of the returned buffer
+static TensorView<float> scoreMaps(WorkspaceFrame& frame,
+                                   const TensorView<const float>& image,
+                                   const TensorView<const float>& templates,
+                                   MatchMethod method,
+                                   Flags flags) {
+    checkShapes(image, templates);
+    int rows = image.rows();
+    int cols = image.cols();
+    int template_rows = templates.rows();
+    int template_cols = templates.cols();
+    int count = templates.batch();
+    int fft_rows = correlationFFTSize(rows);
+    int fft_cols = correlationFFTSize(cols);
+    int spectrum_cols = fft_cols / 2 + 1;
+    int pitch = 2 * spectrum_cols;
+    bool zncc = method == MatchMethod::ZNCC;
+
+    // The image is transformed once, straight from the caller's buffer when
+    // its extent is already a transform size
+    bool direct = fft_rows == rows && fft_cols == cols;
+    TensorView<float> staged = direct ? frame.uninitializedTensor(fft_rows, fft_cols, 1, 1, pitch)
+                                      : frame.tensor(fft_rows, fft_cols, 1, 1, pitch);
+    if (!direct) {
+        padImage(image, staged.window(0, 0, rows, cols), 0, 0, Padding::ZERO, 0.0f);
+    }
+    FFTWrapper fftWrapper;
+    TensorView<std::complex<float>> fft_image = spectrumView(staged, fft_rows, spectrum_cols);
+    if (fftWrapper.performFFT2D(direct ? image : TensorView<const float>(staged), fft_image, flags) !=
+        FFTStatus::SUCCESS) {
+        throw std::runtime_error("FFT planning failed");
+    }
+
+    // Templates (zero-mean for ZNCC) are staged at the origin of their own
+    // buffers and transformed by one batched plan
+    TensorView<float> maps = frame.tensor(fft_rows, fft_cols, 1, count, pitch);
+    float* norms = frame.array<float>(count);
+    int threads = parallelThreads(static_cast<double>(count) * template_rows * template_cols);
+    {
+        ScopedStage stage(Stage::PAD);
+        #pragma omp parallel for num_threads(threads) schedule(static)
+        for (int t = 0; t < count; ++t) {
+            double sum = 0;
+            for (int i = 0; i < template_rows; ++i) {
+                const float* in = templates.row(t, 0, i);
+                for (int j = 0; j < template_cols; ++j) sum += in[j];
+            }
+            float mean = zncc ? static_cast<float>(sum / (static_cast<double>(template_rows) * template_cols)) : 0;
+            double energy = 0, raw_energy = 0;
+            for (int i = 0; i < template_rows; ++i) {
+                const float* in = templates.row(t, 0, i);
+                float* out = maps.row(t, 0, i);
+                for (int j = 0; j < template_cols; ++j) {
+                    out[j] = in[j] - mean;
+                    energy += static_cast<double>(out[j]) * out[j];
+                    raw_energy += static_cast<double>(in[j]) * in[j];
+                }
+            }
+            norms[t] = energy > 1e-12 * raw_energy && energy > 0 ? static_cast<float>(std::sqrt(energy)) : 0.0f;
+        }
+    }
+    TensorView<std::complex<float>> fft_maps = spectrumView(maps, fft_rows, spectrum_cols);
+    if (fftWrapper.performFFT2D(maps, fft_maps, flags) != FFTStatus::SUCCESS) {
+        throw std::runtime_error("FFT planning failed");
+    }
+
+    // Correlation is a product with the conjugate template spectrum, with
+    // the inverse transform's 1/N folded in
+    float scale = 1.0f / (static_cast<float>(fft_rows) * fft_cols);
+    long spectrum_rows = static_cast<long>(count) * fft_rows;
+    threads = parallelThreads(static_cast<double>(spectrum_rows) * spectrum_cols);
+    {
+        ScopedStage stage(Stage::MULTIPLY);
+        #pragma omp parallel for num_threads(threads) schedule(static)
+        for (long r = 0; r < spectrum_rows; ++r) {
+            int t = static_cast<int>(r / fft_rows);
+            int i = static_cast<int>(r % fft_rows);
+            std::complex<float>* row = fft_maps.row(t, 0, i);
+            conjugateMultiply(row, fft_image.row(0, 0, i), row, spectrum_cols, scale);
+        }
+    }
+    if (fftWrapper.performInverseFFT2D(fft_maps, maps, flags, false) != FFTStatus::SUCCESS) {
+        throw std::runtime_error("FFT planning failed");
+    }
+
+    if (zncc) {
+        // sum (I - mean) t' = sum I t' for a zero-mean t', so only the
+        // denominator remains: the window's energy times the template norm
+        int out_rows = rows - template_rows + 1;
+        int out_cols = cols - template_cols + 1;
+        TensorView<float> inverse = frame.uninitializedTensor(out_rows, out_cols);
+        windowEnergies(frame, image, template_rows, template_cols, inverse);
+        long map_rows = static_cast<long>(count) * out_rows;
+        threads = parallelThreads(static_cast<double>(map_rows) * out_cols);
+        ScopedStage stage(Stage::CROP);
+        #pragma omp parallel for num_threads(threads) schedule(static)
+        for (long r = 0; r < map_rows; ++r) {
+            int t = static_cast<int>(r / out_rows);
+            int i = static_cast<int>(r % out_rows);
+            float* row = maps.row(t, 0, i);
+            const float* energy = inverse.row(0, 0, i);
+            float norm = norms[t] > 0 ? 1.0f / norms[t] : 0.0f;
+            for (int j = 0; j < out_cols; ++j) {
+                row[j] = std::min(1.0f, std::max(-1.0f, row[j] * energy[j] * norm));
+            }
+        }
+    }
+    return maps;
+}
+
+void correlate2D(const TensorView<const float>& image,
+                 const TensorView<const float>& templates,
+                 const TensorView<float>& output,
+                 MatchMethod method,
+                 Flags flags) {
+    checkShapes(image, templates);
+    int out_rows = image.rows() - templates.rows() + 1;
+    int out_cols = image.cols() - templates.cols() + 1;
+    if (output.rows() != out_rows || output.cols() != out_cols || output.channels() != 1 ||
+        output.batch() != templates.batch()) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
+
+    WorkspaceFrame frame;
+    TensorView<float> maps = scoreMaps(frame, image, templates, method, flags);
+    long output_rows = static_cast<long>(output.batch()) * out_rows;
+    int threads = parallelThreads(static_cast<double>(output_rows) * out_cols);
+    ScopedStage stage(Stage::CROP);
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (long r = 0; r < output_rows; ++r) {
+        int t = static_cast<int>(r / out_rows);
+        int i = static_cast<int>(r % out_rows);
+        const float* src = maps.row(t, 0, i);
+        std::copy(src, src + out_cols, output.row(t, 0, i));
+    }
+}
+
+std::vector<std::vector<MatchPeak>> matchTemplates(const TensorView<const float>& image,
+                                                   const TensorView<const float>& templates,
+                                                   int k,
+                                                   MatchMethod method,
+                                                   float min_score,
+                                                   Flags flags) {
+    if (k < 1) {
+        throw std::invalid_argument("Peak count must be positive");
+    }
+    WorkspaceFrame frame;
+    TensorView<float> maps = scoreMaps(frame, image, templates, method, flags);
+    int out_rows = image.rows() - templates.rows() + 1;
+    int out_cols = image.cols() - templates.cols() + 1;
+    int count = templates.batch();
+
+    // Each template keeps its k best peaks in a min-heap on its own
+    // reserved storage, so nothing allocates inside the parallel loop
+    std::vector<std::vector<MatchPeak>> peaks(count);
+    for (std::vector<MatchPeak>& best : peaks) {
+        best.reserve(k);
+    }
+    auto better = [](const MatchPeak& a, const MatchPeak& b) {
+        if (a.score != b.score) return a.score > b.score;
+        return a.row != b.row ? a.row < b.row : a.col < b.col;
+    };
+
+    int threads = parallelThreads(static_cast<double>(count) * out_rows * out_cols);
+    ScopedStage stage(Stage::CROP);
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (int t = 0; t < count; ++t) {
+        std::vector<MatchPeak>& best = peaks[t];
+        for (int i = 0; i < out_rows; ++i) {
+            const float* row = maps.row(t, 0, i);
+            for (int j = 0; j < out_cols; ++j) {
+                float score = row[j];
+                if (score < min_score || (static_cast<int>(best.size()) == k && score <= best.front().score)) {
+                    continue;
+                }
+                bool peak = true;
+                for (int di = std::max(i - 1, 0); di <= std::min(i + 1, out_rows - 1) && peak; ++di) {
+                    const float* neighbours = maps.row(t, 0, di);
+                    for (int dj = std::max(j - 1, 0); dj <= std::min(j + 1, out_cols - 1); ++dj) {
+                        if (neighbours[dj] > score) {
+                            peak = false;
+                            break;
+                        }
+                    }
+                }
+                if (!peak) {
+                    continue;
+                }
+                if (static_cast<int>(best.size()) == k) {
+                    std::pop_heap(best.begin(), best.end(), better);
+                    best.pop_back();
+                }
+                best.push_back(MatchPeak{i, j, score});
+                std::push_heap(best.begin(), best.end(), better);
+            }
+        }
+        std::sort_heap(best.begin(), best.end(), better);
+    }
+    return peaks;
+}
+
+std::size_t correlationWorkspace(int rows, int cols, int template_rows, int template_cols, int templates,
+                                 MatchMethod method) {
+    int fft_rows = correlationFFTSize(rows);
+    int fft_cols = correlationFFTSize(cols);
+    int pitch = 2 * (fft_cols / 2 + 1);
+    std::size_t bytes = workspaceTensorBytes(fft_rows, fft_cols, 1, 1, pitch) +
+                        workspaceTensorBytes(fft_rows, fft_cols, 1, templates, pitch) +
+                        workspaceTensorBytes(templates, 1);
+    if (method == MatchMethod::ZNCC) {
+        bytes += workspaceTensorBytes(rows - template_rows + 1, cols - template_cols + 1) +
+                 2 * workspaceTensorBytes(rows + 1, cols + 1, 1, 1, 0, sizeof(double));
+    }
+    return bytes;
+}
@@ -0,0 +1,57 @@
+#ifndef CORRELATION_H
+#define CORRELATION_H
+
+#include <cstddef>
+#include <vector>
+#include "FFTWrapper.h"
+#include "Tensor.h"
+#include "convolution.h"
+
+enum class MatchMethod {
+    CROSS_CORRELATION,  // sum over the window of image x template
+    ZNCC                // zero-mean normalized cross-correlation, in [-1, 1]
+};
+
+// One match of a template: the top-left corner of the window
+struct MatchPeak {
+    int row;
+    int col;
+    float score;
+};
+
+// Transform extents used for correlating an image of this extent (any
+// template that fits shares them)
+int correlationFFTSize(int size);
+
+// Template matching of one single-channel image against every template of
+// `templates` (batch = template count, one channel): output(t, 0, i, j)
+// scores the window of template t's size at (i, j), for the
+// (rows - template_rows + 1) x (cols - template_cols + 1) windows that fit.
+// The image is transformed once; the templates go through one batched
+// forward transform, a conjugate spectrum product each and one batched
+// inverse. For ZNCC the templates are made zero-mean before their
+// transform, and the windows' mean and energy come from integral images,
+// so normalizing costs no further transforms. Windows of (nearly)
+// constant image score 0, as do constant templates.
+void correlate2D(const TensorView<const float>& image,
+                 const TensorView<const float>& templates,
+                 const TensorView<float>& output,
+                 MatchMethod method,
+                 Flags flags = getPlanFlags());
+
+// Same scores, reduced to the `k` highest peaks per template (best first)
+// without copying out the score maps. A peak scores at least as high as
+// the 8 windows around it; peaks scoring below `min_score` are dropped.
+std::vector<std::vector<MatchPeak>> matchTemplates(const TensorView<const float>& image,
+                                                   const TensorView<const float>& templates,
+                                                   int k,
+                                                   MatchMethod method,
+                                                   float min_score = -1e30f,
+                                                   Flags flags = getPlanFlags());
+
+// Workspace bytes (see workspace.h) correlate2D and matchTemplates take
+// from the calling thread's workspace
+std::size_t correlationWorkspace(int rows, int cols, int template_rows, int template_cols, int templates,
+                                 MatchMethod method);
+
+#endif  // CORRELATION_H
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <stdexcept>
+#include "direct_convolution.h"
+#include "direct_kernels.h"
+#include "instrumentation.h"
+#include "parallel.h"
+#include "simd.h"
+#include "workspace.h"
+
+std::size_t directConvolutionWorkspace(int rows, int cols, int kernel_rows, int kernel_cols, Padding padding) {
+    if (padding == Padding::VALID) {
+        return 0;
+    }
+    return workspaceTensorBytes(convolutionOutputSize(rows, kernel_rows, padding) + kernel_rows - 1,
+                                convolutionOutputSize(cols, kernel_cols, padding) + kernel_cols - 1);
+}
+
+void directConvolve2D(const TensorView<const float>& image,
+                      const TensorView<const float>& kernel,
+                      const TensorView<float>& output,
+                      Padding padding,
+                      float pad_val,
+                      int stride) {
+    ScopedStage stage(Stage::DIRECT);
+    int kernel_rows = kernel.rows();
+    int kernel_cols = kernel.cols();
+    int full_rows = convolutionOutputSize(image.rows(), kernel_rows, padding);
+    int full_cols = convolutionOutputSize(image.cols(), kernel_cols, padding);
+    int output_rows = convolutionOutputSize(image.rows(), kernel_rows, padding, stride);
+    int output_cols = convolutionOutputSize(image.cols(), kernel_cols, padding, stride);
+
+    if (image.empty() || kernel.empty() || output_rows <= 0 || output_cols <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the image");
+    }
+    if (output.rows() != output_rows || output.cols() != output_cols ||
+        output.channels() != image.channels() || output.batch() != image.batch()) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
+
+    // Borders are staged once per image, so the inner loops never branch
+    bool padded = padding != Padding::VALID;
+    int padded_rows = full_rows + kernel_rows - 1;
+    int padded_cols = full_cols + kernel_cols - 1;
+    WorkspaceFrame frame;
+    TensorView<float> staged = frame.tensor(padded ? padded_rows : 0, padded ? padded_cols : 0);
+    int threads = parallelThreads(static_cast<double>(output_rows) * output_cols * kernel_rows * kernel_cols);
+
+    // Common kernel sizes run a kernel specialized for their size (see
+    // direct_kernels.h), which takes the kernel flipped into correlation taps
+    FixedDirectKernel fixed = stride == 1 ? fixedDirectKernel(kernel_rows, kernel_cols) : nullptr;
+    float taps[MAX_FIXED_KERNEL_TAPS];
+    if (fixed) {
+        for (int u = 0; u < kernel_rows; ++u) {
+            for (int v = 0; v < kernel_cols; ++v) {
+                taps[u * kernel_cols + v] = kernel(kernel_rows - 1 - u, kernel_cols - 1 - v);
+            }
+        }
+    }
+
+    for (int b = 0; b < image.batch(); ++b) {
+        for (int c = 0; c < image.channels(); ++c) {
+            TensorView<const float> source = image.image(b, c);
+            if (padded) {
+                padImage(source, staged, paddingBefore(kernel_rows, padding), paddingBefore(kernel_cols, padding),
+                         padding, pad_val);
+                source = staged;
+            }
+
+            // Only retained outputs are computed: row i reads padded rows
+            // from i * stride, column j reads columns j * stride + ...
+            // Output rows are independent and split across threads.
+            #pragma omp parallel for num_threads(threads) schedule(static)
+            for (int i = 0; i < output_rows; ++i) {
+                float* out = output.row(b, c, i);
+                if (fixed) {
+                    fixed(source.row(0, 0, i), source.rowStride(), taps, out, output_cols);
+                    continue;
+                }
+                std::fill(out, out + output_cols, 0.0f);
+                for (int u = 0; u < kernel_rows; ++u) {
+                    const float* in = source.row(0, 0, i * stride + kernel_rows - 1 - u);
+                    const float* taps = kernel.row(0, 0, u);
+                    for (int v = 0; v < kernel_cols; ++v) {
+                        if (stride == 1) {
+                            axpy(out, in + kernel_cols - 1 - v, taps[v], output_cols);
+                        } else {
+                            const float* src = in + kernel_cols - 1 - v;
+                            float weight = taps[v];
+                            for (int j = 0; j < output_cols; ++j) {
+                                out[j] += weight * src[j * stride];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef DIRECT_CONVOLUTION_H
+#define DIRECT_CONVOLUTION_H
+
+#include <cstddef>
+#include "Tensor.h"
+#include "padding.h"
+
+// Spatial-domain 2D convolution of every image of `image` with `kernel`.
+// Each kernel tap is applied as a SIMD multiply-add across a contiguous
+// output row, so the cost is one vector FMA per tap per 4 (or 8) outputs.
+// Kernels of the sizes direct_kernels.h specializes run unit-stride rows
+// through their fixed-size kernel instead.
+// With a stride only every stride-th output row and column is computed.
+void directConvolve2D(const TensorView<const float>& image,
+                      const TensorView<const float>& kernel,
+                      const TensorView<float>& output,
+                      Padding padding,
+                      float pad_val,
+                      int stride = 1);
+
+// Workspace bytes (see workspace.h) directConvolve2D takes from the calling
+// thread's workspace: the padded image, unless padding is VALID
+std::size_t directConvolutionWorkspace(int rows, int cols, int kernel_rows, int kernel_cols, Padding padding);
+
+#endif  // DIRECT_CONVOLUTION_H
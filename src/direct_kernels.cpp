@@ -0,0 +1,188 @@
+#include "direct_kernels.h"
+#include "simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define KF_SIMD_X86 1
+#define KF_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// Every variant sums the taps row by row, left to right, starting from
+// zero. The vector variants keep four accumulators (independent
+// multiply-add chains) per block of columns and finish with one vector at
+// a time, then the scalar kernel.
+
+// ------------------- Scalar -------------------
+
+template <int KH, int KW>
+static void rowScalar(const float* in, std::ptrdiff_t pitch, const float* taps, float* out, int n) {
+    for (int j = 0; j < n; ++j) {
+        float sum = 0;
+#pragma GCC unroll 16
+        for (int u = 0; u < KH; ++u) {
+#pragma GCC unroll 16
+            for (int v = 0; v < KW; ++v) {
+                sum += taps[u * KW + v] * in[u * pitch + j + v];
+            }
+        }
+        out[j] = sum;
+    }
+}
+
+#ifdef KF_SIMD_X86
+
+// ------------------- SSE3 -------------------
+
+template <int KH, int KW>
+KF_TARGET("sse3") static void rowSSE3(const float* in, std::ptrdiff_t pitch, const float* taps, float* out, int n) {
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps(), acc2 = _mm_setzero_ps(), acc3 = _mm_setzero_ps();
+#pragma GCC unroll 16
+        for (int u = 0; u < KH; ++u) {
+            const float* row = in + u * pitch + j;
+#pragma GCC unroll 16
+            for (int v = 0; v < KW; ++v) {
+                __m128 w = _mm_set1_ps(taps[u * KW + v]);
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(w, _mm_loadu_ps(row + v)));
+                acc1 = _mm_add_ps(acc1, _mm_mul_ps(w, _mm_loadu_ps(row + v + 4)));
+                acc2 = _mm_add_ps(acc2, _mm_mul_ps(w, _mm_loadu_ps(row + v + 8)));
+                acc3 = _mm_add_ps(acc3, _mm_mul_ps(w, _mm_loadu_ps(row + v + 12)));
+            }
+        }
+        _mm_storeu_ps(out + j, acc0);
+        _mm_storeu_ps(out + j + 4, acc1);
+        _mm_storeu_ps(out + j + 8, acc2);
+        _mm_storeu_ps(out + j + 12, acc3);
+    }
+    for (; j + 4 <= n; j += 4) {
+        __m128 acc = _mm_setzero_ps();
+#pragma GCC unroll 16
+        for (int u = 0; u < KH; ++u) {
+#pragma GCC unroll 16
+            for (int v = 0; v < KW; ++v) {
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(taps[u * KW + v]), _mm_loadu_ps(in + u * pitch + j + v)));
+            }
+        }
+        _mm_storeu_ps(out + j, acc);
+    }
+    rowScalar<KH, KW>(in + j, pitch, taps, out + j, n - j);
+}
+
+// ------------------- AVX2 -------------------
+
+template <int KH, int KW>
+KF_TARGET("avx2,fma") static void rowAVX2(const float* in, std::ptrdiff_t pitch, const float* taps, float* out,
+                                          int n) {
+    int j = 0;
+    for (; j + 32 <= n; j += 32) {
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+#pragma GCC unroll 16
+        for (int u = 0; u < KH; ++u) {
+            const float* row = in + u * pitch + j;
+#pragma GCC unroll 16
+            for (int v = 0; v < KW; ++v) {
+                __m256 w = _mm256_set1_ps(taps[u * KW + v]);
+                acc0 = _mm256_fmadd_ps(w, _mm256_loadu_ps(row + v), acc0);
+                acc1 = _mm256_fmadd_ps(w, _mm256_loadu_ps(row + v + 8), acc1);
+                acc2 = _mm256_fmadd_ps(w, _mm256_loadu_ps(row + v + 16), acc2);
+                acc3 = _mm256_fmadd_ps(w, _mm256_loadu_ps(row + v + 24), acc3);
+            }
+        }
+        _mm256_storeu_ps(out + j, acc0);
+        _mm256_storeu_ps(out + j + 8, acc1);
+        _mm256_storeu_ps(out + j + 16, acc2);
+        _mm256_storeu_ps(out + j + 24, acc3);
+    }
+    for (; j + 8 <= n; j += 8) {
+        __m256 acc = _mm256_setzero_ps();
+#pragma GCC unroll 16
+        for (int u = 0; u < KH; ++u) {
+#pragma GCC unroll 16
+            for (int v = 0; v < KW; ++v) {
+                acc = _mm256_fmadd_ps(_mm256_set1_ps(taps[u * KW + v]), _mm256_loadu_ps(in + u * pitch + j + v), acc);
+            }
+        }
+        _mm256_storeu_ps(out + j, acc);
+    }
+    rowScalar<KH, KW>(in + j, pitch, taps, out + j, n - j);
+}
+
+// ------------------- AVX-512 -------------------
+
+template <int KH, int KW>
+KF_TARGET("avx512f") static void rowAVX512(const float* in, std::ptrdiff_t pitch, const float* taps, float* out,
+                                           int n) {
+    int j = 0;
+    for (; j + 64 <= n; j += 64) {
+        __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+        __m512 acc2 = _mm512_setzero_ps(), acc3 = _mm512_setzero_ps();
+#pragma GCC unroll 16
+        for (int u = 0; u < KH; ++u) {
+            const float* row = in + u * pitch + j;
+#pragma GCC unroll 16
+            for (int v = 0; v < KW; ++v) {
+                __m512 w = _mm512_set1_ps(taps[u * KW + v]);
+                acc0 = _mm512_fmadd_ps(w, _mm512_loadu_ps(row + v), acc0);
+                acc1 = _mm512_fmadd_ps(w, _mm512_loadu_ps(row + v + 16), acc1);
+                acc2 = _mm512_fmadd_ps(w, _mm512_loadu_ps(row + v + 32), acc2);
+                acc3 = _mm512_fmadd_ps(w, _mm512_loadu_ps(row + v + 48), acc3);
+            }
+        }
+        _mm512_storeu_ps(out + j, acc0);
+        _mm512_storeu_ps(out + j + 16, acc1);
+        _mm512_storeu_ps(out + j + 32, acc2);
+        _mm512_storeu_ps(out + j + 48, acc3);
+    }
+    // The last vector is masked: masked-off lanes are neither read nor written
+    for (; j < n; j += 16) {
+        __mmask16 mask = n - j >= 16 ? static_cast<__mmask16>(0xFFFF) : static_cast<__mmask16>((1u << (n - j)) - 1);
+        __m512 acc = _mm512_setzero_ps();
+#pragma GCC unroll 16
+        for (int u = 0; u < KH; ++u) {
+#pragma GCC unroll 16
+            for (int v = 0; v < KW; ++v) {
+                acc = _mm512_fmadd_ps(_mm512_set1_ps(taps[u * KW + v]),
+                                      _mm512_maskz_loadu_ps(mask, in + u * pitch + j + v), acc);
+            }
+        }
+        _mm512_mask_storeu_ps(out + j, mask, acc);
+    }
+}
+
+#endif  // KF_SIMD_X86
+
+// ------------------- Dispatch -------------------
+
+struct FixedKernelEntry {
+    int rows;
+    int cols;
+    FixedDirectKernel kernels[5];  // indexed by SimdLevel, nullptr for none
+};
+
+// The scalar level keeps the generic path, whose row-at-a-time axpy
+// vectorizes better than a scalar kernel per output
+template <int KH, int KW>
+static constexpr FixedKernelEntry fixedEntry() {
+#ifdef KF_SIMD_X86
+    return {KH, KW, {nullptr, nullptr, rowSSE3<KH, KW>, rowAVX2<KH, KW>, rowAVX512<KH, KW>}};
+#else
+    return {KH, KW, {nullptr, nullptr, nullptr, nullptr, nullptr}};
+#endif
+}
+
+static constexpr FixedKernelEntry fixed_kernels[] = {
+    fixedEntry<1, 3>(), fixedEntry<1, 5>(), fixedEntry<1, 7>(), fixedEntry<1, 9>(),
+    fixedEntry<3, 1>(), fixedEntry<5, 1>(), fixedEntry<7, 1>(), fixedEntry<9, 1>(),
+    fixedEntry<3, 3>(), fixedEntry<5, 5>(), fixedEntry<7, 7>(),
+};
+
+FixedDirectKernel fixedDirectKernel(int kernel_rows, int kernel_cols) {
+    for (const FixedKernelEntry& entry : fixed_kernels) {
+        if (entry.rows == kernel_rows && entry.cols == kernel_cols) {
+            return entry.kernels[static_cast<int>(getSimdLevel())];
+        }
+    }
+    return nullptr;
+}
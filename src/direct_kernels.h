@@ -0,0 +1,26 @@
+#ifndef DIRECT_KERNELS_H
+#define DIRECT_KERNELS_H
+
+#include <cstddef>
+
+// Direct convolution kernels compiled for one kernel size. The tap loops
+// are unrolled at compile time, so every tap is one broadcast multiply-add
+// into a block of output columns held in vector registers, and each output
+// is stored once instead of once per tap.
+//
+// A kernel computes n outputs of one row of a stride-1 correlation,
+//     out[j] = sum over u < KH, v < KW of taps[u * KW + v] * in[u * pitch + j + v],
+// reading KH rows of n + KW - 1 inputs. `taps` is the convolution kernel
+// flipped in both axes, row-major.
+using FixedDirectKernel = void (*)(const float* in, std::ptrdiff_t pitch, const float* taps, float* out, int n);
+
+// Taps of the largest kernel with a specialization
+const int MAX_FIXED_KERNEL_TAPS = 49;
+
+// Specialization for a kernel_rows x kernel_cols kernel at the active SIMD
+// level (see simd.h), or nullptr when the size or level has none. Sizes
+// covered: 1x3, 1x5, 1x7 and 1x9 (1D signals, rows), 3x1, 5x1, 7x1 and 9x1
+// (columns), and 3x3, 5x5 and 7x7, at every level from SSE3 up.
+FixedDirectKernel fixedDirectKernel(int kernel_rows, int kernel_cols);
+
+#endif  // DIRECT_KERNELS_H
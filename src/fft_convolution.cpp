@@ -0,0 +1,840 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "fft_convolution.h"
+#include "instrumentation.h"
+#include "parallel.h"
+#include "simd.h"
+#include "workspace.h"
+
+int nextSmoothSize(int n) {
+    for (int m = std::max(n, 1);; ++m) {
+        int r = m;
+        for (int p : {2, 3, 5, 7}) {
+            while (r % p == 0) r /= p;
+        }
+        if (r == 1) {
+            return m;
+        }
+    }
+}
+
+// Zero-type padding does not need to be materialized: the image is staged
+// at the origin and the linear convolution (extent size + kernel - 1) is
+// cropped at an offset instead. Other modes stage the padded image, of
+// which only the valid part of the circular convolution is kept.
+static bool stagesBorder(Padding padding) {
+    return padding == Padding::CONSTANT || padding == Padding::REPLICATE || padding == Padding::REFLECT ||
+           padding == Padding::CIRCULAR;
+}
+
+// Circular padding needs no border along an axis FFTW transforms fast (and
+// no shorter than the kernel): a transform of exactly the axis length
+// wraps around by itself
+static bool wrapsNatively(int size, int kernel_size, Padding padding) {
+    return padding == Padding::CIRCULAR && kernel_size <= size && nextSmoothSize(size) == size;
+}
+
+// Extent of the staged region along one axis
+static int stagedSize(int size, int kernel_size, Padding padding) {
+    if (wrapsNatively(size, kernel_size, padding)) {
+        return size;
+    }
+    if (stagesBorder(padding)) {
+        return size + kernel_size - 1;
+    }
+    return padding == Padding::VALID ? size : size + kernel_size - 1;
+}
+
+// Border staged before the image along one axis
+static int stagedBefore(int size, int kernel_size, Padding padding) {
+    if (stagesBorder(padding) && !wrapsNatively(size, kernel_size, padding)) {
+        return paddingBefore(kernel_size, padding);
+    }
+    return 0;
+}
+
+// Offset of the first output in the circular convolution along one axis;
+// on a natively wrapped axis the outputs run past the end back to index 0
+static int cropOffset(int size, int kernel_size, Padding padding) {
+    if (stagesBorder(padding) && !wrapsNatively(size, kernel_size, padding)) {
+        return kernel_size - 1;
+    }
+    return kernel_size - 1 - paddingBefore(kernel_size, padding);
+}
+
+// Copy `cols` outputs of a circular convolution row of `fft_cols` from
+// `offset` on, wrapping around its end
+static void cropRow(const float* row, int fft_cols, int offset, int cols, float* out) {
+    int first = std::min(cols, fft_cols - offset);
+    std::copy(row + offset, row + offset + first, out);
+    std::copy(row, row + (cols - first), out + first);
+}
+
+// Complex view aliasing a row-padded real staging tensor
+static TensorView<std::complex<float>> spectrumView(const TensorView<float>& real, int fft_rows, int spectrum_cols) {
+    return TensorView<std::complex<float>>(reinterpret_cast<std::complex<float>*>(real.data()),
+                                           fft_rows, spectrum_cols, real.channels(), real.batch(),
+                                           real.rowStride() / 2, real.channelStride() / 2, real.batchStride() / 2);
+}
+
+int fftConvolutionSize(int size, int kernel_size, Padding padding) {
+    return nextSmoothSize(stagedSize(size, kernel_size, padding));
+}
+
+// ------------------- Kernel Spectrum Cache -------------------
+
+TensorView<std::complex<float>> KernelSpectrum::spectrum() const {
+    return spectrumView(data, fft_rows, fft_cols / 2 + 1);
+}
+
+struct KernelSpectrumEntry {
+    std::uint64_t hash;
+    std::vector<float> raw;  // the source kernel, to rule out hash collisions
+    std::shared_ptr<const KernelSpectrum> spectrum;
+};
+
+static std::mutex spectrum_cache_mutex;
+static std::size_t spectrum_cache_capacity = 16;
+static std::list<KernelSpectrumEntry> spectrum_cache;  // most recently used first
+
+std::uint64_t kernelContentHash(const TensorView<const float>& kernel) {
+    std::uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](const void* bytes, std::size_t n) {
+        const unsigned char* p = static_cast<const unsigned char*>(bytes);
+        for (std::size_t i = 0; i < n; ++i) {
+            hash = (hash ^ p[i]) * 1099511628211ULL;
+        }
+    };
+    int rows = kernel.rows();
+    int cols = kernel.cols();
+    mix(&rows, sizeof(rows));
+    mix(&cols, sizeof(cols));
+    for (int i = 0; i < rows; ++i) {
+        mix(kernel.row(0, 0, i), cols * sizeof(float));
+    }
+    return hash;
+}
+
+bool sameCoefficients(const std::vector<float>& raw, const TensorView<const float>& kernel) {
+    if (raw.size() != static_cast<std::size_t>(kernel.rows()) * kernel.cols()) {
+        return false;
+    }
+    for (int i = 0; i < kernel.rows(); ++i) {
+        if (!std::equal(kernel.row(0, 0, i), kernel.row(0, 0, i) + kernel.cols(),
+                        raw.begin() + static_cast<std::ptrdiff_t>(i) * kernel.cols())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::shared_ptr<const KernelSpectrum> transformKernel(const TensorView<const float>& kernel,
+                                                             int rank, int fft_rows, int fft_cols, Flags flags) {
+    int spectrum_cols = fft_cols / 2 + 1;
+    auto spectrum = std::make_shared<KernelSpectrum>();
+    spectrum->rank = rank;
+    spectrum->kernel_rows = kernel.rows();
+    spectrum->kernel_cols = kernel.cols();
+    spectrum->fft_rows = fft_rows;
+    spectrum->fft_cols = fft_cols;
+    spectrum->data = Tensor<float>(fft_rows, fft_cols, 1, 1, 2 * spectrum_cols);
+    for (int i = 0; i < kernel.rows(); ++i) {
+        std::copy(kernel.row(0, 0, i), kernel.row(0, 0, i) + kernel.cols(), spectrum->data.view().row(0, 0, i));
+    }
+
+    FFTWrapper fftWrapper;
+    FFTStatus status = rank == 1 ? fftWrapper.performFFT1D(spectrum->data.view(), spectrum->spectrum(), flags)
+                                 : fftWrapper.performFFT2D(spectrum->data.view(), spectrum->spectrum(), flags);
+    if (status != FFTStatus::SUCCESS) {
+        throw std::runtime_error("FFT planning failed");
+    }
+    return spectrum;
+}
+
+std::shared_ptr<const KernelSpectrum> cachedKernelSpectrum(const TensorView<const float>& kernel,
+                                                           int rank, int fft_rows, int fft_cols, Flags flags) {
+    if (kernel.empty() || (rank == 1 && (kernel.rows() != 1 || fft_rows != 1)) ||
+        kernel.rows() > fft_rows || kernel.cols() > fft_cols) {
+        throw std::invalid_argument("Kernel does not fit in the transform");
+    }
+
+    // Hits compare against the kernel in place, so they do not allocate
+    std::uint64_t hash = kernelContentHash(kernel);
+    {
+        std::lock_guard<std::mutex> lock(spectrum_cache_mutex);
+        for (auto it = spectrum_cache.begin(); it != spectrum_cache.end(); ++it) {
+            const KernelSpectrum& entry = *it->spectrum;
+            if (it->hash == hash && entry.rank == rank && entry.fft_rows == fft_rows && entry.fft_cols == fft_cols &&
+                entry.kernel_rows == kernel.rows() && entry.kernel_cols == kernel.cols() &&
+                sameCoefficients(it->raw, kernel)) {
+                spectrum_cache.splice(spectrum_cache.begin(), spectrum_cache, it);
+                countEvent(Counter::SPECTRUM_CACHE_HITS);
+                return spectrum_cache.front().spectrum;
+            }
+        }
+    }
+
+    countEvent(Counter::SPECTRUM_CACHE_MISSES);
+    // Transform outside the lock; a concurrent miss on the same kernel
+    // only costs a duplicate transform
+    std::shared_ptr<const KernelSpectrum> spectrum = transformKernel(kernel, rank, fft_rows, fft_cols, flags);
+    std::vector<float> raw;
+    raw.reserve(static_cast<std::size_t>(kernel.rows()) * kernel.cols());
+    for (int i = 0; i < kernel.rows(); ++i) {
+        raw.insert(raw.end(), kernel.row(0, 0, i), kernel.row(0, 0, i) + kernel.cols());
+    }
+
+    std::lock_guard<std::mutex> lock(spectrum_cache_mutex);
+    if (spectrum_cache_capacity > 0) {
+        spectrum_cache.push_front(KernelSpectrumEntry{hash, std::move(raw), spectrum});
+        while (spectrum_cache.size() > spectrum_cache_capacity) {
+            spectrum_cache.pop_back();
+        }
+    }
+    return spectrum;
+}
+
+void setKernelSpectrumCacheCapacity(std::size_t entries) {
+    std::lock_guard<std::mutex> lock(spectrum_cache_mutex);
+    spectrum_cache_capacity = entries;
+    while (spectrum_cache.size() > spectrum_cache_capacity) {
+        spectrum_cache.pop_back();
+    }
+}
+
+std::size_t kernelSpectrumCacheSize() {
+    std::lock_guard<std::mutex> lock(spectrum_cache_mutex);
+    return spectrum_cache.size();
+}
+
+void clearKernelSpectrumCache() {
+    std::lock_guard<std::mutex> lock(spectrum_cache_mutex);
+    spectrum_cache.clear();
+}
+
+// ------------------- Single-kernel Convolution -------------------
+
+// Multiply every staged spectrum by the kernel spectrum, invert and crop
+// the requested region into `output`
+static void multiplyAndCrop(const TensorView<float>& staged, const KernelSpectrum& kernel, const TensorView<float>& output,
+                            int crop_top, int crop_left, Flags flags) {
+    int spectrum_cols = kernel.fft_cols / 2 + 1;
+    TensorView<std::complex<float>> fft_image = spectrumView(staged, staged.rows(), spectrum_cols);
+    TensorView<std::complex<float>> fft_kernel = kernel.spectrum();
+
+    // Pointwise product over the half spectrum, with the inverse
+    // transform's 1/N folded in; a 1D kernel's single row applies to every
+    // signal. Rows of every image are independent.
+    int channels = fft_image.channels();
+    long rows = static_cast<long>(fft_image.batch()) * channels * fft_image.rows();
+    float scale = 1.0f / (static_cast<float>(kernel.fft_rows) * kernel.fft_cols);
+    int threads = parallelThreads(static_cast<double>(rows) * spectrum_cols);
+    {
+        ScopedStage stage(Stage::MULTIPLY);
+        #pragma omp parallel for num_threads(threads) schedule(static)
+        for (long r = 0; r < rows; ++r) {
+            int i = static_cast<int>(r % fft_image.rows());
+            int n = static_cast<int>(r / fft_image.rows());
+            std::complex<float>* row = fft_image.row(n / channels, n % channels, i);
+            complexMultiply(row, row, fft_kernel.row(0, 0, kernel.rank == 1 ? 0 : i), spectrum_cols, scale);
+        }
+    }
+
+    FFTWrapper fftWrapper;
+    FFTStatus status = kernel.rank == 1 ? fftWrapper.performInverseFFT1D(fft_image, staged, flags, false)
+                                        : fftWrapper.performInverseFFT2D(fft_image, staged, flags, false);
+    if (status != FFTStatus::SUCCESS) {
+        throw std::runtime_error("FFT planning failed");
+    }
+
+    // Crop the requested region
+    long output_rows = static_cast<long>(output.batch()) * channels * output.rows();
+    threads = parallelThreads(static_cast<double>(output_rows) * output.cols());
+    ScopedStage stage(Stage::CROP);
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (long r = 0; r < output_rows; ++r) {
+        int i = static_cast<int>(r % output.rows());
+        int n = static_cast<int>(r / output.rows());
+        const float* src = staged.row(n / channels, n % channels, (i + crop_top) % staged.rows());
+        cropRow(src, kernel.fft_cols, crop_left, output.cols(), output.row(n / channels, n % channels, i));
+    }
+}
+
+void fftConvolve1D(const TensorView<const float>& signals,
+                   const KernelSpectrum& kernel,
+                   const TensorView<float>& output,
+                   Padding padding,
+                   float pad_val,
+                   Flags flags) {
+    int kernel_size = kernel.kernel_cols;
+    int output_size = convolutionOutputSize(signals.cols(), kernel_size, padding);
+
+    if (kernel.rank != 1) {
+        throw std::invalid_argument("1D convolution needs a 1D kernel spectrum");
+    }
+    if (signals.empty() || output_size <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the signal");
+    }
+    if (kernel.fft_cols != fftConvolutionSize(signals.cols(), kernel_size, padding)) {
+        throw std::invalid_argument("Kernel spectrum was prepared for a different signal length");
+    }
+    if (output.rows() != signals.rows() || output.cols() != output_size ||
+        output.channels() != signals.channels() || output.batch() != signals.batch()) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
+
+    int fft_size = kernel.fft_cols;
+    int staged_size = stagedSize(signals.cols(), kernel_size, padding);
+    int left = stagedBefore(signals.cols(), kernel_size, padding);
+    bool wraps = wrapsNatively(signals.cols(), kernel_size, padding);
+
+    // Every row is an independent signal; one batched plan transforms them
+    // all. Natively wrapping signals are transformed straight from the input.
+    WorkspaceFrame frame;
+    int pitch = 2 * (fft_size / 2 + 1);
+    TensorView<float> staged =
+        wraps ? frame.uninitializedTensor(signals.rows(), fft_size, signals.channels(), signals.batch(), pitch)
+              : frame.tensor(signals.rows(), fft_size, signals.channels(), signals.batch(), pitch);
+    if (!wraps) {
+        for (int b = 0; b < signals.batch(); ++b) {
+            for (int c = 0; c < signals.channels(); ++c) {
+                padImage(signals.image(b, c), staged.image(b, c).window(0, 0, signals.rows(), staged_size),
+                         0, left, padding, pad_val);
+            }
+        }
+    }
+
+    FFTWrapper fftWrapper;
+    if (fftWrapper.performFFT1D(wraps ? signals : TensorView<const float>(staged),
+                                spectrumView(staged, signals.rows(), fft_size / 2 + 1), flags) != FFTStatus::SUCCESS) {
+        throw std::runtime_error("FFT planning failed");
+    }
+    multiplyAndCrop(staged, kernel, output, 0, cropOffset(signals.cols(), kernel_size, padding), flags);
+}
+
+void fftConvolveBatch1D(const TensorView<const float>& signals,
+                        const TensorView<const float>& kernels,
+                        const TensorView<float>& output,
+                        Padding padding,
+                        float pad_val,
+                        Flags flags) {
+    int count = signals.rows();
+    int length = signals.cols();
+    int kernel_size = kernels.cols();
+    int output_size = convolutionOutputSize(length, kernel_size, padding);
+
+    if (signals.channels() != 1 || signals.batch() != 1 || kernels.channels() != 1 || kernels.batch() != 1) {
+        throw std::invalid_argument("Batched 1D convolution takes [signals][length] views");
+    }
+    if (signals.empty() || kernels.empty() || output_size <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the signal");
+    }
+    if (kernels.rows() != 1 && kernels.rows() != count) {
+        throw std::invalid_argument("Expected one kernel, or one kernel per signal");
+    }
+    if (output.rows() != count || output.cols() != output_size || output.channels() != 1 || output.batch() != 1) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
+
+    int fft_size = fftConvolutionSize(length, kernel_size, padding);
+    int spectrum_cols = fft_size / 2 + 1;
+    int pitch = 2 * spectrum_cols;
+    int staged_size = stagedSize(length, kernel_size, padding);
+    int left = stagedBefore(length, kernel_size, padding);
+    int crop_left = cropOffset(length, kernel_size, padding);
+    bool wraps = wrapsNatively(length, kernel_size, padding);
+    float scale = 1.0f / fft_size;
+
+    // A shared kernel comes from the spectrum cache; per-signal kernels are
+    // transformed along with their slice
+    bool shared = kernels.rows() == 1;
+    std::shared_ptr<const KernelSpectrum> shared_spectrum;
+    if (shared) {
+        shared_spectrum = cachedKernelSpectrum(kernels, 1, 1, fft_size, flags);
+    }
+
+    auto convolveSlice = [&](int first, int rows) {
+        TensorView<const float> in = signals.window(first, 0, rows, length);
+        WorkspaceFrame frame;
+        TensorView<float> staged = wraps ? frame.uninitializedTensor(rows, fft_size, 1, 1, pitch)
+                                         : frame.tensor(rows, fft_size, 1, 1, pitch);
+        if (!wraps) {
+            padImage(in, staged.window(0, 0, rows, staged_size), 0, left, padding, pad_val);
+        }
+        TensorView<std::complex<float>> spectra = spectrumView(staged, rows, spectrum_cols);
+        FFTWrapper fftWrapper;
+        if (fftWrapper.performFFT1D(wraps ? in : TensorView<const float>(staged), spectra, flags) !=
+            FFTStatus::SUCCESS) {
+            throw std::runtime_error("FFT planning failed");
+        }
+
+        TensorView<std::complex<float>> filters;
+        if (shared) {
+            filters = shared_spectrum->spectrum();
+        } else {
+            TensorView<float> padded = frame.tensor(rows, fft_size, 1, 1, pitch);
+            for (int r = 0; r < rows; ++r) {
+                std::copy(kernels.row(0, 0, first + r), kernels.row(0, 0, first + r) + kernel_size,
+                          padded.row(0, 0, r));
+            }
+            filters = spectrumView(padded, rows, spectrum_cols);
+            if (fftWrapper.performFFT1D(padded, filters, flags) != FFTStatus::SUCCESS) {
+                throw std::runtime_error("FFT planning failed");
+            }
+        }
+        {
+            ScopedStage stage(Stage::MULTIPLY);
+            for (int r = 0; r < rows; ++r) {
+                complexMultiply(spectra.row(0, 0, r), spectra.row(0, 0, r), filters.row(0, 0, shared ? 0 : r),
+                                spectrum_cols, scale);
+            }
+        }
+        if (fftWrapper.performInverseFFT1D(spectra, staged, flags, false) != FFTStatus::SUCCESS) {
+            throw std::runtime_error("FFT planning failed");
+        }
+
+        ScopedStage stage(Stage::CROP);
+        for (int r = 0; r < rows; ++r) {
+            cropRow(staged.row(0, 0, r), fft_size, crop_left, output_size, output.row(0, 0, first + r));
+        }
+    };
+
+    // One contiguous slice per thread, staged in that thread's workspace.
+    // Slices differ by at most one signal, so every call plans (or finds
+    // cached) at most two batch shapes. Workers catch everything, so no
+    // exception escapes the parallel region.
+    double work = static_cast<double>(count) * fft_size * std::log2(std::max(fft_size, 2));
+    int threads = std::min(count, parallelThreads(work));
+    std::exception_ptr failure;
+    std::mutex failure_mutex;
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (int s = 0; s < threads; ++s) {
+        try {
+            int first = static_cast<int>(static_cast<long>(count) * s / threads);
+            int last = static_cast<int>(static_cast<long>(count) * (s + 1) / threads);
+            convolveSlice(first, last - first);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failure_mutex);
+            if (!failure) failure = std::current_exception();
+        }
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void fftConvolve2D(const TensorView<const float>& image,
+                   const KernelSpectrum& kernel,
+                   const TensorView<float>& output,
+                   Padding padding,
+                   float pad_val,
+                   Flags flags) {
+    int kernel_rows = kernel.kernel_rows;
+    int kernel_cols = kernel.kernel_cols;
+    int output_rows = convolutionOutputSize(image.rows(), kernel_rows, padding);
+    int output_cols = convolutionOutputSize(image.cols(), kernel_cols, padding);
+
+    if (kernel.rank != 2) {
+        throw std::invalid_argument("2D convolution needs a 2D kernel spectrum");
+    }
+    if (image.empty() || output_rows <= 0 || output_cols <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the image");
+    }
+    if (kernel.fft_rows != fftConvolutionSize(image.rows(), kernel_rows, padding) ||
+        kernel.fft_cols != fftConvolutionSize(image.cols(), kernel_cols, padding)) {
+        throw std::invalid_argument("Kernel spectrum was prepared for a different image size");
+    }
+    if (output.rows() != output_rows || output.cols() != output_cols ||
+        output.channels() != image.channels() || output.batch() != image.batch()) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
+
+    int staged_rows = stagedSize(image.rows(), kernel_rows, padding);
+    int staged_cols = stagedSize(image.cols(), kernel_cols, padding);
+    int fft_rows = kernel.fft_rows;
+    int fft_cols = kernel.fft_cols;
+    int spectrum_cols = fft_cols / 2 + 1;
+    int top = stagedBefore(image.rows(), kernel_rows, padding);
+    int left = stagedBefore(image.cols(), kernel_cols, padding);
+    bool wraps = wrapsNatively(image.rows(), kernel_rows, padding) && wrapsNatively(image.cols(), kernel_cols, padding);
+
+    // Rows are padded to 2 * (fft_cols / 2 + 1) floats so the spectra can
+    // be computed in place; everything outside the staged region stays
+    // zero. An image that wraps natively on both axes is not staged at all:
+    // it is transformed straight into the buffer.
+    WorkspaceFrame frame;
+    TensorView<float> staged =
+        wraps ? frame.uninitializedTensor(fft_rows, fft_cols, image.channels(), image.batch(), 2 * spectrum_cols)
+              : frame.tensor(fft_rows, fft_cols, image.channels(), image.batch(), 2 * spectrum_cols);
+    if (!wraps) {
+        for (int b = 0; b < image.batch(); ++b) {
+            for (int c = 0; c < image.channels(); ++c) {
+                padImage(image.image(b, c), staged.image(b, c).window(0, 0, staged_rows, staged_cols),
+                         top, left, padding, pad_val);
+            }
+        }
+    }
+
+    FFTWrapper fftWrapper;
+    if (fftWrapper.performFFT2D(wraps ? image : TensorView<const float>(staged),
+                                spectrumView(staged, fft_rows, spectrum_cols), flags) != FFTStatus::SUCCESS) {
+        throw std::runtime_error("FFT planning failed");
+    }
+    multiplyAndCrop(staged, kernel, output, cropOffset(image.rows(), kernel_rows, padding),
+                    cropOffset(image.cols(), kernel_cols, padding), flags);
+}
+
+void fftConvolve2D(const TensorView<const float>& image,
+                   const TensorView<const float>& kernel,
+                   const TensorView<float>& output,
+                   Padding padding,
+                   float pad_val,
+                   Flags flags) {
+    if (image.empty() || kernel.empty() || convolutionOutputSize(image.rows(), kernel.rows(), padding) <= 0 ||
+        convolutionOutputSize(image.cols(), kernel.cols(), padding) <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the image");
+    }
+    std::shared_ptr<const KernelSpectrum> spectrum =
+        cachedKernelSpectrum(kernel, 2, fftConvolutionSize(image.rows(), kernel.rows(), padding),
+                             fftConvolutionSize(image.cols(), kernel.cols(), padding), flags);
+    fftConvolve2D(image, *spectrum, output, padding, pad_val, flags);
+}
+
+// ------------------- Multi-channel Layers -------------------
+
+FilterSpectra fftTransformFilters(const TensorView<const float>& filters,
+                                  int rows, int cols,
+                                  Padding padding,
+                                  Flags flags) {
+    if (filters.empty()) {
+        throw std::invalid_argument("Filter bank must not be empty");
+    }
+    FilterSpectra spectra;
+    spectra.kernel_rows = filters.rows();
+    spectra.kernel_cols = filters.cols();
+    spectra.fft_rows = fftConvolutionSize(rows, filters.rows(), padding);
+    spectra.fft_cols = fftConvolutionSize(cols, filters.cols(), padding);
+    int spectrum_cols = spectra.fft_cols / 2 + 1;
+
+    // Filters are laid out [out][in], matching the filter bank's batch and channels
+    spectra.data = Tensor<float>(spectra.fft_rows, spectra.fft_cols, filters.channels(), filters.batch(),
+                                 2 * spectrum_cols);
+    for (int k = 0; k < filters.batch(); ++k) {
+        for (int c = 0; c < filters.channels(); ++c) {
+            for (int i = 0; i < filters.rows(); ++i) {
+                std::copy(filters.row(k, c, i), filters.row(k, c, i) + filters.cols(),
+                          spectra.data.view().row(k, c, i));
+            }
+        }
+    }
+
+    FFTWrapper fftWrapper;
+    if (fftWrapper.performFFT2D(spectra.data.view(), spectrumView(spectra.data, spectra.fft_rows, spectrum_cols),
+                                flags) != FFTStatus::SUCCESS) {
+        throw std::runtime_error("FFT planning failed");
+    }
+    return spectra;
+}
+
+void fftConvolveLayer(const TensorView<const float>& input,
+                      const FilterSpectra& filters,
+                      const TensorView<float>& output,
+                      Padding padding,
+                      float pad_val,
+                      Flags flags) {
+    int in_channels = input.channels();
+    int out_channels = filters.data.batch();
+    int kernel_rows = filters.kernel_rows;
+    int kernel_cols = filters.kernel_cols;
+    int output_rows = convolutionOutputSize(input.rows(), kernel_rows, padding);
+    int output_cols = convolutionOutputSize(input.cols(), kernel_cols, padding);
+
+    if (filters.data.channels() != in_channels) {
+        throw std::invalid_argument("Filter bank and input have different channel counts");
+    }
+    if (input.empty() || output_rows <= 0 || output_cols <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the image");
+    }
+    if (filters.fft_rows != fftConvolutionSize(input.rows(), kernel_rows, padding) ||
+        filters.fft_cols != fftConvolutionSize(input.cols(), kernel_cols, padding)) {
+        throw std::invalid_argument("Filter spectra were prepared for a different input size");
+    }
+    if (output.rows() != output_rows || output.cols() != output_cols ||
+        output.channels() != out_channels || output.batch() != input.batch()) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
+
+    int fft_rows = filters.fft_rows;
+    int fft_cols = filters.fft_cols;
+    int spectrum_cols = fft_cols / 2 + 1;
+    int staged_rows = stagedSize(input.rows(), kernel_rows, padding);
+    int staged_cols = stagedSize(input.cols(), kernel_cols, padding);
+    int top = stagedBefore(input.rows(), kernel_rows, padding);
+    int left = stagedBefore(input.cols(), kernel_cols, padding);
+    bool wraps = wrapsNatively(input.rows(), kernel_rows, padding) && wrapsNatively(input.cols(), kernel_cols, padding);
+
+    // All input channels of the batch are transformed by one batched plan,
+    // and so are all output channels. Inputs that wrap natively are
+    // transformed unstaged; the accumulator is overwritten by its first
+    // product, so neither needs zeroing.
+    WorkspaceFrame frame;
+    int pitch = 2 * spectrum_cols;
+    TensorView<float> staged = wraps ? frame.uninitializedTensor(fft_rows, fft_cols, in_channels, input.batch(), pitch)
+                                     : frame.tensor(fft_rows, fft_cols, in_channels, input.batch(), pitch);
+    TensorView<float> accumulated = frame.uninitializedTensor(fft_rows, fft_cols, out_channels, input.batch(), pitch);
+    if (!wraps) {
+        for (int b = 0; b < input.batch(); ++b) {
+            for (int c = 0; c < in_channels; ++c) {
+                padImage(input.image(b, c), staged.image(b, c).window(0, 0, staged_rows, staged_cols),
+                         top, left, padding, pad_val);
+            }
+        }
+    }
+
+    TensorView<std::complex<float>> fft_input = spectrumView(staged, fft_rows, spectrum_cols);
+    TensorView<std::complex<float>> fft_output = spectrumView(accumulated, fft_rows, spectrum_cols);
+    TensorView<std::complex<float>> fft_filters = spectrumView(filters.data, fft_rows, spectrum_cols);
+
+    FFTWrapper fftWrapper;
+    if (fftWrapper.performFFT2D(wraps ? input : TensorView<const float>(staged), fft_input, flags) !=
+        FFTStatus::SUCCESS) {
+        throw std::runtime_error("FFT planning failed");
+    }
+
+    // Y[b][k] = sum over c of X[b][c] * W[k][c] / N; every output spectrum
+    // is accumulated by one thread, the first channel overwriting it
+    int outputs = input.batch() * out_channels;
+    float scale = 1.0f / (static_cast<float>(fft_rows) * fft_cols);
+    int threads = parallelThreads(static_cast<double>(outputs) * in_channels * fft_rows * spectrum_cols);
+    {
+        ScopedStage stage(Stage::MULTIPLY);
+        #pragma omp parallel for num_threads(threads) schedule(static)
+        for (int n = 0; n < outputs; ++n) {
+            int b = n / out_channels;
+            int k = n % out_channels;
+            for (int c = 0; c < in_channels; ++c) {
+                for (int i = 0; i < fft_rows; ++i) {
+                    std::complex<float>* acc = fft_output.row(b, k, i);
+                    const std::complex<float>* x = fft_input.row(b, c, i);
+                    const std::complex<float>* w = fft_filters.row(k, c, i);
+                    if (c == 0) {
+                        complexMultiply(acc, x, w, spectrum_cols, scale);
+                    } else {
+                        complexMultiplyAccumulate(acc, x, w, spectrum_cols, scale);
+                    }
+                }
+            }
+        }
+    }
+
+    if (fftWrapper.performInverseFFT2D(fft_output, accumulated, flags, false) != FFTStatus::SUCCESS) {
+        throw std::runtime_error("FFT planning failed");
+    }
+
+    int crop_top = cropOffset(input.rows(), kernel_rows, padding);
+    int crop_left = cropOffset(input.cols(), kernel_cols, padding);
+    threads = parallelThreads(static_cast<double>(outputs) * output_rows * output_cols);
+    ScopedStage stage(Stage::CROP);
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (int n = 0; n < outputs; ++n) {
+        for (int i = 0; i < output_rows; ++i) {
+            const float* src = accumulated.row(n / out_channels, n % out_channels, (i + crop_top) % fft_rows);
+            cropRow(src, fft_cols, crop_left, output_cols, output.row(n / out_channels, n % out_channels, i));
+        }
+    }
+}
+
+// ------------------- Strided Convolution -------------------
+
+// Polyphase split of one axis for a stride s. Kernel phase r holds taps
+// r, r + s, ...; it meets input phase b = (k - 1 - r) mod s at a delay of
+// a = (k - 1 - r) / s. Every kernel phase is shifted by A - a (A = a of
+// phase 0) so all phase products line up and can be summed.
+struct PolyphaseAxis {
+    int stride;
+    int phases;       // kernel phases with at least one tap
+    int delay;        // A
+    int kernel_size;  // extent of the shifted kernel phases
+    int signal_size;  // extent of the longest input phase
+    int fft_size;
+
+    PolyphaseAxis(int padded_size, int k, int s) : stride(s) {
+        phases = std::min(s, k);
+        delay = (k - 1) / s;
+        kernel_size = 0;
+        for (int r = 0; r < phases; ++r) {
+            int taps = (k - r + s - 1) / s;
+            kernel_size = std::max(kernel_size, delay - (k - 1 - r) / s + taps);
+        }
+        signal_size = (padded_size + s - 1) / s;
+        fft_size = nextSmoothSize(signal_size + kernel_size - 1);
+    }
+    int inputPhase(int k, int r) const { return (k - 1 - r) % stride; }
+    int shift(int k, int r) const { return delay - (k - 1 - r) / stride; }
+};
+
+void fftConvolveStrided2D(const TensorView<const float>& image,
+                          const TensorView<const float>& kernel,
+                          const TensorView<float>& output,
+                          Padding padding,
+                          float pad_val,
+                          int stride_rows,
+                          int stride_cols,
+                          Flags flags) {
+    int kernel_rows = kernel.rows();
+    int kernel_cols = kernel.cols();
+    int full_rows = convolutionOutputSize(image.rows(), kernel_rows, padding);
+    int full_cols = convolutionOutputSize(image.cols(), kernel_cols, padding);
+    int output_rows = convolutionOutputSize(image.rows(), kernel_rows, padding, stride_rows);
+    int output_cols = convolutionOutputSize(image.cols(), kernel_cols, padding, stride_cols);
+
+    if (image.empty() || kernel.empty() || full_rows <= 0 || full_cols <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the image");
+    }
+    if (output.rows() != output_rows || output.cols() != output_cols ||
+        output.channels() != image.channels() || output.batch() != image.batch()) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
+
+    // Axes of the padded image, which is sampled but never materialized
+    int padded_rows = full_rows + kernel_rows - 1;
+    int padded_cols = full_cols + kernel_cols - 1;
+    int top = paddingBefore(kernel_rows, padding);
+    int left = paddingBefore(kernel_cols, padding);
+    float fill = padding == Padding::CONSTANT ? pad_val : 0.0f;
+    PolyphaseAxis y(padded_rows, kernel_rows, stride_rows);
+    PolyphaseAxis x(padded_cols, kernel_cols, stride_cols);
+    int phases = y.phases * x.phases;
+    int spectrum_cols = x.fft_size / 2 + 1;
+    int images = image.batch() * image.channels();
+
+    // Input phases of every image, transformed by one batched plan
+    WorkspaceFrame frame;
+    TensorView<float> staged = frame.tensor(y.fft_size, x.fft_size, phases, images, 2 * spectrum_cols);
+    paddedIndex(-1, 1, padding);  // reject unknown modes outside the parallel loop
+    int threads = parallelThreads(static_cast<double>(images) * padded_rows * padded_cols);
+    {
+        ScopedStage stage(Stage::PAD);
+        #pragma omp parallel for num_threads(threads) schedule(static)
+        for (int n = 0; n < images; ++n) {
+            TensorView<const float> source = image.image(n / image.channels(), n % image.channels());
+            for (int ry = 0; ry < y.phases; ++ry) {
+                int by = y.inputPhase(kernel_rows, ry);
+                for (int rx = 0; rx < x.phases; ++rx) {
+                    int bx = x.inputPhase(kernel_cols, rx);
+                    TensorView<float> phase = staged.image(n, ry * x.phases + rx);
+                    for (int t = 0; t * stride_rows + by < padded_rows; ++t) {
+                        float* out = phase.row(0, 0, t);
+                        int src_row = paddedIndex(t * stride_rows + by - top, image.rows(), padding);
+                        const float* in = src_row < 0 ? nullptr : source.row(0, 0, src_row);
+                        for (int u = 0; u * stride_cols + bx < padded_cols; ++u) {
+                            int src_col = paddedIndex(u * stride_cols + bx - left, image.cols(), padding);
+                            out[u] = in && src_col >= 0 ? in[src_col] : fill;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Shifted kernel phases, whose spectra are cached like any other kernel
+    std::vector<std::shared_ptr<const KernelSpectrum>> kernel_phases;
+    TensorView<float> kernel_phase = frame.tensor(y.kernel_size, x.kernel_size);
+    for (int ry = 0; ry < y.phases; ++ry) {
+        for (int rx = 0; rx < x.phases; ++rx) {
+            std::fill(kernel_phase.data(), kernel_phase.data() + y.kernel_size * x.kernel_size, 0.0f);
+            for (int q = 0; q * stride_rows + ry < kernel_rows; ++q) {
+                for (int p = 0; p * stride_cols + rx < kernel_cols; ++p) {
+                    kernel_phase(y.shift(kernel_rows, ry) + q, x.shift(kernel_cols, rx) + p) =
+                        kernel(q * stride_rows + ry, p * stride_cols + rx);
+                }
+            }
+            kernel_phases.push_back(cachedKernelSpectrum(kernel_phase, 2, y.fft_size, x.fft_size, flags));
+        }
+    }
+
+    TensorView<std::complex<float>> fft_phases = spectrumView(staged, y.fft_size, spectrum_cols);
+    FFTWrapper fftWrapper;
+    if (fftWrapper.performFFT2D(staged, fft_phases, flags) != FFTStatus::SUCCESS) {
+        throw std::runtime_error("FFT planning failed");
+    }
+
+    // Sum of the phase products with the 1/N folded in, one decimated
+    // spectrum per image
+    TensorView<float> accumulated = frame.tensor(y.fft_size, x.fft_size, 1, images, 2 * spectrum_cols);
+    TensorView<std::complex<float>> fft_output = spectrumView(accumulated, y.fft_size, spectrum_cols);
+    float scale = 1.0f / (static_cast<float>(y.fft_size) * x.fft_size);
+    threads = parallelThreads(static_cast<double>(images) * phases * y.fft_size * spectrum_cols);
+    {
+        ScopedStage stage(Stage::MULTIPLY);
+        #pragma omp parallel for num_threads(threads) schedule(static)
+        for (int n = 0; n < images; ++n) {
+            for (int phase = 0; phase < phases; ++phase) {
+                TensorView<std::complex<float>> fft_kernel = kernel_phases[phase]->spectrum();
+                for (int i = 0; i < y.fft_size; ++i) {
+                    std::complex<float>* acc = fft_output.row(n, 0, i);
+                    const std::complex<float>* in = fft_phases.row(n, phase, i);
+                    const std::complex<float>* w = fft_kernel.row(0, 0, i);
+                    if (phase == 0) {
+                        complexMultiply(acc, in, w, spectrum_cols, scale);
+                    } else {
+                        complexMultiplyAccumulate(acc, in, w, spectrum_cols, scale);
+                    }
+                }
+            }
+        }
+    }
+
+    if (fftWrapper.performInverseFFT2D(fft_output, accumulated, flags, false) != FFTStatus::SUCCESS) {
+        throw std::runtime_error("FFT planning failed");
+    }
+
+    ScopedStage stage(Stage::CROP);
+    for (int n = 0; n < images; ++n) {
+        int b = n / image.channels();
+        int c = n % image.channels();
+        for (int i = 0; i < output_rows; ++i) {
+            const float* src = accumulated.row(n, 0, i + y.delay) + x.delay;
+            std::copy(src, src + output_cols, output.row(b, c, i));
+        }
+    }
+}
+
+// ------------------- Workspace Sizes -------------------
+
+std::size_t fftConvolution1DWorkspace(int signals, int cols, int kernel_size, Padding padding) {
+    int fft_size = fftConvolutionSize(cols, kernel_size, padding);
+    return workspaceTensorBytes(signals, fft_size, 1, 1, 2 * (fft_size / 2 + 1));
+}
+
+std::size_t fftConvolutionWorkspace(int rows, int cols, int kernel_rows, int kernel_cols, int images, Padding padding) {
+    int fft_rows = fftConvolutionSize(rows, kernel_rows, padding);
+    int fft_cols = fftConvolutionSize(cols, kernel_cols, padding);
+    return workspaceTensorBytes(fft_rows, fft_cols, images, 1, 2 * (fft_cols / 2 + 1));
+}
+
+std::size_t fftLayerWorkspace(int rows, int cols, int kernel_rows, int kernel_cols,
+                              int in_channels, int out_channels, int batch, Padding padding) {
+    int fft_rows = fftConvolutionSize(rows, kernel_rows, padding);
+    int fft_cols = fftConvolutionSize(cols, kernel_cols, padding);
+    int pitch = 2 * (fft_cols / 2 + 1);
+    return workspaceTensorBytes(fft_rows, fft_cols, in_channels, batch, pitch) +
+           workspaceTensorBytes(fft_rows, fft_cols, out_channels, batch, pitch);
+}
+
+std::size_t fftStridedConvolutionWorkspace(int rows, int cols, int kernel_rows, int kernel_cols, int images,
+                                           Padding padding, int stride_rows, int stride_cols) {
+    PolyphaseAxis y(convolutionOutputSize(rows, kernel_rows, padding) + kernel_rows - 1, kernel_rows, stride_rows);
+    PolyphaseAxis x(convolutionOutputSize(cols, kernel_cols, padding) + kernel_cols - 1, kernel_cols, stride_cols);
+    int pitch = 2 * (x.fft_size / 2 + 1);
+    return workspaceTensorBytes(y.fft_size, x.fft_size, y.phases * x.phases, images, pitch) +
+           workspaceTensorBytes(y.kernel_size, x.kernel_size) +
+           workspaceTensorBytes(y.fft_size, x.fft_size, 1, images, pitch);
+}
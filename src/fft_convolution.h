@@ -0,0 +1,144 @@
+#ifndef FFT_CONVOLUTION_H
+#define FFT_CONVOLUTION_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "FFTWrapper.h"
+#include "Tensor.h"
+#include "padding.h"
+
+// Smallest 2/3/5/7-smooth integer >= n (sizes FFTW transforms fastest)
+int nextSmoothSize(int n);
+
+// Transform extents used by fftConvolve2D for one axis
+int fftConvolutionSize(int size, int kernel_size, Padding padding);
+
+// Spectrum of one kernel, zero-padded to a transform size
+struct KernelSpectrum {
+    int rank;         // 1: a 1 x kernel_cols kernel transformed along rows; 2: r2c_2d
+    int kernel_rows;
+    int kernel_cols;
+    int fft_rows;     // 1 for rank 1
+    int fft_cols;
+    Tensor<float> data;  // half spectrum in rows of 2 * (fft_cols / 2 + 1) floats
+
+    TensorView<std::complex<float>> spectrum() const;
+};
+
+// Spectrum of `kernel` at the given transform shape. Spectra come from a
+// process-wide LRU cache keyed by a hash of the kernel's contents and the
+// transform shape, so applying the same kernel repeatedly transforms it once.
+std::shared_ptr<const KernelSpectrum> cachedKernelSpectrum(const TensorView<const float>& kernel,
+                                                           int rank, int fft_rows, int fft_cols,
+                                                           Flags flags);
+
+// Content keys of the kernel caches: an FNV-1a hash of the kernel's shape
+// and coefficient bits, and an exact comparison against a row-major copy
+// of the coefficients to rule out collisions
+std::uint64_t kernelContentHash(const TensorView<const float>& kernel);
+bool sameCoefficients(const std::vector<float>& raw, const TensorView<const float>& kernel);
+
+// Spectrum cache bounds (16 entries by default) and inspection
+void setKernelSpectrumCacheCapacity(std::size_t entries);
+std::size_t kernelSpectrumCacheSize();
+void clearKernelSpectrumCache();
+
+// 1D spectral convolution of every row of `signals` with a prepared 1D
+// kernel spectrum (of fftConvolutionSize(cols, kernel, padding) points);
+// all rows go through one batched r2c and one batched c2r
+void fftConvolve1D(const TensorView<const float>& signals,
+                   const KernelSpectrum& kernel,
+                   const TensorView<float>& output,
+                   Padding padding,
+                   float pad_val,
+                   Flags flags);
+
+// Batched 1D spectral convolution of every row of `signals` ([signals]
+// [length], one image) with `kernels`: one kernel row shared by every
+// signal, or one row per signal. The rows are split into one contiguous
+// slice per thread; a slice is staged in its thread's workspace and goes
+// through one batched r2c and one batched c2r (plus one batched r2c of its
+// per-signal kernels), so the plans are shared by the whole batch.
+void fftConvolveBatch1D(const TensorView<const float>& signals,
+                        const TensorView<const float>& kernels,
+                        const TensorView<float>& output,
+                        Padding padding,
+                        float pad_val,
+                        Flags flags);
+
+// 2D spectral convolution of every image of `image` with a prepared kernel
+// spectrum: one r2c_2d transform per image at 2/3/5/7-smooth extents, a
+// pointwise product over the half spectrum and one c2r_2d transform, after
+// which the valid/same/full region is cropped into `output`
+void fftConvolve2D(const TensorView<const float>& image,
+                   const KernelSpectrum& kernel,
+                   const TensorView<float>& output,
+                   Padding padding,
+                   float pad_val,
+                   Flags flags);
+
+// Same, taking the kernel spectrum from the cache
+void fftConvolve2D(const TensorView<const float>& image,
+                   const TensorView<const float>& kernel,
+                   const TensorView<float>& output,
+                   Padding padding,
+                   float pad_val,
+                   Flags flags);
+
+// Strided 2D convolution that only produces every stride-th output row and
+// column. The padded image and the kernel are split into stride_rows x
+// stride_cols polyphase components; the products of matching components
+// are summed in the frequency domain, so every transform (and the single
+// inverse per image) is smaller than the full-resolution one by the stride.
+void fftConvolveStrided2D(const TensorView<const float>& image,
+                          const TensorView<const float>& kernel,
+                          const TensorView<float>& output,
+                          Padding padding,
+                          float pad_val,
+                          int stride_rows,
+                          int stride_cols,
+                          Flags flags);
+
+// A filter bank [out][in][kh][kw] transformed once at the transform size
+// used for inputs of a given extent and padding
+struct FilterSpectra {
+    int kernel_rows;
+    int kernel_cols;
+    int fft_rows;
+    int fft_cols;
+    Tensor<float> data;  // [out][in] half spectra in rows of 2 * (fft_cols / 2 + 1) floats
+};
+
+// Transform every filter of `filters` with one batched r2c_2d plan
+FilterSpectra fftTransformFilters(const TensorView<const float>& filters,
+                                  int rows, int cols,
+                                  Padding padding,
+                                  Flags flags);
+
+// Multi-channel spectral convolution: `input` is [batch][in][rows][cols],
+// `output` is [batch][out][...]. Every input channel is transformed once
+// (one batched plan for the whole batch), the in products are accumulated
+// in the frequency domain and each output channel takes a single inverse
+// transform, so in x out pairs cost batch x (in + out) transforms.
+void fftConvolveLayer(const TensorView<const float>& input,
+                      const FilterSpectra& filters,
+                      const TensorView<float>& output,
+                      Padding padding,
+                      float pad_val,
+                      Flags flags);
+
+// Workspace bytes (see workspace.h) fftConvolve1D, fftConvolve2D,
+// fftConvolveLayer and fftConvolveStrided2D take from the calling thread's
+// workspace; `signals` and `images` count rows x channels x batch and
+// channels x batch respectively
+std::size_t fftConvolution1DWorkspace(int signals, int cols, int kernel_size, Padding padding);
+std::size_t fftConvolutionWorkspace(int rows, int cols, int kernel_rows, int kernel_cols, int images, Padding padding);
+std::size_t fftLayerWorkspace(int rows, int cols, int kernel_rows, int kernel_cols,
+                              int in_channels, int out_channels, int batch, Padding padding);
+std::size_t fftStridedConvolutionWorkspace(int rows, int cols, int kernel_rows, int kernel_cols, int images,
+                                           Padding padding, int stride_rows, int stride_cols);
+
+#endif  // FFT_CONVOLUTION_H
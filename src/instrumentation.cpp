@@ -0,0 +1,279 @@
+#include "instrumentation.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+const char* stageName(Stage stage) {
+    switch (stage) {
+        case Stage::PAD: return "pad";
+        case Stage::PLAN: return "plan";
+        case Stage::FORWARD_FFT: return "forward_fft";
+        case Stage::MULTIPLY: return "multiply";
+        case Stage::INVERSE_FFT: return "inverse_fft";
+        case Stage::CROP: return "crop";
+        case Stage::DIRECT: return "direct";
+        case Stage::WINOGRAD: return "winograd";
+        case Stage::SEPARABLE: return "separable";
+        case Stage::COUNT: break;
+    }
+    return "?";
+}
+
+const char* counterName(Counter counter) {
+    switch (counter) {
+        case Counter::ALLOCATIONS: return "allocations";
+        case Counter::ALLOCATED_BYTES: return "allocated_bytes";
+        case Counter::PLAN_CACHE_HITS: return "plan_cache_hits";
+        case Counter::PLAN_CACHE_MISSES: return "plan_cache_misses";
+        case Counter::SPECTRUM_CACHE_HITS: return "spectrum_cache_hits";
+        case Counter::SPECTRUM_CACHE_MISSES: return "spectrum_cache_misses";
+        case Counter::DECOMPOSITION_CACHE_HITS: return "decomposition_cache_hits";
+        case Counter::DECOMPOSITION_CACHE_MISSES: return "decomposition_cache_misses";
+        case Counter::COUNT: break;
+    }
+    return "?";
+}
+
+namespace {
+
+std::string toJSON(const InstrumentationSnapshot& snapshot);
+bool writeFile(const std::string& path, const std::string& contents);
+
+}  // namespace
+
+#ifndef KERNELFLOW_NO_INSTRUMENTATION
+
+namespace {
+
+struct TraceEvent {
+    Stage stage;
+    std::int64_t start_ns;
+    std::int64_t duration_ns;
+};
+
+// Bounds the trace memory of a single thread (about 24 MB)
+const std::size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+// Written only by the owning thread; relaxed atomics let snapshots read the
+// totals of running threads without a lock on the hot path
+struct ThreadCounters {
+    int tid = 0;
+    std::atomic<std::uint64_t> stage_calls[STAGE_COUNT] = {};
+    std::atomic<std::uint64_t> stage_nanoseconds[STAGE_COUNT] = {};
+    std::atomic<std::uint64_t> counters[COUNTER_COUNT] = {};
+    std::mutex events_mutex;
+    std::vector<TraceEvent> events;
+};
+
+using ThreadList = std::vector<std::shared_ptr<ThreadCounters>>;
+
+InstrumentationSnapshot sum(const ThreadList& threads);
+bool writeTrace(const ThreadList& threads, const std::string& path);
+
+// Owns every thread's counters, so totals survive the threads that made
+// them, and writes the files named by the environment at exit
+class Registry {
+private:
+    std::mutex mutex;
+    ThreadList threads;
+    std::string profile_path;
+    std::string trace_path;
+
+public:
+    std::atomic<bool> tracing{false};
+
+    Registry() {
+        if (const char* path = std::getenv("KERNELFLOW_PROFILE")) profile_path = path;
+        if (const char* path = std::getenv("KERNELFLOW_TRACE")) trace_path = path;
+        tracing = !trace_path.empty();
+    }
+
+    ~Registry() {
+        if (!profile_path.empty()) writeFile(profile_path, toJSON(sum(threads)));
+        if (!trace_path.empty()) writeTrace(threads, trace_path);
+    }
+
+    std::shared_ptr<ThreadCounters> add() {
+        auto counters = std::make_shared<ThreadCounters>();
+        std::lock_guard<std::mutex> lock(mutex);
+        counters->tid = static_cast<int>(threads.size());
+        threads.push_back(counters);
+        return counters;
+    }
+
+    ThreadList all() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return threads;
+    }
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+// Constructed during static initialization, so the environment is read
+// and the exit-time dump registered before the first probe fires
+Registry& registry_at_startup = registry();
+
+ThreadCounters& local() {
+    thread_local std::shared_ptr<ThreadCounters> counters = registry().add();
+    return *counters;
+}
+
+const std::chrono::steady_clock::time_point clock_origin = std::chrono::steady_clock::now();
+
+void bump(std::atomic<std::uint64_t>& value, std::uint64_t amount) {
+    // Single writer, so a load and store is enough
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+std::int64_t instrumentationClock() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - clock_origin)
+        .count();
+}
+
+void recordStage(Stage stage, std::int64_t start_ns, std::int64_t end_ns) {
+    ThreadCounters& counters = local();
+    int index = static_cast<int>(stage);
+    bump(counters.stage_calls[index], 1);
+    bump(counters.stage_nanoseconds[index], static_cast<std::uint64_t>(end_ns - start_ns));
+    if (registry().tracing.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(counters.events_mutex);
+        if (counters.events.size() < MAX_EVENTS_PER_THREAD) {
+            counters.events.push_back(TraceEvent{stage, start_ns, end_ns - start_ns});
+        }
+    }
+}
+
+void countEvent(Counter counter, std::uint64_t amount) {
+    bump(local().counters[static_cast<int>(counter)], amount);
+}
+
+InstrumentationSnapshot instrumentationSnapshot() {
+    return sum(registry().all());
+}
+
+void resetInstrumentation() {
+    // Counters of threads still inside a probe may keep a partial update
+    for (const auto& thread : registry().all()) {
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            thread->stage_calls[s].store(0, std::memory_order_relaxed);
+            thread->stage_nanoseconds[s].store(0, std::memory_order_relaxed);
+        }
+        for (int c = 0; c < COUNTER_COUNT; ++c) {
+            thread->counters[c].store(0, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(thread->events_mutex);
+        thread->events.clear();
+    }
+}
+
+void setTraceEnabled(bool enabled) {
+    registry().tracing = enabled;
+}
+
+bool traceEnabled() {
+    return registry().tracing;
+}
+
+bool writeChromeTrace(const std::string& path) {
+    return writeTrace(registry().all(), path);
+}
+
+namespace {
+
+InstrumentationSnapshot sum(const ThreadList& threads) {
+    InstrumentationSnapshot snapshot;
+    for (const auto& thread : threads) {
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            snapshot.stage_calls[s] += thread->stage_calls[s].load(std::memory_order_relaxed);
+            snapshot.stage_nanoseconds[s] += thread->stage_nanoseconds[s].load(std::memory_order_relaxed);
+        }
+        for (int c = 0; c < COUNTER_COUNT; ++c) {
+            snapshot.counters[c] += thread->counters[c].load(std::memory_order_relaxed);
+        }
+    }
+    return snapshot;
+}
+
+bool writeTrace(const ThreadList& threads, const std::string& path) {
+    std::ostringstream trace;
+    trace << std::fixed << std::setprecision(3) << "{\"traceEvents\": [";
+    bool first = true;
+    for (const auto& thread : threads) {
+        std::lock_guard<std::mutex> lock(thread->events_mutex);
+        for (const TraceEvent& event : thread->events) {
+            // Complete ("X") events, timestamps in microseconds
+            trace << (first ? "" : ",") << "\n  {\"name\": \"" << stageName(event.stage)
+                  << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread->tid
+                  << ", \"ts\": " << event.start_ns / 1000.0 << ", \"dur\": " << event.duration_ns / 1000.0 << "}";
+            first = false;
+        }
+    }
+    trace << "\n], \"displayTimeUnit\": \"ns\"}\n";
+    return writeFile(path, trace.str());
+}
+
+}  // namespace
+
+#else
+
+InstrumentationSnapshot instrumentationSnapshot() {
+    return InstrumentationSnapshot();
+}
+
+void resetInstrumentation() {}
+
+void setTraceEnabled(bool) {}
+
+bool traceEnabled() {
+    return false;
+}
+
+bool writeChromeTrace(const std::string& path) {
+    return writeFile(path, "{\"traceEvents\": []}\n");
+}
+
+#endif  // KERNELFLOW_NO_INSTRUMENTATION
+
+namespace {
+
+std::string toJSON(const InstrumentationSnapshot& snapshot) {
+    std::ostringstream json;
+    json << "{\n  \"stages\": {";
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        json << (s ? "," : "") << "\n    \"" << stageName(static_cast<Stage>(s)) << "\": {\"calls\": "
+             << snapshot.stage_calls[s] << ", \"ns\": " << snapshot.stage_nanoseconds[s] << "}";
+    }
+    json << "\n  },\n  \"counters\": {";
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        json << (c ? "," : "") << "\n    \"" << counterName(static_cast<Counter>(c)) << "\": " << snapshot.counters[c];
+    }
+    json << "\n  }\n}\n";
+    return json.str();
+}
+
+bool writeFile(const std::string& path, const std::string& contents) {
+    std::ofstream file(path, std::ios::trunc);
+    file << contents;
+    return static_cast<bool>(file);
+}
+
+}  // namespace
+
+std::string instrumentationJSON() {
+    return toJSON(instrumentationSnapshot());
+}
+
+bool writeInstrumentationJSON(const std::string& path) {
+    return writeFile(path, instrumentationJSON());
+}
@@ -0,0 +1,109 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Hot-path instrumentation: per-stage timers and event counters, kept in
+// per-thread storage and summed on demand. Building with
+// -DKERNELFLOW_NO_INSTRUMENTATION (make INSTRUMENT=0) compiles every probe
+// out.
+//
+// Setting KERNELFLOW_PROFILE=<path> writes the totals as JSON at exit;
+// KERNELFLOW_TRACE=<path> also records every stage as an event and writes
+// a Chrome trace (chrome://tracing, Perfetto) at exit.
+
+enum class Stage {
+    PAD,          // staging the (padded) input
+    PLAN,         // creating an FFTW plan on a plan cache miss
+    FORWARD_FFT,  // real-to-complex transforms (planning included)
+    MULTIPLY,     // pointwise spectrum products and accumulation
+    INVERSE_FFT,  // complex-to-real transforms and normalization
+    CROP,         // copying results out of the staging buffers
+    DIRECT,       // whole direct-backend calls
+    WINOGRAD,     // whole Winograd-backend calls
+    SEPARABLE,    // whole separable-backend calls
+    COUNT
+};
+
+enum class Counter {
+    ALLOCATIONS,            // Tensor and plan scratch allocations
+    ALLOCATED_BYTES,
+    PLAN_CACHE_HITS,
+    PLAN_CACHE_MISSES,
+    SPECTRUM_CACHE_HITS,    // kernel spectrum cache
+    SPECTRUM_CACHE_MISSES,
+    DECOMPOSITION_CACHE_HITS,    // separable kernel decompositions
+    DECOMPOSITION_CACHE_MISSES,
+    COUNT
+};
+
+const int STAGE_COUNT = static_cast<int>(Stage::COUNT);
+const int COUNTER_COUNT = static_cast<int>(Counter::COUNT);
+
+// Totals over every thread since start or the last reset. Stage times are
+// inclusive: a plan created inside a forward transform counts for both.
+struct InstrumentationSnapshot {
+    std::uint64_t stage_calls[STAGE_COUNT] = {};
+    std::uint64_t stage_nanoseconds[STAGE_COUNT] = {};
+    std::uint64_t counters[COUNTER_COUNT] = {};
+
+    std::uint64_t calls(Stage stage) const { return stage_calls[static_cast<int>(stage)]; }
+    std::uint64_t nanoseconds(Stage stage) const { return stage_nanoseconds[static_cast<int>(stage)]; }
+    std::uint64_t count(Counter counter) const { return counters[static_cast<int>(counter)]; }
+};
+
+const char* stageName(Stage stage);
+const char* counterName(Counter counter);
+
+InstrumentationSnapshot instrumentationSnapshot();
+void resetInstrumentation();
+
+// Record stage events for a Chrome trace (on when KERNELFLOW_TRACE is set)
+void setTraceEnabled(bool enabled);
+bool traceEnabled();
+
+// Totals as JSON, and recorded events in Chrome trace format; false if the
+// file could not be written
+std::string instrumentationJSON();
+bool writeInstrumentationJSON(const std::string& path);
+bool writeChromeTrace(const std::string& path);
+
+#ifndef KERNELFLOW_NO_INSTRUMENTATION
+
+void recordStage(Stage stage, std::int64_t start_ns, std::int64_t end_ns);
+void countEvent(Counter counter, std::uint64_t amount = 1);
+std::int64_t instrumentationClock();
+
+// Times the enclosing scope as one call of `stage`
+class ScopedStage {
+private:
+    Stage stage;
+    std::int64_t start;
+
+public:
+    explicit ScopedStage(Stage s) : stage(s), start(instrumentationClock()) {}
+    ~ScopedStage() { recordStage(stage, start, instrumentationClock()); }
+    ScopedStage(const ScopedStage&) = delete;
+    ScopedStage& operator=(const ScopedStage&) = delete;
+};
+
+inline void countAllocation(std::size_t bytes) {
+    countEvent(Counter::ALLOCATIONS);
+    countEvent(Counter::ALLOCATED_BYTES, bytes);
+}
+
+#else
+
+class ScopedStage {
+public:
+    explicit ScopedStage(Stage) {}
+};
+
+inline void countEvent(Counter, std::uint64_t = 1) {}
+inline void countAllocation(std::size_t) {}
+
+#endif  // KERNELFLOW_NO_INSTRUMENTATION
+
+#endif  // INSTRUMENTATION_H
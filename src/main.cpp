@@ -0,0 +1,79 @@
+#include <iostream>
+#include <vector>
+#include <iomanip>
+#include "convolution.h"
+
+// Function to print a 1D vector
+void print1DVector(const std::vector<float>& vec) {
+    for (const auto& val : vec) {
+        std::cout << std::fixed << std::setprecision(2) << val << " ";
+    }
+    std::cout << std::endl;
+}
+
+// Function to print a 2D vector
+void print2DVector(const std::vector<std::vector<float>>& mat) {
+    for (const auto& row : mat) {
+        for (const auto& val : row) {
+            std::cout << std::fixed << std::setprecision(2) << val << " ";
+        }
+        std::cout << std::endl;
+    }
+}
+
+int main() {
+    FFTWrapper fftWrapper;
+
+    // Test 1D Convolution
+    std::vector<float> signal = {1, 2, 3, 4};
+    std::vector<float> kernel = {1, 0, -1};
+    
+    std::cout << "1D Convolution Test:" << std::endl;
+
+    std::vector<float> output_signal = convolve(signal, kernel, 1, Padding::ZERO);
+    std::cout << "Output with ZERO padding:" << std::endl;
+    print1DVector(output_signal);
+
+    output_signal = convolve(signal, kernel, 1, Padding::CONSTANT, 2.0);
+    std::cout << "Output with CONSTANT padding (value 2.0):" << std::endl;
+    print1DVector(output_signal);
+
+    output_signal = convolve(signal, kernel, 1, Padding::REPLICATE);
+    std::cout << "Output with REPLICATE padding:" << std::endl;
+    print1DVector(output_signal);
+
+    output_signal = convolve(signal, kernel, 1, Padding::REFLECT);
+    std::cout << "Output with REFLECT padding:" << std::endl;
+    print1DVector(output_signal);
+
+    // Test 2D Convolution
+    std::vector<std::vector<float>> image = {
+        {1, 2, 3},
+        {4, 5, 6},
+        {7, 8, 9}
+    };
+    std::vector<std::vector<float>> kernel2D = {
+        {1, 0},
+        {-1, 1}
+    };
+
+    std::cout << "\n2D Convolution Test:" << std::endl;
+
+    std::vector<std::vector<float>> output_image = convolve(image, kernel2D, 1, Padding::ZERO);
+    std::cout << "Output with ZERO padding:" << std::endl;
+    print2DVector(output_image);
+
+    output_image = convolve(image, kernel2D, 1, Padding::CONSTANT, 2.0);
+    std::cout << "Output with CONSTANT padding (value 2.0):" << std::endl;
+    print2DVector(output_image);
+
+    output_image = convolve(image, kernel2D, 1, Padding::REPLICATE);
+    std::cout << "Output with REPLICATE padding:" << std::endl;
+    print2DVector(output_image);
+
+    output_image = convolve(image, kernel2D, 1, Padding::REFLECT);
+    std::cout << "Output with REFLECT padding:" << std::endl;
+    print2DVector(output_image);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,403 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "conv_engine.h"
+#include "mapped_image.h"
+#include "workspace.h"
+
+static const char KFIM_MAGIC[4] = {'K', 'F', 'I', 'M'};
+static const std::uint32_t KFIM_VERSION = 1;
+static const std::size_t KFIM_HEADER_BYTES = 64;
+
+// Target staged input per strip, in floats
+static const std::size_t STRIP_FLOATS = std::size_t(1) << 20;
+
+struct KfimHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t rows;
+    std::uint32_t cols;
+    std::uint32_t channels;
+    std::uint32_t tile_rows;
+    std::uint32_t tile_cols;
+};
+
+static void checkShape(int rows, int cols, int channels, int tile_rows, int tile_cols) {
+    if (rows < 1 || cols < 1 || channels < 1) {
+        throw std::invalid_argument("Image dimensions must be positive");
+    }
+    if (tile_rows < 0 || tile_cols < 0 || (tile_rows == 0) != (tile_cols == 0)) {
+        throw std::invalid_argument("Tile size must be positive, or 0 for row-major images");
+    }
+}
+
+static int ceilDiv(int a, int b) {
+    return (a + b - 1) / b;
+}
+
+MappedImage::MappedImage()
+    : mapping(nullptr), mappedBytes(0), pixels(nullptr), nRows(0), nCols(0), nChannels(0), tileHeight(0),
+      tileWidth(0), isWritable(false) {}
+
+MappedImage::~MappedImage() {
+    close();
+}
+
+MappedImage::MappedImage(MappedImage&& other) noexcept
+    : mapping(other.mapping), mappedBytes(other.mappedBytes), pixels(other.pixels), nRows(other.nRows),
+      nCols(other.nCols), nChannels(other.nChannels), tileHeight(other.tileHeight), tileWidth(other.tileWidth),
+      isWritable(other.isWritable) {
+    other.mapping = nullptr;
+    other.close();
+}
+
+MappedImage& MappedImage::operator=(MappedImage&& other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(mapping, other.mapping);
+        std::swap(mappedBytes, other.mappedBytes);
+        std::swap(pixels, other.pixels);
+        std::swap(nRows, other.nRows);
+        std::swap(nCols, other.nCols);
+        std::swap(nChannels, other.nChannels);
+        std::swap(tileHeight, other.tileHeight);
+        std::swap(tileWidth, other.tileWidth);
+        std::swap(isWritable, other.isWritable);
+    }
+    return *this;
+}
+
+void MappedImage::close() {
+    if (mapping) {
+        munmap(mapping, mappedBytes);
+    }
+    mapping = nullptr;
+    mappedBytes = 0;
+    pixels = nullptr;
+    nRows = nCols = nChannels = tileHeight = tileWidth = 0;
+    isWritable = false;
+}
+
+std::size_t MappedImage::pixelBytes() const {
+    if (tiled()) {
+        std::size_t tiles = static_cast<std::size_t>(ceilDiv(nRows, tileHeight)) * ceilDiv(nCols, tileWidth);
+        return tiles * tileHeight * tileWidth * nChannels * sizeof(float);
+    }
+    return static_cast<std::size_t>(nRows) * nCols * nChannels * sizeof(float);
+}
+
+// Element offset of pixel (c, i, j); pixels run contiguously from there to
+// the end of the row or of its tile
+std::size_t MappedImage::offset(int c, int i, int j) const {
+    if (!tiled()) {
+        return (static_cast<std::size_t>(c) * nRows + i) * nCols + j;
+    }
+    std::size_t tile = (static_cast<std::size_t>(c) * ceilDiv(nRows, tileHeight) + i / tileHeight) *
+                           ceilDiv(nCols, tileWidth) + j / tileWidth;
+    return tile * tileHeight * tileWidth + static_cast<std::size_t>(i % tileHeight) * tileWidth + j % tileWidth;
+}
+
+// Map `offset` header bytes plus the pixels of the shape already set
+FFTStatus MappedImage::map(const std::string& path, std::size_t offset, bool writable, bool create) {
+    std::size_t bytes = offset + pixelBytes();
+    int fd = ::open(path.c_str(), writable ? O_RDWR | (create ? O_CREAT | O_TRUNC : 0) : O_RDONLY, 0644);
+    if (fd < 0) {
+        return FFTStatus::FAILURE;
+    }
+    struct stat info;
+    bool sized = create ? ftruncate(fd, static_cast<off_t>(bytes)) == 0
+                        : fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) == bytes;
+    void* addr = sized ? mmap(nullptr, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0)
+                       : MAP_FAILED;
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return FFTStatus::FAILURE;
+    }
+    mapping = addr;
+    mappedBytes = bytes;
+    pixels = reinterpret_cast<float*>(static_cast<char*>(addr) + offset);
+    isWritable = writable;
+    return FFTStatus::SUCCESS;
+}
+
+// ------------------- Opening and creating -------------------
+
+FFTStatus MappedImage::openRaw(const std::string& path, int rows, int cols, int channels, bool writable) {
+    checkShape(rows, cols, channels, 0, 0);
+    close();
+    nRows = rows;
+    nCols = cols;
+    nChannels = channels;
+    FFTStatus status = map(path, 0, writable, false);
+    if (status != FFTStatus::SUCCESS) {
+        close();
+    }
+    return status;
+}
+
+FFTStatus MappedImage::open(const std::string& path, bool writable) {
+    close();
+    KfimHeader header;
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            return FFTStatus::FAILURE;
+        }
+    }
+    if (std::memcmp(header.magic, KFIM_MAGIC, sizeof(KFIM_MAGIC)) != 0 || header.version != KFIM_VERSION ||
+        header.rows < 1 || header.cols < 1 || header.channels < 1 || header.rows > INT32_MAX ||
+        header.cols > INT32_MAX || header.channels > INT32_MAX || header.tile_rows > INT32_MAX ||
+        header.tile_cols > INT32_MAX || (header.tile_rows == 0) != (header.tile_cols == 0)) {
+        return FFTStatus::FAILURE;
+    }
+    nRows = static_cast<int>(header.rows);
+    nCols = static_cast<int>(header.cols);
+    nChannels = static_cast<int>(header.channels);
+    tileHeight = static_cast<int>(header.tile_rows);
+    tileWidth = static_cast<int>(header.tile_cols);
+    FFTStatus status = map(path, KFIM_HEADER_BYTES, writable, false);
+    if (status != FFTStatus::SUCCESS) {
+        close();
+    }
+    return status;
+}
+
+FFTStatus MappedImage::createRaw(const std::string& path, int rows, int cols, int channels) {
+    checkShape(rows, cols, channels, 0, 0);
+    close();
+    nRows = rows;
+    nCols = cols;
+    nChannels = channels;
+    FFTStatus status = map(path, 0, true, true);
+    if (status != FFTStatus::SUCCESS) {
+        close();
+    }
+    return status;
+}
+
+FFTStatus MappedImage::create(const std::string& path, int rows, int cols, int channels, int tile_rows,
+                              int tile_cols) {
+    checkShape(rows, cols, channels, tile_rows, tile_cols);
+    close();
+    nRows = rows;
+    nCols = cols;
+    nChannels = channels;
+    tileHeight = tile_rows;
+    tileWidth = tile_cols;
+    FFTStatus status = map(path, KFIM_HEADER_BYTES, true, true);
+    if (status != FFTStatus::SUCCESS) {
+        close();
+        return status;
+    }
+    KfimHeader header;
+    std::memcpy(header.magic, KFIM_MAGIC, sizeof(KFIM_MAGIC));
+    header.version = KFIM_VERSION;
+    header.rows = static_cast<std::uint32_t>(rows);
+    header.cols = static_cast<std::uint32_t>(cols);
+    header.channels = static_cast<std::uint32_t>(channels);
+    header.tile_rows = static_cast<std::uint32_t>(tile_rows);
+    header.tile_cols = static_cast<std::uint32_t>(tile_cols);
+    std::memcpy(mapping, &header, sizeof(header));
+    return FFTStatus::SUCCESS;
+}
+
+FFTStatus MappedImage::flush() {
+    if (mapping && isWritable && msync(mapping, mappedBytes, MS_SYNC) != 0) {
+        return FFTStatus::FAILURE;
+    }
+    return FFTStatus::SUCCESS;
+}
+
+// ------------------- Pixel access -------------------
+
+TensorView<const float> MappedImage::view() const {
+    if (!isOpen() || tiled()) {
+        throw std::invalid_argument("Only open row-major images have a view");
+    }
+    return TensorView<const float>(pixels, nRows, nCols, nChannels, 1);
+}
+
+TensorView<float> MappedImage::writableView() const {
+    if (!isWritable || tiled()) {
+        throw std::invalid_argument("Only writable row-major images have a writable view");
+    }
+    return TensorView<float>(pixels, nRows, nCols, nChannels, 1);
+}
+
+void MappedImage::readRows(int top, const TensorView<float>& rows) const {
+    if (top < 0 || top + rows.rows() > nRows || rows.cols() != nCols || rows.channels() != nChannels) {
+        throw std::out_of_range("Rows out of range of the mapped image");
+    }
+    for (int c = 0; c < nChannels; ++c) {
+        for (int i = 0; i < rows.rows(); ++i) {
+            float* out = rows.row(0, c, i);
+            for (int j = 0; j < nCols;) {
+                int run = tiled() ? std::min(tileWidth - j % tileWidth, nCols - j) : nCols;
+                const float* in = pixels + offset(c, top + i, j);
+                std::copy(in, in + run, out + j);
+                j += run;
+            }
+        }
+    }
+}
+
+void MappedImage::writeRows(int top, const TensorView<const float>& rows) const {
+    if (!isWritable) {
+        throw std::invalid_argument("Image is not writable");
+    }
+    if (top < 0 || top + rows.rows() > nRows || rows.cols() != nCols || rows.channels() != nChannels) {
+        throw std::out_of_range("Rows out of range of the mapped image");
+    }
+    for (int c = 0; c < nChannels; ++c) {
+        for (int i = 0; i < rows.rows(); ++i) {
+            const float* in = rows.row(0, c, i);
+            for (int j = 0; j < nCols;) {
+                int run = tiled() ? std::min(tileWidth - j % tileWidth, nCols - j) : nCols;
+                std::copy(in + j, in + j + run, pixels + offset(c, top + i, j));
+                j += run;
+            }
+        }
+    }
+}
+
+// madvise() the pages holding rows [top, top + count) of every channel:
+// one contiguous run per channel (whole tile rows for tiled images),
+// widened to page boundaries
+void MappedImage::advise(int top, int count, int advice) const {
+    int end = std::min(top + count, nRows);
+    top = std::max(top, 0);
+    if (!mapping || end <= top) {
+        return;
+    }
+    std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::size_t header = reinterpret_cast<char*>(pixels) - static_cast<char*>(mapping);
+    std::size_t mapped_end = (mappedBytes + page - 1) / page * page;
+    for (int c = 0; c < nChannels; ++c) {
+        std::size_t first, last;  // elements
+        if (tiled()) {
+            std::size_t band = static_cast<std::size_t>(ceilDiv(nCols, tileWidth)) * tileHeight * tileWidth;
+            std::size_t bands = ceilDiv(nRows, tileHeight);
+            first = (c * bands + top / tileHeight) * band;
+            last = (c * bands + (end - 1) / tileHeight + 1) * band;
+        } else {
+            first = offset(c, top, 0);
+            last = offset(c, end - 1, 0) + nCols;
+        }
+        std::size_t begin = (header + first * sizeof(float)) / page * page;
+        std::size_t finish = std::min((header + last * sizeof(float) + page - 1) / page * page, mapped_end);
+        char* start = static_cast<char*>(mapping) + begin;
+        if (advice == MADV_DONTNEED && isWritable) {
+            msync(start, finish - begin, MS_ASYNC);
+        }
+        madvise(start, finish - begin, advice);
+    }
+}
+
+void MappedImage::prefetchRows(int top, int count) const {
+    advise(top, count, MADV_WILLNEED);
+}
+
+void MappedImage::releaseRows(int top, int count) const {
+    advise(top, count, MADV_DONTNEED);
+}
+
+// ------------------- Strip convolution -------------------
+
+int defaultStripRows(int cols, int kernel_rows, int channels) {
+    std::size_t row = static_cast<std::size_t>(std::max(cols, 1)) * std::max(channels, 1);
+    int rows = static_cast<int>(std::min<std::size_t>(STRIP_FLOATS / row, INT32_MAX / 2));
+    return std::max(rows - (kernel_rows - 1), std::max(kernel_rows, 1));
+}
+
+void convolveMapped(const MappedImage& image,
+                    const TensorView<const float>& kernel,
+                    const MappedImage& output,
+                    Padding padding,
+                    float pad_val,
+                    int strip_rows) {
+    if (!image.isOpen() || !output.writable()) {
+        throw std::invalid_argument("Image must be open and output writable");
+    }
+    if (kernel.empty() || kernel.channels() != 1 || kernel.batch() != 1) {
+        throw std::invalid_argument("Kernel must be a single non-empty image");
+    }
+    int out_rows = convolutionOutputSize(image.rows(), kernel.rows(), padding);
+    int out_cols = convolutionOutputSize(image.cols(), kernel.cols(), padding);
+    if (out_rows < 1 || out_cols < 1) {
+        throw std::invalid_argument("Kernel is larger than the image");
+    }
+    if (output.rows() != out_rows || output.cols() != out_cols || output.channels() != image.channels()) {
+        throw std::invalid_argument("Output has the wrong shape for this convolution");
+    }
+    // Reject unknown modes before anything is read
+    paddedIndex(-1, 1, padding);
+
+    int channels = image.channels();
+    int top = paddingBefore(kernel.rows(), padding);
+    int left = paddingBefore(kernel.cols(), padding);
+    int staged_cols = out_cols + kernel.cols() - 1;
+    int strip = std::min(strip_rows > 0 ? strip_rows : defaultStripRows(staged_cols, kernel.rows(), channels),
+                         out_rows);
+    float fill = padding == Padding::CONSTANT ? pad_val : 0.0f;
+
+    WorkspaceFrame frame;
+    TensorView<float> staged = frame.uninitializedTensor(strip + kernel.rows() - 1, staged_cols, channels);
+    TensorView<float> source_row = image.tiled() ? frame.uninitializedTensor(1, image.cols(), channels)
+                                                 : TensorView<float>();
+    TensorView<float> result = output.tiled() ? frame.uninitializedTensor(strip, out_cols, channels)
+                                              : TensorView<float>();
+
+    image.prefetchRows(-top, strip + kernel.rows() - 1);
+    for (int r0 = 0; r0 < out_rows; r0 += strip) {
+        int n = std::min(strip, out_rows - r0);
+        int in_rows = n + kernel.rows() - 1;
+        int first = r0 - top;  // image row of staged row 0
+        int next = first + n;  // ... of the next strip's
+        if (r0 + n < out_rows) {
+            image.prefetchRows(next, std::min(strip, out_rows - r0 - n) + kernel.rows() - 1);
+        }
+
+        // Pad the strip and its halo with a whole-axis view of the rows, so
+        // borders beyond the strip come from the right image rows
+        TensorView<float> in = staged.window(0, 0, in_rows, staged_cols);
+        if (!image.tiled()) {
+            TensorView<const float> pixels = image.view();
+            for (int c = 0; c < channels; ++c) {
+                padImage(pixels.image(0, c), in.image(0, c), -first, left, padding, pad_val);
+            }
+        } else {
+            for (int i = 0; i < in_rows; ++i) {
+                int src = paddedIndex(first + i, image.rows(), padding);
+                if (src >= 0) {
+                    image.readRows(src, source_row);
+                }
+                for (int c = 0; c < channels; ++c) {
+                    TensorView<float> row = in.image(0, c).window(i, 0, 1, staged_cols);
+                    if (src < 0) {
+                        std::fill(row.data(), row.data() + staged_cols, fill);
+                    } else {
+                        padImage(source_row.image(0, c), row, 0, left, padding, pad_val);
+                    }
+                }
+            }
+        }
+
+        TensorView<float> out = output.tiled() ? result.window(0, 0, n, out_cols)
+                                               : output.writableView().window(r0, 0, n, out_cols);
+        dispatchConvolve2D(in, kernel, out, Padding::VALID, 0.0f);
+        if (output.tiled()) {
+            output.writeRows(r0, out);
+        }
+
+        output.releaseRows(r0, n);
+        if (r0 + n < out_rows) {
+            image.releaseRows(first, next - first);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef MAPPED_IMAGE_H
+#define MAPPED_IMAGE_H
+
+#include <cstddef>
+#include <string>
+#include "FFTWrapper.h"
+#include "Tensor.h"
+#include "padding.h"
+
+// A float32 image file mapped into memory, stored [channels][rows][cols].
+// Two formats are read and written:
+//   raw    headerless row-major pixels; the caller gives the shape
+//   kfim   a 64-byte header (magic "KFIM", then version, rows, cols,
+//          channels, tile rows and tile cols as host-order uint32) followed
+//          by the pixels: row-major, or with a tile size in tiles of
+//          tile_rows x tile_cols stored one after another, row-major tile
+//          order within each channel, edge tiles padded to the full size
+// Pages are only read in when touched, so opening a file of any size is
+// cheap and only the rows in use need to be resident.
+class MappedImage {
+private:
+    void* mapping;
+    std::size_t mappedBytes;
+    float* pixels;  // first pixel, past any header
+    int nRows;
+    int nCols;
+    int nChannels;
+    int tileHeight;  // 0 for row-major images
+    int tileWidth;
+    bool isWritable;
+
+    FFTStatus map(const std::string& path, std::size_t offset, bool writable, bool create);
+    std::size_t pixelBytes() const;
+    std::size_t offset(int c, int i, int j) const;
+    void advise(int top, int count, int advice) const;
+
+public:
+    MappedImage();
+    ~MappedImage();
+    MappedImage(MappedImage&& other) noexcept;
+    MappedImage& operator=(MappedImage&& other) noexcept;
+    MappedImage(const MappedImage&) = delete;
+    MappedImage& operator=(const MappedImage&) = delete;
+
+    // Map an existing file; fails if its size does not match the shape
+    FFTStatus openRaw(const std::string& path, int rows, int cols, int channels = 1, bool writable = false);
+    FFTStatus open(const std::string& path, bool writable = false);
+
+    // Create (or replace) a writable, zero-filled file. A tile size of 0
+    // stores the pixels row-major.
+    FFTStatus createRaw(const std::string& path, int rows, int cols, int channels = 1);
+    FFTStatus create(const std::string& path, int rows, int cols, int channels = 1, int tile_rows = 0,
+                     int tile_cols = 0);
+
+    // Write every modified page back to the file
+    FFTStatus flush();
+    void close();
+
+    bool isOpen() const { return mapping != nullptr; }
+    bool writable() const { return isWritable; }
+    bool tiled() const { return tileHeight > 0; }
+    int rows() const { return nRows; }
+    int cols() const { return nCols; }
+    int channels() const { return nChannels; }
+    int tileRows() const { return tileHeight; }
+    int tileCols() const { return tileWidth; }
+
+    // Pixels of every channel, in place; row-major images only
+    TensorView<const float> view() const;
+    TensorView<float> writableView() const;
+
+    // Copy rows [top, top + rows.rows()) of every channel out of or into
+    // the file; `rows` has the image's cols and channels
+    void readRows(int top, const TensorView<float>& rows) const;
+    void writeRows(int top, const TensorView<const float>& rows) const;
+
+    // Hints for rows [top, top + count) of every channel: start reading them
+    // in, or drop them from the process (modified rows are queued for
+    // write-back first). Neither changes the pixels.
+    void prefetchRows(int top, int count) const;
+    void releaseRows(int top, int count) const;
+};
+
+// Output rows per strip when none is given: about 4 MiB of staged input,
+// and at least the kernel height so the halo is re-read once per strip
+int defaultStripRows(int cols, int kernel_rows, int channels);
+
+// 2D convolution of a mapped image into a mapped output of
+// convolutionOutputSize() rows and cols and the same channels, a strip of
+// output rows at a time. Each strip's input rows and kernel - 1 halo are
+// padded into a workspace buffer and convolved by the backend
+// dispatchConvolve2D selects. The next strip's rows are prefetched before
+// this one is computed, and finished rows of both files are released, so
+// resident memory stays O(strip x cols) whatever the file size.
+void convolveMapped(const MappedImage& image,
+                    const TensorView<const float>& kernel,
+                    const MappedImage& output,
+                    Padding padding,
+                    float pad_val = 0.0f,
+                    int strip_rows = 0);
+
+#endif  // MAPPED_IMAGE_H
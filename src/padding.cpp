@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <stdexcept>
+#include "instrumentation.h"
+#include "padding.h"
+#include "parallel.h"
+
+int convolutionOutputSize(int size, int kernel_size, Padding padding) {
+    if (padding == Padding::VALID) {
+        return size - kernel_size + 1;
+    } else if (padding == Padding::FULL) {
+        return size + kernel_size - 1;
+    }
+    return size;
+}
+
+int convolutionOutputSize(int size, int kernel_size, Padding padding, int stride) {
+    if (stride < 1) {
+        throw std::invalid_argument("Stride must be positive");
+    }
+    int full = convolutionOutputSize(size, kernel_size, padding);
+    return full > 0 ? (full - 1) / stride + 1 : full;
+}
+
+int paddingBefore(int kernel_size, Padding padding) {
+    if (padding == Padding::VALID) {
+        return 0;
+    } else if (padding == Padding::FULL) {
+        return kernel_size - 1;
+    }
+    return (kernel_size - 1) / 2;
+}
+
+int paddedIndex(int i, int n, Padding padding) {
+    if (i >= 0 && i < n) {
+        return i;
+    }
+    if (padding == Padding::ZERO || padding == Padding::CONSTANT || padding == Padding::FULL ||
+        padding == Padding::VALID) {
+        return -1;
+    } else if (padding == Padding::REPLICATE) {
+        return i < 0 ? 0 : n - 1;
+    } else if (padding == Padding::REFLECT) {
+        int reflected = i < 0 ? -i - 1 : 2 * n - 1 - i;
+        return std::min(std::max(reflected, 0), n - 1);
+    } else if (padding == Padding::CIRCULAR) {
+        return (i % n + n) % n;
+    }
+    throw std::invalid_argument("Unsupported padding type");
+}
+
+void padImage(const TensorView<const float>& input,
+              const TensorView<float>& output,
+              int top, int left,
+              Padding padding, float pad_val) {
+    ScopedStage stage(Stage::PAD);
+    float fill = padding == Padding::CONSTANT ? pad_val : 0.0f;
+    // Reject unknown modes up front; nothing may throw inside the parallel loop
+    paddedIndex(-1, 1, padding);
+
+    // Columns [first, last) copy a run of the source row; only the border
+    // columns around them are looked up one by one
+    int first = std::min(std::max(left, 0), output.cols());
+    int last = std::max(std::min(left + input.cols(), output.cols()), first);
+
+    int threads = parallelThreads(static_cast<double>(output.rows()) * output.cols());
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (int i = 0; i < output.rows(); ++i) {
+        float* out = output.row(0, 0, i);
+        int src_row = paddedIndex(i - top, input.rows(), padding);
+        if (src_row < 0) {
+            std::fill(out, out + output.cols(), fill);
+            continue;
+        }
+        const float* in = input.row(0, 0, src_row);
+        auto border = [&](int j) {
+            int src_col = paddedIndex(j - left, input.cols(), padding);
+            out[j] = src_col < 0 ? fill : in[src_col];
+        };
+        for (int j = 0; j < first; ++j) {
+            border(j);
+        }
+        if (last > first) {
+            std::copy(in + first - left, in + last - left, out + first);
+        }
+        for (int j = last; j < output.cols(); ++j) {
+            border(j);
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef PADDING_H
+#define PADDING_H
+
+#include "Tensor.h"
+
+enum class Padding {
+    VALID,      // no padding
+    ZERO,       // pads the image or feature map with zeros
+    CONSTANT,   // pads with a user-specified constant
+    REPLICATE,  // pads by replicating the edge pixels of the image or feature map
+    REFLECT,    // pads by reflecting border pixels
+    FULL,       // zero padding on both sides by kernel - 1: every partial overlap is output
+    CIRCULAR,   // wraps around: the image repeats periodically
+};
+
+// Output length along one axis of a convolution with the given padding
+int convolutionOutputSize(int size, int kernel_size, Padding padding);
+
+// Same, keeping every `stride`-th output starting with the first
+int convolutionOutputSize(int size, int kernel_size, Padding padding, int stride);
+
+// Padding before the first element along one axis (after padding, the
+// convolution keeps only the positions where the kernel fully overlaps)
+int paddingBefore(int kernel_size, Padding padding);
+
+// Source index for position `i` (relative to the image origin) of a padded
+// axis of length `n`, or -1 where the border is filled with a constant
+int paddedIndex(int i, int n, Padding padding);
+
+// Pad one image into `output`, placing the image at (top, left)
+void padImage(const TensorView<const float>& input,
+              const TensorView<float>& output,
+              int top, int left,
+              Padding padding, float pad_val);
+
+#endif  // PADDING_H
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "parallel.h"
+
+// Below these sizes fork/join (or FFTW's thread hand-off) costs more than
+// the parallel work saves
+static const double MIN_WORK_PER_THREAD = 1 << 15;
+static const double MIN_FFT_POINTS = 1 << 16;
+
+static std::atomic<int> num_threads{0};
+static thread_local int thread_limit = 0;
+
+static int defaultThreads() {
+#ifdef _OPENMP
+    return std::max(1, omp_get_max_threads());
+#else
+    return std::max(1u, std::thread::hardware_concurrency());
+#endif
+}
+
+void setNumThreads(int threads) {
+    if (threads < 0) {
+        throw std::invalid_argument("Thread count must not be negative");
+    }
+    num_threads.store(threads);
+}
+
+int getNumThreads() {
+    int threads = num_threads.load();
+    threads = threads > 0 ? threads : defaultThreads();
+    return thread_limit > 0 ? std::min(threads, thread_limit) : threads;
+}
+
+ThreadLimit::ThreadLimit(int threads) : previous(thread_limit) {
+    if (threads < 1) {
+        throw std::invalid_argument("Thread limit must be positive");
+    }
+    // A nested limit can only narrow the enclosing one
+    thread_limit = previous > 0 ? std::min(previous, threads) : threads;
+}
+
+ThreadLimit::~ThreadLimit() {
+    thread_limit = previous;
+}
+
+int parallelThreads(double work) {
+#ifdef _OPENMP
+    if (omp_in_parallel()) {
+        return 1;
+    }
+#endif
+    double useful = std::max(1.0, work / MIN_WORK_PER_THREAD);
+    return static_cast<int>(std::min<double>(getNumThreads(), useful));
+}
+
+int fftThreads(double points) {
+    return points < MIN_FFT_POINTS ? 1 : parallelThreads(points);
+}
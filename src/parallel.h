@@ -0,0 +1,30 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// Threads used by the convolution engines: OpenMP loops over rows, tiles
+// and batch items, and FFTW's own threads for large transforms. 0 restores
+// the default (OMP_NUM_THREADS, or one per hardware thread).
+void setNumThreads(int threads);
+int getNumThreads();
+
+// Caps getNumThreads() on the calling thread for the limit's lifetime, for
+// worker pools that already run one task per core
+class ThreadLimit {
+private:
+    int previous;
+
+public:
+    explicit ThreadLimit(int threads);
+    ~ThreadLimit();
+    ThreadLimit(const ThreadLimit&) = delete;
+    ThreadLimit& operator=(const ThreadLimit&) = delete;
+};
+
+// Threads worth forking for a loop over `work` elementary operations:
+// small loops, and loops already inside a parallel region, stay serial
+int parallelThreads(double work);
+
+// Threads FFTW should plan a transform batch of `points` real points with
+int fftThreads(double points);
+
+#endif  // PARALLEL_H
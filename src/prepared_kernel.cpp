@@ -0,0 +1,48 @@
+#include <stdexcept>
+#include "prepared_kernel.h"
+
+PreparedKernel::PreparedKernel(const std::vector<float>& kernel, int length, Padding padding, Flags flags)
+    : kernelPadding(padding), nRows(1), nCols(length) {
+    if (kernel.empty() || convolutionOutputSize(length, kernel.size(), padding) <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the signal");
+    }
+    TensorView<const float> view(kernel.data(), 1, static_cast<int>(kernel.size()));
+    kernelSpectrum = cachedKernelSpectrum(view, 1, 1, fftConvolutionSize(length, view.cols(), padding), flags);
+}
+
+PreparedKernel::PreparedKernel(const TensorView<const float>& kernel, int rows, int cols, Padding padding, Flags flags)
+    : kernelPadding(padding), nRows(rows), nCols(cols) {
+    if (kernel.empty() || convolutionOutputSize(rows, kernel.rows(), padding) <= 0 ||
+        convolutionOutputSize(cols, kernel.cols(), padding) <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the image");
+    }
+    kernelSpectrum = cachedKernelSpectrum(kernel, 2, fftConvolutionSize(rows, kernel.rows(), padding),
+                                          fftConvolutionSize(cols, kernel.cols(), padding), flags);
+}
+
+std::vector<float> convolve(const std::vector<float>& signal, const PreparedKernel& kernel, float pad_val) {
+    if (kernel.rank() != 1 || static_cast<int>(signal.size()) != kernel.inputCols()) {
+        throw std::invalid_argument("Kernel was prepared for a different signal length");
+    }
+    std::vector<float> output(kernel.outputCols());
+    fftConvolve1D(TensorView<const float>(signal.data(), 1, kernel.inputCols()), kernel.spectrum(),
+                  TensorView<float>(output.data(), 1, kernel.outputCols()), kernel.padding(), pad_val, getPlanFlags());
+    return output;
+}
+
+void convolve(const TensorView<const float>& image,
+              const PreparedKernel& kernel,
+              const TensorView<float>& output,
+              float pad_val) {
+    if (kernel.rank() == 1) {
+        if (image.cols() != kernel.inputCols()) {
+            throw std::invalid_argument("Kernel was prepared for a different signal length");
+        }
+        fftConvolve1D(image, kernel.spectrum(), output, kernel.padding(), pad_val, getPlanFlags());
+        return;
+    }
+    if (image.rows() != kernel.inputRows() || image.cols() != kernel.inputCols()) {
+        throw std::invalid_argument("Kernel was prepared for a different image size");
+    }
+    fftConvolve2D(image, kernel.spectrum(), output, kernel.padding(), pad_val, getPlanFlags());
+}
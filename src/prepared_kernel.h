@@ -0,0 +1,52 @@
+#ifndef PREPARED_KERNEL_H
+#define PREPARED_KERNEL_H
+
+#include <memory>
+#include <vector>
+#include "convolution.h"
+#include "fft_convolution.h"
+#include "Tensor.h"
+#include "padding.h"
+
+// A kernel transformed once for inputs of a fixed extent and padding.
+// Applying it costs one forward and one inverse transform per signal or
+// image. Copies share the same spectrum.
+class PreparedKernel {
+private:
+    std::shared_ptr<const KernelSpectrum> kernelSpectrum;
+    Padding kernelPadding;
+    int nRows;  // input extent the spectrum was prepared for
+    int nCols;
+
+public:
+    // 1D kernel for signals of `length` samples
+    PreparedKernel(const std::vector<float>& kernel, int length, Padding padding, Flags flags = getPlanFlags());
+
+    // 2D kernel for rows x cols images
+    PreparedKernel(const TensorView<const float>& kernel, int rows, int cols, Padding padding,
+                   Flags flags = getPlanFlags());
+
+    int rank() const { return kernelSpectrum->rank; }
+    Padding padding() const { return kernelPadding; }
+    int kernelRows() const { return kernelSpectrum->kernel_rows; }
+    int kernelCols() const { return kernelSpectrum->kernel_cols; }
+    int inputRows() const { return nRows; }
+    int inputCols() const { return nCols; }
+    int outputRows() const {
+        return rank() == 1 ? 1 : convolutionOutputSize(nRows, kernelRows(), kernelPadding);
+    }
+    int outputCols() const { return convolutionOutputSize(nCols, kernelCols(), kernelPadding); }
+    const KernelSpectrum& spectrum() const { return *kernelSpectrum; }
+};
+
+// 1D convolution of a signal of the prepared length
+std::vector<float> convolve(const std::vector<float>& signal, const PreparedKernel& kernel, float pad_val = 0.0);
+
+// 2D convolution of every image of `image` (1D kernels: of every row) into
+// `output`, which has the prepared output extent
+void convolve(const TensorView<const float>& image,
+              const PreparedKernel& kernel,
+              const TensorView<float>& output,
+              float pad_val = 0.0);
+
+#endif  // PREPARED_KERNEL_H
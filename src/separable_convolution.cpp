@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <list>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include "separable_convolution.h"
+#include "fft_convolution.h"
+#include "instrumentation.h"
+#include "parallel.h"
+#include "simd.h"
+#include "workspace.h"
+
+static std::atomic<double> separability_tolerance{1e-5};
+
+void setSeparabilityTolerance(double tolerance) {
+    separability_tolerance.store(tolerance);
+}
+
+double getSeparabilityTolerance() {
+    return separability_tolerance.load();
+}
+
+// ------------------- Decomposition -------------------
+
+// True when the one-sided Jacobi iterate `a` (m x n, row-major) already
+// has more than `max_rank` singular values above `threshold`. The Gram
+// matrix of the max_rank + 1 longest columns is a principal submatrix of
+// A^T A, so by interlacing A has at least that many singular values above
+// the square root of its smallest eigenvalue, which Gershgorin bounds from
+// below by each diagonal entry minus its row's off-diagonal magnitudes.
+static bool exceedsRank(const double* a, int m, int n, int max_rank, double threshold, double* norms, int* order) {
+    int k = max_rank + 1;
+    for (int j = 0; j < n; ++j) {
+        double norm = 0;
+        for (int i = 0; i < m; ++i) norm += a[i * n + j] * a[i * n + j];
+        norms[j] = norm;
+        order[j] = j;
+    }
+    std::partial_sort(order, order + k, order + n, [&](int x, int y) { return norms[x] > norms[y]; });
+    for (int s = 0; s < k; ++s) {
+        double bound = norms[order[s]];
+        for (int t = 0; t < k && bound > threshold * threshold; ++t) {
+            if (t == s) continue;
+            double dot = 0;
+            for (int i = 0; i < m; ++i) dot += a[i * n + order[s]] * a[i * n + order[t]];
+            bound -= std::abs(dot);
+        }
+        if (bound <= threshold * threshold) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SeparableKernel decomposeKernel(const TensorView<const float>& kernel, double tolerance, int max_rank) {
+    int m = kernel.rows();
+    int n = kernel.cols();
+    if (kernel.empty()) {
+        throw std::invalid_argument("Kernel must not be empty");
+    }
+    if (max_rank < 0) {
+        throw std::invalid_argument("Rank bound must not be negative");
+    }
+
+    // One-sided Jacobi: rotate column pairs of A (m x n) until they are
+    // orthogonal; then A = U V^T with the column norms of U the singular
+    // values. Scratch comes from the workspace, so only the result allocates.
+    WorkspaceFrame frame;
+    double* a = frame.array<double>(static_cast<std::size_t>(m) * n);
+    double* v = frame.array<double>(static_cast<std::size_t>(n) * n);
+    double* sigma = frame.array<double>(n);
+    int* order = frame.array<int>(n);
+    double frobenius = 0;
+    for (int i = 0; i < m; ++i)
+        for (int j = 0; j < n; ++j) {
+            a[i * n + j] = kernel(i, j);
+            frobenius += a[i * n + j] * a[i * n + j];
+        }
+    std::fill(v, v + static_cast<std::size_t>(n) * n, 0.0);
+    for (int j = 0; j < n; ++j) v[j * n + j] = 1.0;
+
+    // The largest singular value is at most the Frobenius norm, so values
+    // above tolerance * ||A||_F are kept terms whatever the largest is
+    bool bounded = max_rank < std::min(m, n);
+    double threshold = tolerance * std::sqrt(frobenius);
+
+    for (int sweep = 0; sweep < 60; ++sweep) {
+        bool rotated = false;
+        for (int p = 0; p < n - 1; ++p) {
+            for (int q = p + 1; q < n; ++q) {
+                double alpha = 0, beta = 0, gamma = 0;
+                for (int i = 0; i < m; ++i) {
+                    alpha += a[i * n + p] * a[i * n + p];
+                    beta += a[i * n + q] * a[i * n + q];
+                    gamma += a[i * n + p] * a[i * n + q];
+                }
+                if (std::abs(gamma) <= 1e-15 * std::sqrt(alpha * beta) || gamma == 0) {
+                    continue;
+                }
+                rotated = true;
+                double zeta = (beta - alpha) / (2 * gamma);
+                double t = (zeta >= 0 ? 1.0 : -1.0) / (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+                double c = 1 / std::sqrt(1 + t * t);
+                double s = c * t;
+                for (int i = 0; i < m; ++i) {
+                    double ap = a[i * n + p], aq = a[i * n + q];
+                    a[i * n + p] = c * ap - s * aq;
+                    a[i * n + q] = s * ap + c * aq;
+                }
+                for (int i = 0; i < n; ++i) {
+                    double vp = v[i * n + p], vq = v[i * n + q];
+                    v[i * n + p] = c * vp - s * vq;
+                    v[i * n + q] = s * vp + c * vq;
+                }
+            }
+        }
+        if (!rotated) break;
+        if (bounded && exceedsRank(a, m, n, max_rank, threshold, sigma, order)) {
+            return SeparableKernel{m, n, {}, {}};
+        }
+    }
+
+    for (int j = 0; j < n; ++j) {
+        double norm = 0;
+        for (int i = 0; i < m; ++i) norm += a[i * n + j] * a[i * n + j];
+        sigma[j] = std::sqrt(norm);
+    }
+    std::iota(order, order + n, 0);
+    std::sort(order, order + n, [&](int x, int y) { return sigma[x] > sigma[y]; });
+
+    // Column factor sigma * u is just the rotated column of A
+    SeparableKernel result{m, n, {}, {}};
+    double largest = sigma[order[0]];
+    for (int r = 0; r < n; ++r) {
+        int j = order[r];
+        if (largest == 0 || sigma[j] <= tolerance * largest) break;
+        if (r == max_rank) {
+            // Converged before the bound above caught it
+            return SeparableKernel{m, n, {}, {}};
+        }
+        std::vector<float> column(m), row(n);
+        for (int i = 0; i < m; ++i) column[i] = static_cast<float>(a[i * n + j]);
+        for (int i = 0; i < n; ++i) row[i] = static_cast<float>(v[i * n + j]);
+        result.column_factors.push_back(std::move(column));
+        result.row_factors.push_back(std::move(row));
+    }
+    return result;
+}
+
+struct DecompositionEntry {
+    std::uint64_t hash;
+    std::vector<float> raw;  // the source kernel, to rule out hash collisions
+    double tolerance;
+    int max_rank;            // bound the decomposition ran under
+    std::shared_ptr<const SeparableKernel> kernel;
+};
+
+static const std::size_t DECOMPOSITION_CACHE_CAPACITY = 16;
+static std::mutex decomposition_cache_mutex;
+static std::list<DecompositionEntry> decomposition_cache;  // most recently used first
+
+std::shared_ptr<const SeparableKernel> cachedSeparableKernel(const TensorView<const float>& kernel,
+                                                             double tolerance, int max_rank) {
+    if (kernel.empty()) {
+        throw std::invalid_argument("Kernel must not be empty");
+    }
+
+    // A full decomposition answers any bound; one that stopped with no
+    // terms above bound b also answers every bound up to b
+    std::uint64_t hash = kernelContentHash(kernel);
+    {
+        std::lock_guard<std::mutex> lock(decomposition_cache_mutex);
+        for (auto it = decomposition_cache.begin(); it != decomposition_cache.end(); ++it) {
+            const SeparableKernel& entry = *it->kernel;
+            bool answers = entry.rank() > 0 ? entry.rank() <= max_rank : max_rank <= it->max_rank;
+            if (it->hash == hash && it->tolerance == tolerance && entry.rows == kernel.rows() &&
+                entry.cols == kernel.cols() && answers && sameCoefficients(it->raw, kernel)) {
+                decomposition_cache.splice(decomposition_cache.begin(), decomposition_cache, it);
+                countEvent(Counter::DECOMPOSITION_CACHE_HITS);
+                return decomposition_cache.front().kernel;
+            }
+        }
+    }
+
+    countEvent(Counter::DECOMPOSITION_CACHE_MISSES);
+    auto separable = std::make_shared<const SeparableKernel>(decomposeKernel(kernel, tolerance, max_rank));
+    std::vector<float> raw;
+    raw.reserve(static_cast<std::size_t>(kernel.rows()) * kernel.cols());
+    for (int i = 0; i < kernel.rows(); ++i) {
+        raw.insert(raw.end(), kernel.row(0, 0, i), kernel.row(0, 0, i) + kernel.cols());
+    }
+
+    std::lock_guard<std::mutex> lock(decomposition_cache_mutex);
+    decomposition_cache.push_front(DecompositionEntry{hash, std::move(raw), tolerance, max_rank, separable});
+    if (decomposition_cache.size() > DECOMPOSITION_CACHE_CAPACITY) {
+        decomposition_cache.pop_back();
+    }
+    return separable;
+}
+
+void clearSeparableKernelCache() {
+    std::lock_guard<std::mutex> lock(decomposition_cache_mutex);
+    decomposition_cache.clear();
+}
+
+// ------------------- Two-pass Convolution -------------------
+
+// Width of the column strips, so a ring of kh filtered rows stays in cache
+static const int STRIP_COLS = 1024;
+
+static int separableThreads(int output_rows, int output_cols, int kernel_rows, int kernel_cols, int rank) {
+    return parallelThreads(static_cast<double>(output_rows) * output_cols * (kernel_rows + kernel_cols) * rank);
+}
+
+std::size_t separableConvolutionWorkspace(int rows, int cols, int kernel_rows, int kernel_cols, int rank,
+                                          Padding padding) {
+    int output_rows = convolutionOutputSize(rows, kernel_rows, padding);
+    int output_cols = convolutionOutputSize(cols, kernel_cols, padding);
+    bool padded = padding != Padding::VALID;
+    int strip_cols = std::min(output_cols, STRIP_COLS);
+    int strips = (output_cols + strip_cols - 1) / strip_cols;
+    int threads = separableThreads(output_rows, output_cols, kernel_rows, kernel_cols, rank);
+    int band_rows = std::max(1, (output_rows + threads - 1) / threads);
+    int bands = (output_rows + band_rows - 1) / band_rows;
+    return workspaceTensorBytes(padded ? output_rows + kernel_rows - 1 : 0, padded ? output_cols + kernel_cols - 1 : 0) +
+           workspaceTensorBytes(kernel_rows, strip_cols, 1, bands * strips);
+}
+
+void separableConvolve2D(const TensorView<const float>& image,
+                         const SeparableKernel& kernel,
+                         const TensorView<float>& output,
+                         Padding padding,
+                         float pad_val) {
+    ScopedStage stage(Stage::SEPARABLE);
+    int kernel_rows = kernel.rows;
+    int kernel_cols = kernel.cols;
+    int output_rows = convolutionOutputSize(image.rows(), kernel_rows, padding);
+    int output_cols = convolutionOutputSize(image.cols(), kernel_cols, padding);
+
+    if (image.empty() || output_rows <= 0 || output_cols <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the image");
+    }
+    if (output.rows() != output_rows || output.cols() != output_cols ||
+        output.channels() != image.channels() || output.batch() != image.batch()) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
+
+    // Borders are staged once per image, as in the direct backend
+    bool padded = padding != Padding::VALID;
+    WorkspaceFrame frame;
+    TensorView<float> staged =
+        frame.tensor(padded ? output_rows + kernel_rows - 1 : 0, padded ? output_cols + kernel_cols - 1 : 0);
+    int strip_cols = std::min(output_cols, STRIP_COLS);
+    int strips = (output_cols + strip_cols - 1) / strip_cols;
+
+    // Threads take bands of output rows within a strip; each band/strip
+    // task owns a ring and primes it with kh - 1 extra filtered rows. The
+    // band count is recomputed from the rounded-up band height so no band
+    // starts past the last output row (5 rows on 4 threads make 3 bands).
+    int threads = separableThreads(output_rows, output_cols, kernel_rows, kernel_cols, kernel.rank());
+    int band_rows = (output_rows + threads - 1) / threads;
+    int bands = (output_rows + band_rows - 1) / band_rows;
+    TensorView<float> rings = frame.tensor(kernel_rows, strip_cols, 1, bands * strips);
+
+    for (int b = 0; b < image.batch(); ++b) {
+        for (int c = 0; c < image.channels(); ++c) {
+            TensorView<const float> source = image.image(b, c);
+            if (padded) {
+                padImage(source, staged, paddingBefore(kernel_rows, padding), paddingBefore(kernel_cols, padding),
+                         padding, pad_val);
+                source = staged;
+            }
+            for (int i = 0; i < output_rows; ++i) {
+                std::fill(output.row(b, c, i), output.row(b, c, i) + output_cols, 0.0f);
+            }
+
+            for (int term = 0; term < kernel.rank(); ++term) {
+                const std::vector<float>& column = kernel.column_factors[term];
+                const std::vector<float>& row = kernel.row_factors[term];
+
+                #pragma omp parallel for num_threads(threads) schedule(static)
+                for (int task = 0; task < bands * strips; ++task) {
+                    TensorView<float> ring = rings.image(task, 0);
+                    int left = task % strips * strip_cols;
+                    int width = std::min(strip_cols, output_cols - left);
+                    int first = task / strips * band_rows;
+                    int last = std::min(output_rows, first + band_rows);
+
+                    // Row pass of padded row r into ring slot r % kh
+                    auto filterRow = [&](int r) {
+                        float* dst = ring.row(0, 0, r % kernel_rows);
+                        const float* src = source.row(0, 0, r) + left;
+                        std::fill(dst, dst + width, 0.0f);
+                        for (int v = 0; v < kernel_cols; ++v) {
+                            axpy(dst, src + kernel_cols - 1 - v, row[v], width);
+                        }
+                    };
+                    for (int r = first; r < first + kernel_rows - 1; ++r) {
+                        filterRow(r);
+                    }
+
+                    // Column pass: output row i sums filtered rows i .. i + kh - 1
+                    for (int i = first; i < last; ++i) {
+                        filterRow(i + kernel_rows - 1);
+                        float* out = output.row(b, c, i) + left;
+                        for (int u = 0; u < kernel_rows; ++u) {
+                            axpy(out, ring.row(0, 0, (i + kernel_rows - 1 - u) % kernel_rows), column[u], width);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
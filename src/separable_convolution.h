@@ -0,0 +1,59 @@
+#ifndef SEPARABLE_CONVOLUTION_H
+#define SEPARABLE_CONVOLUTION_H
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "Tensor.h"
+#include "padding.h"
+
+// A kernel written as a sum of rank-1 terms: kernel(u, v) is the sum over
+// terms t of column_factors[t][u] * row_factors[t][v]
+struct SeparableKernel {
+    int rows;
+    int cols;
+    std::vector<std::vector<float>> column_factors;  // singular values folded in
+    std::vector<std::vector<float>> row_factors;
+
+    int rank() const { return static_cast<int>(column_factors.size()); }
+};
+
+// SVD of the kernel (one-sided Jacobi, in double precision), keeping the
+// terms whose singular value exceeds `tolerance` times the largest one.
+// Once the sweeps prove the kernel has more than `max_rank` such terms they
+// stop, and the result has no terms: callers that only want cheap
+// decompositions do not pay for converging expensive ones.
+SeparableKernel decomposeKernel(const TensorView<const float>& kernel, double tolerance,
+                                int max_rank = std::numeric_limits<int>::max());
+
+// Decomposition of `kernel` from a process-wide LRU cache keyed by the
+// kernel's contents (as cachedKernelSpectrum), so a kernel applied
+// repeatedly is decomposed once. An entry that stopped above one max_rank
+// answers every smaller max_rank too.
+std::shared_ptr<const SeparableKernel> cachedSeparableKernel(const TensorView<const float>& kernel,
+                                                             double tolerance,
+                                                             int max_rank = std::numeric_limits<int>::max());
+void clearSeparableKernelCache();
+
+// Relative tolerance the dispatcher uses to decide a kernel's rank (1e-5 by default)
+void setSeparabilityTolerance(double tolerance);
+double getSeparabilityTolerance();
+
+// Convolution with a decomposed kernel as a row pass then a column pass per
+// term, O(rank * (kh + kw)) per output instead of O(kh * kw). Both passes
+// run along contiguous rows: the row pass fills a ring of kh filtered rows
+// and the column pass accumulates whole rows of it, in column strips sized
+// to stay in cache.
+void separableConvolve2D(const TensorView<const float>& image,
+                         const SeparableKernel& kernel,
+                         const TensorView<float>& output,
+                         Padding padding,
+                         float pad_val);
+
+// Workspace bytes (see workspace.h) separableConvolve2D takes from the
+// calling thread's workspace for a kernel of `rank` terms
+std::size_t separableConvolutionWorkspace(int rows, int cols, int kernel_rows, int kernel_cols, int rank,
+                                          Padding padding);
+
+#endif  // SEPARABLE_CONVOLUTION_H
@@ -0,0 +1,334 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include "simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define KF_SIMD_X86 1
+#define KF_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// Kernels work on interleaved (re, im) floats; n counts complex values.
+// Every variant scales b before the product, so they round alike.
+
+// ------------------- Scalar -------------------
+
+static void multiplyScalar(float* dst, const float* a, const float* b, int n, float scale) {
+    for (int j = 0; j < n; ++j) {
+        float ar = a[2 * j], ai = a[2 * j + 1];
+        float br = b[2 * j] * scale, bi = b[2 * j + 1] * scale;
+        dst[2 * j] = ar * br - ai * bi;
+        dst[2 * j + 1] = ar * bi + ai * br;
+    }
+}
+
+static void multiplyAccumulateScalar(float* acc, const float* a, const float* b, int n, float scale) {
+    for (int j = 0; j < n; ++j) {
+        float ar = a[2 * j], ai = a[2 * j + 1];
+        float br = b[2 * j] * scale, bi = b[2 * j + 1] * scale;
+        acc[2 * j] += ar * br - ai * bi;
+        acc[2 * j + 1] += ar * bi + ai * br;
+    }
+}
+
+static void conjugateMultiplyScalar(float* dst, const float* a, const float* b, int n, float scale) {
+    for (int j = 0; j < n; ++j) {
+        float ar = a[2 * j], ai = a[2 * j + 1];
+        float br = b[2 * j] * scale, bi = b[2 * j + 1] * scale;
+        dst[2 * j] = ar * br + ai * bi;
+        dst[2 * j + 1] = ai * br - ar * bi;
+    }
+}
+
+static void scaledCopyScalar(float* dst, const float* src, int n, float scale) {
+    for (int j = 0; j < n; ++j) {
+        dst[j] = src[j] * scale;
+    }
+}
+
+#ifdef KF_SIMD_X86
+
+// ------------------- SSE3 -------------------
+
+// (ar br - ai bi, ar bi + ai br) from a, the real parts of b and the
+// imaginary parts of b, each duplicated into both lanes of a pair
+KF_TARGET("sse3") static inline __m128 productSSE3(__m128 a, __m128 re, __m128 im) {
+    __m128 swapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_addsub_ps(_mm_mul_ps(a, re), _mm_mul_ps(swapped, im));
+}
+
+KF_TARGET("sse3") static void multiplySSE3(float* dst, const float* a, const float* b, int n, float scale) {
+    __m128 s = _mm_set1_ps(scale);
+    int j = 0;
+    for (; j + 2 <= n; j += 2) {
+        __m128 y = _mm_loadu_ps(b + 2 * j);
+        __m128 re = _mm_mul_ps(_mm_moveldup_ps(y), s);
+        __m128 im = _mm_mul_ps(_mm_movehdup_ps(y), s);
+        _mm_storeu_ps(dst + 2 * j, productSSE3(_mm_loadu_ps(a + 2 * j), re, im));
+    }
+    multiplyScalar(dst + 2 * j, a + 2 * j, b + 2 * j, n - j, scale);
+}
+
+KF_TARGET("sse3") static void multiplyAccumulateSSE3(float* acc, const float* a, const float* b, int n, float scale) {
+    __m128 s = _mm_set1_ps(scale);
+    int j = 0;
+    for (; j + 2 <= n; j += 2) {
+        __m128 y = _mm_loadu_ps(b + 2 * j);
+        __m128 re = _mm_mul_ps(_mm_moveldup_ps(y), s);
+        __m128 im = _mm_mul_ps(_mm_movehdup_ps(y), s);
+        __m128 sum = _mm_add_ps(_mm_loadu_ps(acc + 2 * j), productSSE3(_mm_loadu_ps(a + 2 * j), re, im));
+        _mm_storeu_ps(acc + 2 * j, sum);
+    }
+    multiplyAccumulateScalar(acc + 2 * j, a + 2 * j, b + 2 * j, n - j, scale);
+}
+
+KF_TARGET("sse3") static void conjugateMultiplySSE3(float* dst, const float* a, const float* b, int n, float scale) {
+    // addsub with the cross terms negated: (ar br + ai bi, ai br - ar bi)
+    __m128 s = _mm_set1_ps(scale);
+    __m128 sign = _mm_set1_ps(-0.0f);
+    int j = 0;
+    for (; j + 2 <= n; j += 2) {
+        __m128 x = _mm_loadu_ps(a + 2 * j);
+        __m128 y = _mm_loadu_ps(b + 2 * j);
+        __m128 re = _mm_mul_ps(_mm_moveldup_ps(y), s);
+        __m128 im = _mm_xor_ps(_mm_mul_ps(_mm_movehdup_ps(y), s), sign);
+        __m128 swapped = _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_ps(dst + 2 * j, _mm_addsub_ps(_mm_mul_ps(x, re), _mm_mul_ps(swapped, im)));
+    }
+    conjugateMultiplyScalar(dst + 2 * j, a + 2 * j, b + 2 * j, n - j, scale);
+}
+
+KF_TARGET("sse3") static void scaledCopySSE3(float* dst, const float* src, int n, float scale) {
+    __m128 s = _mm_set1_ps(scale);
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        _mm_storeu_ps(dst + j, _mm_mul_ps(_mm_loadu_ps(src + j), s));
+    }
+    scaledCopyScalar(dst + j, src + j, n - j, scale);
+}
+
+// ------------------- AVX2 -------------------
+
+KF_TARGET("avx2,fma") static inline __m256 productAVX2(__m256 a, __m256 re, __m256 im) {
+    __m256 swapped = _mm256_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm256_fmaddsub_ps(a, re, _mm256_mul_ps(swapped, im));
+}
+
+KF_TARGET("avx2,fma") static void multiplyAVX2(float* dst, const float* a, const float* b, int n, float scale) {
+    __m256 s = _mm256_set1_ps(scale);
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m256 y = _mm256_loadu_ps(b + 2 * j);
+        __m256 re = _mm256_mul_ps(_mm256_moveldup_ps(y), s);
+        __m256 im = _mm256_mul_ps(_mm256_movehdup_ps(y), s);
+        _mm256_storeu_ps(dst + 2 * j, productAVX2(_mm256_loadu_ps(a + 2 * j), re, im));
+    }
+    multiplyScalar(dst + 2 * j, a + 2 * j, b + 2 * j, n - j, scale);
+}
+
+KF_TARGET("avx2,fma") static void multiplyAccumulateAVX2(float* acc, const float* a, const float* b, int n,
+                                                          float scale) {
+    __m256 s = _mm256_set1_ps(scale);
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m256 y = _mm256_loadu_ps(b + 2 * j);
+        __m256 re = _mm256_mul_ps(_mm256_moveldup_ps(y), s);
+        __m256 im = _mm256_mul_ps(_mm256_movehdup_ps(y), s);
+        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(acc + 2 * j), productAVX2(_mm256_loadu_ps(a + 2 * j), re, im));
+        _mm256_storeu_ps(acc + 2 * j, sum);
+    }
+    multiplyAccumulateScalar(acc + 2 * j, a + 2 * j, b + 2 * j, n - j, scale);
+}
+
+KF_TARGET("avx2,fma") static void conjugateMultiplyAVX2(float* dst, const float* a, const float* b, int n,
+                                                         float scale) {
+    __m256 s = _mm256_set1_ps(scale);
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m256 x = _mm256_loadu_ps(a + 2 * j);
+        __m256 y = _mm256_loadu_ps(b + 2 * j);
+        __m256 re = _mm256_mul_ps(_mm256_moveldup_ps(y), s);
+        __m256 im = _mm256_mul_ps(_mm256_movehdup_ps(y), s);
+        __m256 swapped = _mm256_permute_ps(x, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm256_storeu_ps(dst + 2 * j, _mm256_fmsubadd_ps(x, re, _mm256_mul_ps(swapped, im)));
+    }
+    conjugateMultiplyScalar(dst + 2 * j, a + 2 * j, b + 2 * j, n - j, scale);
+}
+
+KF_TARGET("avx2,fma") static void scaledCopyAVX2(float* dst, const float* src, int n, float scale) {
+    __m256 s = _mm256_set1_ps(scale);
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        _mm256_storeu_ps(dst + j, _mm256_mul_ps(_mm256_loadu_ps(src + j), s));
+    }
+    scaledCopyScalar(dst + j, src + j, n - j, scale);
+}
+
+// ------------------- AVX-512 -------------------
+
+// Lane shuffles go through _mm512_shuffle_ps: GCC 12 warns about the
+// undefined source operand of permute_ps, moveldup_ps and movehdup_ps
+
+KF_TARGET("avx512f") static inline __m512 productAVX512(__m512 a, __m512 re, __m512 im) {
+    __m512 swapped = _mm512_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm512_fmaddsub_ps(a, re, _mm512_mul_ps(swapped, im));
+}
+
+KF_TARGET("avx512f") static void multiplyAVX512(float* dst, const float* a, const float* b, int n, float scale) {
+    __m512 s = _mm512_set1_ps(scale);
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m512 y = _mm512_loadu_ps(b + 2 * j);
+        __m512 re = _mm512_mul_ps(_mm512_shuffle_ps(y, y, _MM_SHUFFLE(2, 2, 0, 0)), s);
+        __m512 im = _mm512_mul_ps(_mm512_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 1, 1)), s);
+        _mm512_storeu_ps(dst + 2 * j, productAVX512(_mm512_loadu_ps(a + 2 * j), re, im));
+    }
+    multiplyScalar(dst + 2 * j, a + 2 * j, b + 2 * j, n - j, scale);
+}
+
+KF_TARGET("avx512f") static void multiplyAccumulateAVX512(float* acc, const float* a, const float* b, int n,
+                                                          float scale) {
+    __m512 s = _mm512_set1_ps(scale);
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m512 y = _mm512_loadu_ps(b + 2 * j);
+        __m512 re = _mm512_mul_ps(_mm512_shuffle_ps(y, y, _MM_SHUFFLE(2, 2, 0, 0)), s);
+        __m512 im = _mm512_mul_ps(_mm512_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 1, 1)), s);
+        __m512 sum = _mm512_add_ps(_mm512_loadu_ps(acc + 2 * j), productAVX512(_mm512_loadu_ps(a + 2 * j), re, im));
+        _mm512_storeu_ps(acc + 2 * j, sum);
+    }
+    multiplyAccumulateScalar(acc + 2 * j, a + 2 * j, b + 2 * j, n - j, scale);
+}
+
+KF_TARGET("avx512f") static void conjugateMultiplyAVX512(float* dst, const float* a, const float* b, int n,
+                                                         float scale) {
+    __m512 s = _mm512_set1_ps(scale);
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m512 x = _mm512_loadu_ps(a + 2 * j);
+        __m512 y = _mm512_loadu_ps(b + 2 * j);
+        __m512 re = _mm512_mul_ps(_mm512_shuffle_ps(y, y, _MM_SHUFFLE(2, 2, 0, 0)), s);
+        __m512 im = _mm512_mul_ps(_mm512_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 1, 1)), s);
+        __m512 swapped = _mm512_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm512_storeu_ps(dst + 2 * j, _mm512_fmsubadd_ps(x, re, _mm512_mul_ps(swapped, im)));
+    }
+    conjugateMultiplyScalar(dst + 2 * j, a + 2 * j, b + 2 * j, n - j, scale);
+}
+
+KF_TARGET("avx512f") static void scaledCopyAVX512(float* dst, const float* src, int n, float scale) {
+    __m512 s = _mm512_set1_ps(scale);
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+        _mm512_storeu_ps(dst + j, _mm512_mul_ps(_mm512_loadu_ps(src + j), s));
+    }
+    scaledCopyScalar(dst + j, src + j, n - j, scale);
+}
+
+#endif  // KF_SIMD_X86
+
+// ------------------- Dispatch -------------------
+
+struct SpectrumKernels {
+    void (*multiply)(float*, const float*, const float*, int, float);
+    void (*multiplyAccumulate)(float*, const float*, const float*, int, float);
+    void (*conjugateMultiply)(float*, const float*, const float*, int, float);
+    void (*scaledCopy)(float*, const float*, int, float);
+};
+
+// Indexed by SimdLevel
+static const SpectrumKernels kernel_table[] = {
+    {multiplyScalar, multiplyAccumulateScalar, conjugateMultiplyScalar, scaledCopyScalar},
+    {multiplyScalar, multiplyAccumulateScalar, conjugateMultiplyScalar, scaledCopyScalar},
+#ifdef KF_SIMD_X86
+    {multiplySSE3, multiplyAccumulateSSE3, conjugateMultiplySSE3, scaledCopySSE3},
+    {multiplyAVX2, multiplyAccumulateAVX2, conjugateMultiplyAVX2, scaledCopyAVX2},
+    {multiplyAVX512, multiplyAccumulateAVX512, conjugateMultiplyAVX512, scaledCopyAVX512},
+#endif
+};
+
+SimdLevel detectedSimdLevel() {
+#ifdef KF_SIMD_X86
+    // __builtin_cpu_supports reads CPUID and checks that the OS saves the
+    // wider registers (XGETBV)
+    static const SimdLevel level = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse3")) return SimdLevel::SSE3;
+        return SimdLevel::SCALAR;
+    }();
+    return level;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+// The detected level, capped by KERNELFLOW_SIMD
+static SimdLevel defaultSimdLevel() {
+    SimdLevel level = detectedSimdLevel();
+    if (const char* name = std::getenv("KERNELFLOW_SIMD")) {
+        for (SimdLevel cap : {SimdLevel::SCALAR, SimdLevel::SSE3, SimdLevel::AVX2, SimdLevel::AVX512}) {
+            if (std::strcmp(name, simdLevelName(cap)) == 0 && cap < level) {
+                level = cap;
+            }
+        }
+    }
+    return level;
+}
+
+static std::atomic<int> simd_level{-1};
+
+void setSimdLevel(SimdLevel level) {
+    if (level > detectedSimdLevel()) {
+        throw std::invalid_argument("SIMD level is not supported by this CPU");
+    }
+    simd_level.store(static_cast<int>(level == SimdLevel::AUTO ? defaultSimdLevel() : level));
+}
+
+SimdLevel getSimdLevel() {
+    int level = simd_level.load(std::memory_order_relaxed);
+    if (level < 0) {
+        level = static_cast<int>(defaultSimdLevel());
+        simd_level.store(level);
+    }
+    return static_cast<SimdLevel>(level);
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AUTO: return "auto";
+        case SimdLevel::SCALAR: return "scalar";
+        case SimdLevel::SSE3: return "sse3";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+static const SpectrumKernels& kernels() {
+    return kernel_table[static_cast<int>(getSimdLevel())];
+}
+
+void complexMultiply(std::complex<float>* dst, const std::complex<float>* a, const std::complex<float>* b, int n,
+                     float scale) {
+    kernels().multiply(reinterpret_cast<float*>(dst), reinterpret_cast<const float*>(a),
+                       reinterpret_cast<const float*>(b), n, scale);
+}
+
+void complexMultiplyAccumulate(std::complex<float>* acc, const std::complex<float>* a, const std::complex<float>* b,
+                               int n, float scale) {
+    kernels().multiplyAccumulate(reinterpret_cast<float*>(acc), reinterpret_cast<const float*>(a),
+                                 reinterpret_cast<const float*>(b), n, scale);
+}
+
+void conjugateMultiply(std::complex<float>* dst, const std::complex<float>* a, const std::complex<float>* b, int n,
+                       float scale) {
+    kernels().conjugateMultiply(reinterpret_cast<float*>(dst), reinterpret_cast<const float*>(a),
+                                reinterpret_cast<const float*>(b), n, scale);
+}
+
+void scaledCopy(float* dst, const float* src, int n, float scale) {
+    kernels().scaledCopy(dst, src, n, scale);
+}
@@ -0,0 +1,69 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <complex>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define KF_HAVE_SSE 1
+#endif
+
+// out[j] += weight * in[j] for j in [0, n)
+static inline void axpy(float* __restrict out, const float* __restrict in, float weight, int n) {
+    int j = 0;
+#ifdef KF_HAVE_SSE
+    __m128 w = _mm_set1_ps(weight);
+    for (; j + 8 <= n; j += 8) {
+        __m128 a = _mm_add_ps(_mm_loadu_ps(out + j), _mm_mul_ps(w, _mm_loadu_ps(in + j)));
+        __m128 b = _mm_add_ps(_mm_loadu_ps(out + j + 4), _mm_mul_ps(w, _mm_loadu_ps(in + j + 4)));
+        _mm_storeu_ps(out + j, a);
+        _mm_storeu_ps(out + j + 4, b);
+    }
+#endif
+    for (; j < n; ++j) {
+        out[j] += weight * in[j];
+    }
+}
+
+// ------------------- Spectrum Kernels -------------------
+
+// Instruction sets the spectrum kernels are built for. The best one the
+// CPU and OS support is picked at runtime through CPUID; KERNELFLOW_SIMD
+// (scalar, sse3, avx2 or avx512) caps it.
+enum class SimdLevel {
+    AUTO,    // the detected level, capped by KERNELFLOW_SIMD
+    SCALAR,
+    SSE3,
+    AVX2,    // with FMA
+    AVX512   // AVX-512F
+};
+
+// Best level this machine supports
+SimdLevel detectedSimdLevel();
+
+// Level the kernels run at; setSimdLevel throws std::invalid_argument for
+// a level the machine does not support
+void setSimdLevel(SimdLevel level);
+SimdLevel getSimdLevel();
+
+const char* simdLevelName(SimdLevel level);
+
+// Pointwise products of n complex values, scaled by a real `scale` so an
+// inverse transform's 1/N needs no pass of its own. `dst` may alias `a`.
+
+// dst = scale * a * b
+void complexMultiply(std::complex<float>* dst, const std::complex<float>* a, const std::complex<float>* b, int n,
+                     float scale = 1.0f);
+
+// acc += scale * a * b
+void complexMultiplyAccumulate(std::complex<float>* acc, const std::complex<float>* a, const std::complex<float>* b,
+                               int n, float scale = 1.0f);
+
+// dst = scale * a * conj(b)
+void conjugateMultiply(std::complex<float>* dst, const std::complex<float>* a, const std::complex<float>* b, int n,
+                       float scale = 1.0f);
+
+// dst = scale * src over n floats; `dst` may equal `src`
+void scaledCopy(float* dst, const float* src, int n, float scale);
+
+#endif  // SIMD_H
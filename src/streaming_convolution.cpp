@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "fft_convolution.h"
+#include "simd.h"
+#include "streaming_convolution.h"
+
+// Default number of new samples per transform: large enough that the
+// kernel - 1 samples of overlap are a small part of each transform
+static int defaultBlockSize(int kernel_size) {
+    return std::max(4 * kernel_size, 256);
+}
+
+StreamingConvolver1D::StreamingConvolver1D(const std::vector<float>& kernel,
+                                           int block_size,
+                                           StreamingMethod method,
+                                           Flags flags)
+    : kernelSize(kernel.size()), streamingMethod(method), planFlags(static_cast<unsigned>(flags)), filled(0) {
+    if (kernel.empty()) {
+        throw std::invalid_argument("Kernel must not be empty");
+    }
+
+    int overlap = kernelSize - 1;
+    transformSize = nextSmoothSize((block_size > 0 ? block_size : defaultBlockSize(kernelSize)) + overlap);
+    block = transformSize - overlap;
+    int spectrum_size = transformSize / 2 + 1;
+
+    kernelSpectrum = Tensor<std::complex<float>>(1, spectrum_size);
+    frame = Tensor<float>(1, transformSize);
+    spectrum = Tensor<std::complex<float>>(1, spectrum_size);
+    result = Tensor<float>(1, transformSize);
+    tail = Tensor<float>(1, std::max(overlap, 1));
+
+    // Plan now so that the first chunk does not pay for MEASURE planning
+    resolvePlans();
+
+    // Kernel spectrum with the inverse transform's 1/N folded in
+    std::copy(kernel.begin(), kernel.end(), frame.data());
+    fftwf_execute_dft_r2c(forwardPlan, frame.data(), reinterpret_cast<fftwf_complex*>(kernelSpectrum.data()));
+    scaledCopy(reinterpret_cast<float*>(kernelSpectrum.data()), reinterpret_cast<float*>(kernelSpectrum.data()),
+               2 * spectrum_size, 1.0f / transformSize);
+
+    reset();
+}
+
+// Fetch both plans from the cache. The block length is fixed, so blocks
+// reuse them without the cache's lock, unless the cache has been cleared.
+void StreamingConvolver1D::resolvePlans() {
+    FFTPlanCache& cache = FFTPlanCache::instance();
+    planGeneration = cache.generation();
+    fftwf_complex* spectrum_data = reinterpret_cast<fftwf_complex*>(spectrum.data());
+    forwardPlan = cache.getForwardPlan(1, &transformSize, frame.data(), spectrum_data, planFlags);
+    inversePlan = cache.getInversePlan(1, &transformSize, spectrum_data, result.data(), planFlags);
+    if (!forwardPlan || !inversePlan) {
+        throw std::runtime_error("FFT planning failed");
+    }
+}
+
+void StreamingConvolver1D::reset() {
+    std::fill(frame.data(), frame.data() + transformSize, 0.0f);
+    std::fill(tail.data(), tail.data() + tail.cols(), 0.0f);
+    filled = 0;
+}
+
+// Convolve the current frame and append the block's outputs
+void StreamingConvolver1D::processBlock(std::vector<float>& output) {
+    int overlap = kernelSize - 1;
+    int spectrum_size = transformSize / 2 + 1;
+
+    if (planGeneration != FFTPlanCache::instance().generation()) {
+        resolvePlans();
+    }
+
+    fftwf_complex* spectrum_data = reinterpret_cast<fftwf_complex*>(spectrum.data());
+    fftwf_execute_dft_r2c(forwardPlan, frame.data(), spectrum_data);
+    complexMultiply(spectrum.data(), spectrum.data(), kernelSpectrum.data(), spectrum_size);
+    // c2r overwrites the spectrum, which is scratch by now
+    fftwf_execute_dft_c2r(inversePlan, spectrum_data, result.data());
+
+    float* out = result.data();
+    if (streamingMethod == StreamingMethod::OVERLAP_SAVE) {
+        // The first kernel - 1 outputs wrapped around; the frame's last
+        // kernel - 1 inputs are the next frame's history
+        output.insert(output.end(), out + overlap, out + overlap + block);
+        std::memmove(frame.data(), frame.data() + block, overlap * sizeof(float));
+    } else {
+        // Add the previous blocks' tail, emit the block and carry the rest
+        float* carry = tail.data();
+        for (int i = 0; i < overlap; ++i) {
+            out[i] += carry[i];
+        }
+        output.insert(output.end(), out, out + block);
+        std::copy(out + block, out + block + overlap, carry);
+    }
+}
+
+void StreamingConvolver1D::process(const float* input, std::size_t count, std::vector<float>& output) {
+    // Overlap-save appends new samples after the history, overlap-add
+    // fills the front of a frame whose last kernel - 1 samples stay zero
+    int offset = streamingMethod == StreamingMethod::OVERLAP_SAVE ? kernelSize - 1 : 0;
+    while (count > 0) {
+        int take = static_cast<int>(std::min<std::size_t>(count, block - filled));
+        std::copy(input, input + take, frame.data() + offset + filled);
+        filled += take;
+        input += take;
+        count -= take;
+        if (filled == block) {
+            processBlock(output);
+            filled = 0;
+        }
+    }
+}
+
+std::vector<float> StreamingConvolver1D::process(const std::vector<float>& input) {
+    std::vector<float> output;
+    output.reserve(input.size() + block);
+    process(input.data(), input.size(), output);
+    return output;
+}
+
+void StreamingConvolver1D::flush(std::vector<float>& output) {
+    int offset = streamingMethod == StreamingMethod::OVERLAP_SAVE ? kernelSize - 1 : 0;
+    std::size_t target = output.size() + filled + kernelSize - 1;
+
+    // Push zeros through until the tail has been emitted
+    while (output.size() < target) {
+        std::fill(frame.data() + offset + filled, frame.data() + offset + block, 0.0f);
+        processBlock(output);
+        filled = 0;
+    }
+    output.resize(target);
+    reset();
+}
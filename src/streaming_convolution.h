@@ -0,0 +1,78 @@
+#ifndef STREAMING_CONVOLUTION_H
+#define STREAMING_CONVOLUTION_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FFTWisdom.h"
+#include "FFTWrapper.h"
+#include "Tensor.h"
+#include "convolution.h"
+
+enum class StreamingMethod {
+    OVERLAP_SAVE,  // transform the last kernel - 1 inputs again, discard the wrapped outputs
+    OVERLAP_ADD    // transform each block zero-padded, carry the kernel - 1 output tail
+};
+
+// Causal 1D convolution of an unbounded signal fed in chunks of any length.
+// The kernel spectrum and FFT plans are prepared once; every `blockSize()`
+// input samples cost one forward and one inverse transform of `fftSize()`
+// points and emit `blockSize()` output samples, so memory is O(block) and
+// the per-sample cost O(log block). Nothing is allocated after construction
+// apart from growth of the caller's output vector.
+//
+// Concatenating every process() output and the final flush() gives the
+// FULL convolution of the whole stream with the kernel.
+class StreamingConvolver1D {
+private:
+    int kernelSize;
+    int block;
+    int transformSize;
+    StreamingMethod streamingMethod;
+    unsigned planFlags;
+    fftwf_plan forwardPlan;                      // resolved once, not per block
+    fftwf_plan inversePlan;
+    std::uint64_t planGeneration;                // FFTPlanCache::generation() of the plans
+
+    Tensor<std::complex<float>> kernelSpectrum;  // pre-scaled by 1 / transformSize
+    Tensor<float> frame;                         // transform input
+    Tensor<std::complex<float>> spectrum;
+    Tensor<float> result;                        // transform output
+    Tensor<float> tail;                          // overlap-add carry, kernel - 1 samples
+    int filled;                                  // new samples in the current block
+
+    void resolvePlans();
+    void processBlock(std::vector<float>& output);
+
+public:
+    // A block size <= 0 picks one from the kernel length. The block is
+    // grown so that block + kernel - 1 is a 2/3/5/7-smooth FFT size.
+    StreamingConvolver1D(const std::vector<float>& kernel,
+                         int block_size = 0,
+                         StreamingMethod method = StreamingMethod::OVERLAP_SAVE,
+                         Flags flags = getPlanFlags());
+
+    // Feed `count` samples and append every output sample that is complete
+    void process(const float* input, std::size_t count, std::vector<float>& output);
+    std::vector<float> process(const std::vector<float>& input);
+
+    // Emit the outputs of buffered samples and the kernel - 1 sample tail,
+    // then start a new stream
+    void flush(std::vector<float>& output);
+
+    // Drop buffered samples and history
+    void reset();
+
+    int blockSize() const { return block; }
+    int fftSize() const { return transformSize; }
+    StreamingMethod method() const { return streamingMethod; }
+
+    // Input samples waiting for their block to complete
+    int pending() const { return filled; }
+
+    // Transform shape, for pre-planning with FFTWisdom
+    FFTShape fftShape() const { return FFTShape{1, {transformSize, 1}, false}; }
+};
+
+#endif  // STREAMING_CONVOLUTION_H
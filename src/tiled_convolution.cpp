@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <atomic>
+#include <complex>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "fft_convolution.h"
+#include "instrumentation.h"
+#include "parallel.h"
+#include "simd.h"
+#include "tiled_convolution.h"
+#include "workspace.h"
+
+int defaultTileSize(int kernel_size) {
+    return std::max(512 - (kernel_size - 1), 2 * kernel_size);
+}
+
+int tileFFTSize(int tile_size, int kernel_size) {
+    return nextSmoothSize(tile_size + kernel_size - 1);
+}
+
+std::size_t tiledConvolutionMemory(int kernel_rows, int kernel_cols, int tile_size, int threads) {
+    if (tile_size <= 0) {
+        tile_size = std::max(defaultTileSize(kernel_rows), defaultTileSize(kernel_cols));
+    }
+    std::size_t fft_rows = tileFFTSize(tile_size, kernel_rows);
+    std::size_t pitch = 2 * (tileFFTSize(tile_size, kernel_cols) / 2 + 1);
+    // One buffer per worker plus the shared kernel spectrum
+    return fft_rows * pitch * sizeof(float) * (std::max(threads, 1) + 1);
+}
+
+std::size_t tiledConvolutionWorkspace(int rows, int cols, int kernel_rows, int kernel_cols, Padding padding,
+                                      int tile_size) {
+    if (tile_size <= 0) {
+        tile_size = std::max(defaultTileSize(kernel_rows), defaultTileSize(kernel_cols));
+    }
+    int output_rows = convolutionOutputSize(rows, kernel_rows, padding);
+    int output_cols = convolutionOutputSize(cols, kernel_cols, padding);
+    int fft_rows = tileFFTSize(std::min(tile_size, output_rows), kernel_rows);
+    int fft_cols = tileFFTSize(std::min(tile_size, output_cols), kernel_cols);
+    return workspaceTensorBytes(fft_rows, fft_cols, 1, 1, 2 * (fft_cols / 2 + 1));
+}
+
+// Complex view aliasing a row-padded real tile buffer
+static TensorView<std::complex<float>> spectrumOf(const TensorView<float>& t, int rows, int spectrum_cols) {
+    return TensorView<std::complex<float>>(reinterpret_cast<std::complex<float>*>(t.data()),
+                                           rows, spectrum_cols, 1, 1, t.rowStride() / 2,
+                                           t.channelStride() / 2, t.batchStride() / 2);
+}
+
+void tiledConvolve2D(const TensorView<const float>& image,
+                     const TensorView<const float>& kernel,
+                     const TensorView<float>& output,
+                     Padding padding,
+                     float pad_val,
+                     Flags flags,
+                     int tile_size,
+                     int threads) {
+    int kernel_rows = kernel.rows();
+    int kernel_cols = kernel.cols();
+    int output_rows = convolutionOutputSize(image.rows(), kernel_rows, padding);
+    int output_cols = convolutionOutputSize(image.cols(), kernel_cols, padding);
+
+    if (image.empty() || kernel.empty() || output_rows <= 0 || output_cols <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the image");
+    }
+    if (output.rows() != output_rows || output.cols() != output_cols ||
+        output.channels() != image.channels() || output.batch() != image.batch()) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
+
+    // Tile extents: grow each tile to fill its smooth transform size
+    if (tile_size <= 0) {
+        tile_size = std::max(defaultTileSize(kernel_rows), defaultTileSize(kernel_cols));
+    }
+    int fft_rows = tileFFTSize(std::min(tile_size, output_rows), kernel_rows);
+    int fft_cols = tileFFTSize(std::min(tile_size, output_cols), kernel_cols);
+    int tile_rows = fft_rows - (kernel_rows - 1);
+    int tile_cols = fft_cols - (kernel_cols - 1);
+    int spectrum_cols = fft_cols / 2 + 1;
+
+    int tiles_down = (output_rows + tile_rows - 1) / tile_rows;
+    int tiles_across = (output_cols + tile_cols - 1) / tile_cols;
+    int tiles_per_image = tiles_down * tiles_across;
+    long total_tiles = static_cast<long>(tiles_per_image) * image.channels() * image.batch();
+
+    if (threads <= 0) {
+        threads = getNumThreads();
+    }
+    threads = static_cast<int>(std::min<long>(threads, total_tiles));
+
+    // One kernel spectrum at the tile FFT size, shared by every worker
+    std::shared_ptr<const KernelSpectrum> kernel_spectrum = cachedKernelSpectrum(kernel, 2, fft_rows, fft_cols, flags);
+    TensorView<std::complex<float>> fft_kernel = kernel_spectrum->spectrum();
+    float scale = 1.0f / (static_cast<float>(fft_rows) * fft_cols);  // the inverse transform's 1/N
+
+    int top = paddingBefore(kernel_rows, padding);
+    int left = paddingBefore(kernel_cols, padding);
+    std::atomic<long> next_tile{0};
+    std::exception_ptr failure;
+    std::mutex failure_mutex;
+
+    auto worker = [&]() {
+        try {
+            // Each worker stages its tile in its own thread's workspace
+            WorkspaceFrame frame;
+            TensorView<float> tile = frame.tensor(fft_rows, fft_cols, 1, 1, 2 * spectrum_cols);
+            TensorView<std::complex<float>> fft_tile = spectrumOf(tile, fft_rows, spectrum_cols);
+            FFTWrapper tileWrapper;
+
+            for (long t = next_tile++; t < total_tiles; t = next_tile++) {
+                int image_index = static_cast<int>(t / tiles_per_image);
+                int b = image_index / image.channels();
+                int c = image_index % image.channels();
+                int out_top = static_cast<int>(t % tiles_per_image) / tiles_across * tile_rows;
+                int out_left = static_cast<int>(t % tiles_per_image) % tiles_across * tile_cols;
+
+                // The tile's window of the padded image, halo included; output
+                // (i, j) reads padded rows i .. i + kernel_rows - 1
+                padImage(image.image(b, c), tile.window(0, 0, fft_rows, fft_cols),
+                         top - out_top, left - out_left, padding, pad_val);
+
+                if (tileWrapper.performFFT2D(tile, fft_tile, flags) != FFTStatus::SUCCESS) {
+                    throw std::runtime_error("FFT planning failed");
+                }
+                {
+                    ScopedStage stage(Stage::MULTIPLY);
+                    for (int i = 0; i < fft_rows; ++i) {
+                        std::complex<float>* row = fft_tile.row(0, 0, i);
+                        complexMultiply(row, row, fft_kernel.row(0, 0, i), spectrum_cols, scale);
+                    }
+                }
+                if (tileWrapper.performInverseFFT2D(fft_tile, tile, flags, false) != FFTStatus::SUCCESS) {
+                    throw std::runtime_error("FFT planning failed");
+                }
+
+                // The first kernel - 1 rows and cols wrapped around
+                int rows = std::min(tile_rows, output_rows - out_top);
+                int cols = std::min(tile_cols, output_cols - out_left);
+                ScopedStage stage(Stage::CROP);
+                for (int i = 0; i < rows; ++i) {
+                    const float* src = tile.row(0, 0, i + kernel_rows - 1) + kernel_cols - 1;
+                    std::copy(src, src + cols, output.row(b, c, out_top + i) + out_left);
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failure_mutex);
+            if (!failure) failure = std::current_exception();
+            next_tile = total_tiles;
+        }
+    };
+
+    // Every OpenMP thread runs a worker; the worker catches everything, so
+    // no exception escapes the parallel region
+    #pragma omp parallel num_threads(threads)
+    worker();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
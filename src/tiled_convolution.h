@@ -0,0 +1,42 @@
+#ifndef TILED_CONVOLUTION_H
+#define TILED_CONVOLUTION_H
+
+#include <cstddef>
+#include "FFTWrapper.h"
+#include "Tensor.h"
+#include "padding.h"
+
+// Output tile edge used when none is given: the tile plus its halo fills
+// a 512-point transform (about 1 MiB of floats), or twice the kernel for
+// kernels too large for that
+int defaultTileSize(int kernel_size);
+
+// Transform extents of one tile along an axis; the tile is grown so that
+// tile + kernel - 1 is 2/3/5/7-smooth
+int tileFFTSize(int tile_size, int kernel_size);
+
+// Bytes of tile buffers tiledConvolve2D allocates for the given threads
+std::size_t tiledConvolutionMemory(int kernel_rows, int kernel_cols, int tile_size, int threads);
+
+// Workspace bytes each tiledConvolve2D worker takes from its own thread's
+// workspace (see workspace.h)
+std::size_t tiledConvolutionWorkspace(int rows, int cols, int kernel_rows, int kernel_cols, Padding padding,
+                                      int tile_size = 0);
+
+// Overlap-save 2D convolution of every image of `image` with `kernel`.
+// The output is split into tiles of about tile_size x tile_size; each tile
+// reads its window of the (virtually) padded image with a kernel - 1 halo,
+// is transformed at the tile FFT size and multiplied by one shared kernel
+// spectrum, and the part unaffected by wrap-around is written to `output`.
+// Tiles are processed by `threads` workers (0 = getNumThreads()), each owning
+// one tile buffer, so peak memory is O(tile x threads) rather than O(image).
+void tiledConvolve2D(const TensorView<const float>& image,
+                     const TensorView<const float>& kernel,
+                     const TensorView<float>& output,
+                     Padding padding,
+                     float pad_val,
+                     Flags flags,
+                     int tile_size = 0,
+                     int threads = 0);
+
+#endif  // TILED_CONVOLUTION_H
@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "instrumentation.h"
+#include "parallel.h"
+#include "simd.h"
+#include "workspace.h"
+#include "winograd.h"
+
+// ------------------- Transform Matrices -------------------
+
+// Lavin & Gray, "Fast Algorithms for Convolutional Neural Networks"
+static const float BT_2x2[4 * 4] = {
+    1,  0, -1,  0,
+    0,  1,  1,  0,
+    0, -1,  1,  0,
+    0,  1,  0, -1,
+};
+static const float G_2x2[4 * 3] = {
+    1,     0,    0,
+    0.5f,  0.5f, 0.5f,
+    0.5f, -0.5f, 0.5f,
+    0,     0,    1,
+};
+static const float AT_2x2[2 * 4] = {
+    1, 1,  1,  0,
+    0, 1, -1, -1,
+};
+
+static const float BT_4x4[6 * 6] = {
+    4,  0, -5,  0, 1, 0,
+    0, -4, -4,  1, 1, 0,
+    0,  4, -4, -1, 1, 0,
+    0, -2, -1,  2, 1, 0,
+    0,  2, -1, -2, 1, 0,
+    0,  4,  0, -5, 0, 1,
+};
+static const float G_4x4[6 * 3] = {
+    1.0f / 4,   0,          0,
+    -1.0f / 6,  -1.0f / 6,  -1.0f / 6,
+    -1.0f / 6,  1.0f / 6,   -1.0f / 6,
+    1.0f / 24,  1.0f / 12,  1.0f / 6,
+    1.0f / 24,  -1.0f / 12, 1.0f / 6,
+    0,          0,          1,
+};
+static const float AT_4x4[4 * 6] = {
+    1, 1,  1, 1,  1, 0,
+    0, 1, -1, 2, -2, 0,
+    0, 1,  1, 4,  4, 0,
+    0, 1, -1, 8, -8, 1,
+};
+
+struct WinogradMatrices {
+    int m;      // output tile size
+    int alpha;  // input tile size, m + 2
+    const float* BT;
+    const float* G;
+    const float* AT;
+};
+
+static WinogradMatrices matricesFor(WinogradVariant variant) {
+    if (variant == WinogradVariant::F2x2_3x3) {
+        return WinogradMatrices{2, 4, BT_2x2, G_2x2, AT_2x2};
+    }
+    return WinogradMatrices{4, 6, BT_4x4, G_4x4, AT_4x4};
+}
+
+// out (r x r) = L (r x n) * X (n x n) * L^T, where X has row stride `stride`
+static void sandwich(const float* L, int r, int n, const float* X, int stride, float* out) {
+    float tmp[6 * 6];
+    for (int i = 0; i < r; ++i) {
+        for (int j = 0; j < n; ++j) {
+            float sum = 0;
+            for (int k = 0; k < n; ++k) sum += L[i * n + k] * X[k * stride + j];
+            tmp[i * n + j] = sum;
+        }
+    }
+    for (int i = 0; i < r; ++i) {
+        for (int j = 0; j < r; ++j) {
+            float sum = 0;
+            for (int k = 0; k < n; ++k) sum += tmp[i * n + k] * L[j * n + k];
+            out[i * r + j] = sum;
+        }
+    }
+}
+
+WinogradVariant defaultWinogradVariant(int output_rows, int output_cols) {
+    return std::min(output_rows, output_cols) >= 8 ? WinogradVariant::F4x4_3x3 : WinogradVariant::F2x2_3x3;
+}
+
+// ------------------- Filter Cache -------------------
+
+// Transformed filters, laid out as [alpha^2][out][in]
+struct TransformedFilters {
+    WinogradVariant variant;
+    int out_channels;
+    int in_channels;
+    std::vector<float> raw;  // the source filters, to rule out hash collisions
+    std::vector<float> data;
+};
+
+static const std::size_t FILTER_CACHE_CAPACITY = 64;
+static std::mutex filter_cache_mutex;
+static std::list<std::shared_ptr<const TransformedFilters>> filter_cache;  // most recently used first
+
+static std::shared_ptr<const TransformedFilters> transformedFilters(const TensorView<const float>& filters,
+                                                                    WinogradVariant variant) {
+    int out_channels = filters.batch();
+    int in_channels = filters.channels();
+
+    // Entries are compared against the filters in place, so hits do not allocate
+    auto sameFilters = [&](const std::vector<float>& raw) {
+        const float* p = raw.data();
+        for (int k = 0; k < out_channels; ++k)
+            for (int c = 0; c < in_channels; ++c)
+                for (int i = 0; i < 3; ++i, p += 3)
+                    if (!std::equal(p, p + 3, filters.row(k, c, i))) return false;
+        return true;
+    };
+    {
+        std::lock_guard<std::mutex> lock(filter_cache_mutex);
+        for (auto it = filter_cache.begin(); it != filter_cache.end(); ++it) {
+            const TransformedFilters& entry = **it;
+            if (entry.variant == variant && entry.out_channels == out_channels &&
+                entry.in_channels == in_channels && sameFilters(entry.raw)) {
+                filter_cache.splice(filter_cache.begin(), filter_cache, it);
+                return filter_cache.front();
+            }
+        }
+    }
+
+    std::vector<float> raw;
+    raw.reserve(static_cast<std::size_t>(out_channels) * in_channels * 9);
+    for (int k = 0; k < out_channels; ++k)
+        for (int c = 0; c < in_channels; ++c)
+            for (int i = 0; i < 3; ++i)
+                raw.insert(raw.end(), filters.row(k, c, i), filters.row(k, c, i) + 3);
+
+    // U = G g G^T, with g flipped so the correlation Winograd computes is a convolution
+    WinogradMatrices mat = matricesFor(variant);
+    int tile = mat.alpha * mat.alpha;
+    auto entry = std::make_shared<TransformedFilters>();
+    entry->variant = variant;
+    entry->out_channels = out_channels;
+    entry->in_channels = in_channels;
+    entry->data.resize(static_cast<std::size_t>(tile) * out_channels * in_channels);
+    for (int k = 0; k < out_channels; ++k) {
+        for (int c = 0; c < in_channels; ++c) {
+            const float* g = raw.data() + (static_cast<std::size_t>(k) * in_channels + c) * 9;
+            float flipped[9];
+            for (int t = 0; t < 9; ++t) flipped[t] = g[8 - t];
+            float u[6 * 6];
+            sandwich(mat.G, mat.alpha, 3, flipped, 3, u);
+            for (int xi = 0; xi < tile; ++xi) {
+                entry->data[(static_cast<std::size_t>(xi) * out_channels + k) * in_channels + c] = u[xi];
+            }
+        }
+    }
+    entry->raw = std::move(raw);
+
+    std::lock_guard<std::mutex> lock(filter_cache_mutex);
+    filter_cache.push_front(entry);
+    if (filter_cache.size() > FILTER_CACHE_CAPACITY) {
+        filter_cache.pop_back();
+    }
+    return entry;
+}
+
+std::size_t winogradFilterCacheSize() {
+    std::lock_guard<std::mutex> lock(filter_cache_mutex);
+    return filter_cache.size();
+}
+
+void clearWinogradFilterCache() {
+    std::lock_guard<std::mutex> lock(filter_cache_mutex);
+    filter_cache.clear();
+}
+
+// ------------------- Convolution -------------------
+
+// Tiles of one output, and how rows of tiles are split into one band per
+// thread. Each band has scratch for one row of tiles: V is
+// [alpha^2][in][tiles], M is [alpha^2][out][tiles].
+struct WinogradTiling {
+    int tiles_y;
+    int tiles_x;
+    int threads;
+    int bands;
+    std::size_t v_size;
+    std::size_t m_size;
+
+    WinogradTiling(int output_rows, int output_cols, int in_channels, int out_channels, const WinogradMatrices& mat) {
+        int m = mat.m;
+        int tile = mat.alpha * mat.alpha;
+        tiles_y = (output_rows + m - 1) / m;
+        tiles_x = (output_cols + m - 1) / m;
+        threads = parallelThreads(static_cast<double>(output_rows) * output_cols * tile *
+                                  (in_channels + out_channels + in_channels * out_channels) / (m * m));
+        bands = std::min(tiles_y, threads);
+        v_size = static_cast<std::size_t>(tile) * in_channels * tiles_x;
+        m_size = static_cast<std::size_t>(tile) * out_channels * tiles_x;
+    }
+};
+
+std::size_t winogradConvolutionWorkspace(int rows, int cols, int in_channels, int out_channels, Padding padding,
+                                         WinogradVariant variant) {
+    WinogradMatrices mat = matricesFor(variant);
+    WinogradTiling tiling(convolutionOutputSize(rows, 3, padding), convolutionOutputSize(cols, 3, padding),
+                          in_channels, out_channels, mat);
+    return workspaceTensorBytes(tiling.tiles_y * mat.m + 2, tiling.tiles_x * mat.m + 2, in_channels, 1) +
+           Workspace::footprint((tiling.v_size + tiling.m_size) * tiling.bands * sizeof(float));
+}
+
+void winogradConvolveLayer(const TensorView<const float>& input,
+                           const TensorView<const float>& filters,
+                           const TensorView<float>& output,
+                           Padding padding,
+                           float pad_val,
+                           WinogradVariant variant) {
+    ScopedStage stage(Stage::WINOGRAD);
+    int in_channels = input.channels();
+    int out_channels = filters.batch();
+    int output_rows = convolutionOutputSize(input.rows(), 3, padding);
+    int output_cols = convolutionOutputSize(input.cols(), 3, padding);
+
+    if (filters.rows() != 3 || filters.cols() != 3 || filters.channels() != in_channels) {
+        throw std::invalid_argument("Winograd filters must be [out][in][3][3]");
+    }
+    if (input.empty() || output_rows <= 0 || output_cols <= 0) {
+        throw std::invalid_argument("Kernel does not fit in the image");
+    }
+    if (output.rows() != output_rows || output.cols() != output_cols ||
+        output.channels() != out_channels || output.batch() != input.batch()) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
+
+    WinogradMatrices mat = matricesFor(variant);
+    const int m = mat.m;
+    const int alpha = mat.alpha;
+    const int tile = alpha * alpha;
+    std::shared_ptr<const TransformedFilters> U = transformedFilters(filters, variant);
+
+    // Stage the padded input, extended with zeros to a whole number of tiles
+    WinogradTiling tiling(output_rows, output_cols, in_channels, out_channels, mat);
+    int tiles_y = tiling.tiles_y;
+    int tiles_x = tiling.tiles_x;
+    int top = paddingBefore(3, padding);
+    int left = paddingBefore(3, padding);
+    WorkspaceFrame frame;
+    TensorView<float> staged = frame.tensor(tiles_y * m + 2, tiles_x * m + 2, in_channels, 1);
+
+    int threads = tiling.threads;
+    int bands = tiling.bands;
+    int band_tiles = (tiles_y + bands - 1) / bands;
+    std::size_t v_size = tiling.v_size;
+    std::size_t m_size = tiling.m_size;
+    float* scratch = frame.array<float>((v_size + m_size) * bands);
+
+    for (int b = 0; b < input.batch(); ++b) {
+        for (int c = 0; c < in_channels; ++c) {
+            padImage(input.image(b, c), staged.image(0, c).window(0, 0, output_rows + 2, output_cols + 2),
+                     top, left, padding, pad_val);
+        }
+
+        #pragma omp parallel for num_threads(threads) schedule(static)
+        for (int band = 0; band < bands; ++band) {
+            float* V = scratch + (v_size + m_size) * band;
+            float* M = V + v_size;
+            float d[6 * 6], y[4 * 4], mt[6 * 6];
+
+            for (int ty = band * band_tiles; ty < std::min(tiles_y, (band + 1) * band_tiles); ++ty) {
+                // Input transform: V = B^T d B for every tile of the row
+                for (int c = 0; c < in_channels; ++c) {
+                    for (int tx = 0; tx < tiles_x; ++tx) {
+                        const float* src = staged.row(0, c, ty * m) + tx * m;
+                        sandwich(mat.BT, alpha, alpha, src, static_cast<int>(staged.rowStride()), d);
+                        for (int xi = 0; xi < tile; ++xi) {
+                            V[(static_cast<std::size_t>(xi) * in_channels + c) * tiles_x + tx] = d[xi];
+                        }
+                    }
+                }
+
+                // Batched element-wise products: for each xi, M[xi] (out x tiles) = U[xi] (out x in) * V[xi] (in x tiles)
+                std::fill(M, M + m_size, 0.0f);
+                for (int xi = 0; xi < tile; ++xi) {
+                    for (int k = 0; k < out_channels; ++k) {
+                        float* m_row = M + (static_cast<std::size_t>(xi) * out_channels + k) * tiles_x;
+                        const float* u_row = U->data.data() + (static_cast<std::size_t>(xi) * out_channels + k) * in_channels;
+                        for (int c = 0; c < in_channels; ++c) {
+                            axpy(m_row, V + (static_cast<std::size_t>(xi) * in_channels + c) * tiles_x, u_row[c], tiles_x);
+                        }
+                    }
+                }
+
+                // Output transform: Y = A^T M A, clipped at the bottom and right edges
+                int rows_here = std::min(m, output_rows - ty * m);
+                for (int k = 0; k < out_channels; ++k) {
+                    for (int tx = 0; tx < tiles_x; ++tx) {
+                        for (int xi = 0; xi < tile; ++xi) {
+                            mt[xi] = M[(static_cast<std::size_t>(xi) * out_channels + k) * tiles_x + tx];
+                        }
+                        sandwich(mat.AT, m, alpha, mt, alpha, y);
+                        int cols_here = std::min(m, output_cols - tx * m);
+                        for (int i = 0; i < rows_here; ++i) {
+                            std::memcpy(output.row(b, k, ty * m + i) + tx * m, y + i * m, cols_here * sizeof(float));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void winogradConvolve2D(const TensorView<const float>& image,
+                        const TensorView<const float>& kernel,
+                        const TensorView<float>& output,
+                        Padding padding,
+                        float pad_val,
+                        WinogradVariant variant) {
+    if (kernel.rows() != 3 || kernel.cols() != 3) {
+        throw std::invalid_argument("Winograd convolution needs a 3x3 kernel");
+    }
+    if (output.channels() != image.channels() || output.batch() != image.batch()) {
+        throw std::invalid_argument("Output tensor has the wrong shape");
+    }
+
+    // Every image is a single-channel layer with a single filter
+    TensorView<const float> filter = kernel.image(0, 0);
+    for (int b = 0; b < image.batch(); ++b) {
+        for (int c = 0; c < image.channels(); ++c) {
+            winogradConvolveLayer(image.image(b, c), filter, output.image(b, c), padding, pad_val, variant);
+        }
+    }
+}
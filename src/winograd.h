@@ -0,0 +1,45 @@
+#ifndef WINOGRAD_H
+#define WINOGRAD_H
+
+#include <cstddef>
+#include "Tensor.h"
+#include "padding.h"
+
+// Output tile size m of the minimal filtering algorithm F(m x m, 3 x 3)
+enum class WinogradVariant {
+    F2x2_3x3,  // 4x4 input tiles, 16 products per 4 outputs; smallest error
+    F4x4_3x3   // 6x6 input tiles, 36 products per 16 outputs
+};
+
+// F(4x4) unless the output is too small to fill its tiles
+WinogradVariant defaultWinogradVariant(int output_rows, int output_cols);
+
+// Winograd convolution of every image of `image` with one 3x3 kernel
+void winogradConvolve2D(const TensorView<const float>& image,
+                        const TensorView<const float>& kernel,
+                        const TensorView<float>& output,
+                        Padding padding,
+                        float pad_val,
+                        WinogradVariant variant);
+
+// Multi-channel Winograd convolution: `input` is [batch][in][rows][cols],
+// `filters` is [out][in][3][3] (batch = output channels) and `output` is
+// [batch][out][...]. For every tile position the products are a GEMM of
+// the transformed filters (out x in) with the transformed tiles (in x tiles).
+void winogradConvolveLayer(const TensorView<const float>& input,
+                           const TensorView<const float>& filters,
+                           const TensorView<float>& output,
+                           Padding padding,
+                           float pad_val,
+                           WinogradVariant variant);
+
+// Workspace bytes (see workspace.h) winogradConvolveLayer takes from the
+// calling thread's workspace; winogradConvolve2D takes that of one channel
+std::size_t winogradConvolutionWorkspace(int rows, int cols, int in_channels, int out_channels, Padding padding,
+                                         WinogradVariant variant);
+
+// Transformed filter sets are cached by content; inspect or drop the cache
+std::size_t winogradFilterCacheSize();
+void clearWinogradFilterCache();
+
+#endif  // WINOGRAD_H
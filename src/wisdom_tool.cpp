@@ -0,0 +1,124 @@
+// Generates an FFTW wisdom file for the transforms convolve() uses on a list
+// of image and kernel sizes, so services can start with tuned plans.
+//
+// Usage: wisdom_tool [-f estimate|measure|patient] [-a] [-c COSTFILE] -o FILE
+//                    -i SIZE[,SIZE...] -k SIZE[,SIZE...]
+// where SIZE is N (1D) or RxC (2D), -a appends to an existing file and -c
+// also autotunes the algorithm dispatcher and saves its cost model.
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "conv_engine.h"
+#include "convolution.h"
+
+struct Size {
+    int rows;
+    int cols;  // 0 for 1D sizes
+};
+
+static bool parseSizes(const std::string& list, std::vector<Size>& sizes) {
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        Size size{0, 0};
+        char separator = 0;
+        std::stringstream parser(item);
+        parser >> size.rows;
+        if (parser >> separator && !(separator == 'x' && parser >> size.cols)) {
+            return false;
+        }
+        if (size.rows <= 0 || size.cols < 0) {
+            return false;
+        }
+        sizes.push_back(size);
+    }
+    return !sizes.empty();
+}
+
+static bool parseFlags(const std::string& name, Flags& flags) {
+    if (name == "estimate") flags = Flags::ESTIMATE;
+    else if (name == "measure") flags = Flags::MEASURE;
+    else if (name == "patient") flags = Flags::PATIENT;
+    else return false;
+    return true;
+}
+
+static int usage() {
+    std::cerr << "usage: wisdom_tool [-f estimate|measure|patient] [-a] [-c COSTFILE] -o FILE "
+                 "-i SIZE[,SIZE...] -k SIZE[,SIZE...]" << std::endl;
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    std::string outPath;
+    std::string costPath;
+    std::vector<Size> images, kernels;
+    Flags flags = Flags::PATIENT;
+    bool append = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-a") {
+            append = true;
+        } else if (i + 1 < argc && arg == "-c") {
+            costPath = argv[++i];
+        } else if (i + 1 < argc && arg == "-o") {
+            outPath = argv[++i];
+        } else if (i + 1 < argc && arg == "-f") {
+            if (!parseFlags(argv[++i], flags)) return usage();
+        } else if (i + 1 < argc && arg == "-i") {
+            if (!parseSizes(argv[++i], images)) return usage();
+        } else if (i + 1 < argc && arg == "-k") {
+            if (!parseSizes(argv[++i], kernels)) return usage();
+        } else {
+            return usage();
+        }
+    }
+    if (outPath.empty() || images.empty() || kernels.empty()) {
+        return usage();
+    }
+
+    if (append && FFTWisdom::load(outPath) != FFTStatus::SUCCESS) {
+        std::cerr << "warning: could not load " << outPath << ", starting from scratch" << std::endl;
+    }
+
+    // Collect the shapes for every image/kernel pair and padding family
+    std::vector<FFTShape> shapes;
+    for (const auto& image : images) {
+        for (const auto& kernel : kernels) {
+            if ((image.cols == 0) != (kernel.cols == 0)) {
+                continue;  // only pair 1D with 1D and 2D with 2D
+            }
+            for (Padding padding : {Padding::VALID, Padding::ZERO, Padding::FULL}) {
+                std::vector<FFTShape> found = image.cols == 0
+                    ? convolutionFFTShapes(image.rows, kernel.rows, padding)
+                    : convolutionFFTShapes(image.rows, image.cols, kernel.rows, kernel.cols, padding);
+                shapes.insert(shapes.end(), found.begin(), found.end());
+            }
+        }
+    }
+
+    if (FFTWisdom::prePlan(shapes, flags) != FFTStatus::SUCCESS) {
+        std::cerr << "error: planning failed" << std::endl;
+        return 1;
+    }
+    if (FFTWisdom::save(outPath) != FFTStatus::SUCCESS) {
+        std::cerr << "error: could not write " << outPath << std::endl;
+        return 1;
+    }
+
+    std::cout << "Planned " << shapes.size() << " shapes into " << outPath << std::endl;
+
+    if (!costPath.empty()) {
+        setPlanFlags(flags);
+        autotuneCostModel();
+        if (saveCostModel(costPath) != FFTStatus::SUCCESS) {
+            std::cerr << "error: could not write " << costPath << std::endl;
+            return 1;
+        }
+        std::cout << "Saved calibrated cost model to " << costPath << std::endl;
+    }
+    return 0;
+}
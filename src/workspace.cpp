@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include "instrumentation.h"
+#include "workspace.h"
+
+// fftwf_malloc only guarantees the alignment of the SIMD extensions FFTW
+// was built with, so blocks are over-allocated and aligned here
+static void* allocateBlock(std::size_t bytes, char*& aligned) {
+    void* raw = fftwf_malloc(bytes + Workspace::ALIGNMENT);
+    if (!raw) {
+        throw std::bad_alloc();
+    }
+    countAllocation(bytes + Workspace::ALIGNMENT);
+    std::size_t misalignment = reinterpret_cast<std::uintptr_t>(raw) % Workspace::ALIGNMENT;
+    aligned = static_cast<char*>(raw) + (misalignment ? Workspace::ALIGNMENT - misalignment : 0);
+    return raw;
+}
+
+Workspace::Workspace() : raw(nullptr), block(nullptr), blockSize(0), offset(0), high(0) {}
+
+Workspace::Workspace(std::size_t bytes) : Workspace() {
+    reserve(bytes);
+}
+
+Workspace::~Workspace() {
+    for (const Overflow& o : overflow) {
+        fftwf_free(o.ptr);
+    }
+    fftwf_free(raw);
+}
+
+std::size_t Workspace::footprint(std::size_t bytes) {
+    return (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+void Workspace::reserve(std::size_t bytes) {
+    bytes = footprint(bytes);
+    if (offset != 0 || bytes <= blockSize) {
+        return;
+    }
+    fftwf_free(raw);
+    raw = nullptr;
+    block = nullptr;
+    blockSize = 0;
+    raw = allocateBlock(bytes, block);
+    blockSize = bytes;
+}
+
+void Workspace::shrink() {
+    if (offset != 0) {
+        return;
+    }
+    fftwf_free(raw);
+    raw = nullptr;
+    block = nullptr;
+    blockSize = 0;
+    high = 0;
+}
+
+void* Workspace::allocate(std::size_t bytes) {
+    bytes = footprint(bytes);
+    std::size_t start = offset;
+    void* ptr;
+    if (bytes == 0) {
+        return nullptr;
+    }
+    if (start + bytes <= blockSize) {
+        ptr = block + start;
+    } else {
+        char* aligned;
+        overflow.push_back(Overflow{start, allocateBlock(bytes, aligned)});
+        ptr = aligned;
+    }
+    offset = start + bytes;
+    high = std::max(high, offset);
+    return ptr;
+}
+
+void Workspace::rewind(std::size_t mark) {
+    while (!overflow.empty() && overflow.back().offset >= mark) {
+        fftwf_free(overflow.back().ptr);
+        overflow.pop_back();
+    }
+    offset = mark;
+    if (offset == 0 && high > blockSize) {
+        try {
+            reserve(high);
+        } catch (const std::bad_alloc&) {
+            // Requests keep getting blocks of their own
+        }
+    }
+}
+
+// ------------------- Per-thread Workspaces -------------------
+
+static thread_local Workspace* bound_workspace = nullptr;
+
+Workspace& currentWorkspace() {
+    if (bound_workspace) {
+        return *bound_workspace;
+    }
+    thread_local Workspace default_workspace;
+    return default_workspace;
+}
+
+WorkspaceBinding::WorkspaceBinding(Workspace& workspace) : previous(bound_workspace) {
+    bound_workspace = &workspace;
+}
+
+WorkspaceBinding::~WorkspaceBinding() {
+    bound_workspace = previous;
+}
+
+std::size_t workspaceTensorBytes(int rows, int cols, int channels, int batch, int rowPitch, std::size_t element) {
+    if (rowPitch == 0) rowPitch = cols;
+    return Workspace::footprint(static_cast<std::size_t>(rows) * rowPitch * channels * batch * element);
+}
@@ -0,0 +1,119 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <cstddef>
+#include <vector>
+#include "Tensor.h"
+
+// Scratch arena for the convolution backends. Buffers are bump-allocated
+// from one fftwf_malloc block at ALIGNMENT, so the staging tensors of a
+// repeated call land at the same alignment (and reuse the same plans) and
+// steady-state calls do not touch the heap. A request that does not fit
+// gets a block of its own; once the workspace is idle the main block grows
+// to the most ever in use, so only the first call of a new shape allocates.
+//
+// A workspace is used by one thread at a time. Each thread has a default
+// workspace; WorkspaceBinding substitutes an explicit one.
+class Workspace {
+public:
+    static const std::size_t ALIGNMENT = 64;
+
+    Workspace();
+    explicit Workspace(std::size_t bytes);
+    ~Workspace();
+
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+
+    // Bytes a request of `bytes` takes up, alignment included
+    static std::size_t footprint(std::size_t bytes);
+
+    // Grow the main block to at least `bytes` (only while idle)
+    void reserve(std::size_t bytes);
+
+    // Free the main block; the next call allocates it again (only while idle)
+    void shrink();
+
+    std::size_t used() const { return offset; }
+    std::size_t capacity() const { return blockSize; }
+    std::size_t peak() const { return high; }
+
+private:
+    friend class WorkspaceFrame;
+
+    struct Overflow {
+        std::size_t offset;
+        void* ptr;
+    };
+
+    void* raw;
+    char* block;  // raw, rounded up to ALIGNMENT
+    std::size_t blockSize;
+    std::size_t offset;
+    std::size_t high;
+    std::vector<Overflow> overflow;
+
+    void* allocate(std::size_t bytes);
+    void rewind(std::size_t mark);
+};
+
+// Workspace of the calling thread: the bound one, else the thread's default
+Workspace& currentWorkspace();
+
+// Binds `workspace` to the calling thread for the binding's lifetime
+class WorkspaceBinding {
+private:
+    Workspace* previous;
+
+public:
+    explicit WorkspaceBinding(Workspace& workspace);
+    ~WorkspaceBinding();
+    WorkspaceBinding(const WorkspaceBinding&) = delete;
+    WorkspaceBinding& operator=(const WorkspaceBinding&) = delete;
+};
+
+// Scope of scratch buffers: everything handed out through a frame is
+// returned when it closes. Frames nest like the calls that open them.
+class WorkspaceFrame {
+private:
+    Workspace& workspace;
+    std::size_t mark;
+
+public:
+    explicit WorkspaceFrame(Workspace& ws = currentWorkspace()) : workspace(ws), mark(ws.offset) {}
+    ~WorkspaceFrame() { workspace.rewind(mark); }
+    WorkspaceFrame(const WorkspaceFrame&) = delete;
+    WorkspaceFrame& operator=(const WorkspaceFrame&) = delete;
+
+    // Uninitialized array of `count` elements
+    template <typename T>
+    T* array(std::size_t count) {
+        return static_cast<T*>(workspace.allocate(count * sizeof(T)));
+    }
+
+    // Uninitialized tensor whose rows are `rowPitch` (default `cols`) apart
+    template <typename T = float>
+    TensorView<T> uninitializedTensor(int rows, int cols, int channels = 1, int batch = 1, int rowPitch = 0) {
+        if (rowPitch == 0) rowPitch = cols;
+        std::ptrdiff_t channelPitch = static_cast<std::ptrdiff_t>(rows) * rowPitch;
+        T* data = array<T>(static_cast<std::size_t>(channelPitch) * channels * batch);
+        return TensorView<T>(data, rows, cols, channels, batch, rowPitch, channelPitch, channelPitch * channels);
+    }
+
+    // Same, zero-filled
+    template <typename T = float>
+    TensorView<T> tensor(int rows, int cols, int channels = 1, int batch = 1, int rowPitch = 0) {
+        TensorView<T> t = uninitializedTensor<T>(rows, cols, channels, batch, rowPitch);
+        std::size_t count = static_cast<std::size_t>(t.batchStride()) * batch;
+        for (std::size_t i = 0; i < count; ++i) {
+            new (t.data() + i) T();
+        }
+        return t;
+    }
+};
+
+// Bytes of scratch a tensor of this shape takes up in a workspace
+std::size_t workspaceTensorBytes(int rows, int cols, int channels = 1, int batch = 1, int rowPitch = 0,
+                                 std::size_t element = sizeof(float));
+
+#endif  // WORKSPACE_H
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "src/conv_engine.h"
+#include "src/convolution.h"
+#include "src/fft_convolution.h"
+#include "src/instrumentation.h"
+#include "src/parallel.h"
+
+static float value(int i, int j, int seed) {
+    return static_cast<float>((i * 31 + j * 17 + seed) % 23) * 0.1f - 1.1f;
+}
+
+static Tensor<float> makeSignals(int count, int length, int seed) {
+    Tensor<float> signals(count, length);
+    for (int i = 0; i < count; ++i)
+        for (int j = 0; j < length; ++j) signals(i, j) = value(i, j, seed);
+    return signals;
+}
+
+// Every signal convolved on its own through the direct 1D path
+static Tensor<float> reference(const TensorView<const float>& signals, const TensorView<const float>& kernels,
+                               Padding padding, float pad_val) {
+    ConvAlgorithm previous = getConvAlgorithm();
+    setConvAlgorithm(ConvAlgorithm::DIRECT);
+    Tensor<float> expected(signals.rows(), convolutionOutputSize(signals.cols(), kernels.cols(), padding));
+    for (int i = 0; i < signals.rows(); ++i) {
+        std::vector<float> signal(signals.row(0, 0, i), signals.row(0, 0, i) + signals.cols());
+        const float* taps = kernels.row(0, 0, kernels.rows() == 1 ? 0 : i);
+        std::vector<float> kernel(taps, taps + kernels.cols());
+        std::vector<float> output = convolve(signal, kernel, 1, padding, pad_val);
+        std::copy(output.begin(), output.end(), expected.view().row(0, 0, i));
+    }
+    setConvAlgorithm(previous);
+    return expected;
+}
+
+static void assertClose(const TensorView<const float>& a, const TensorView<const float>& b) {
+    assert(a.rows() == b.rows() && a.cols() == b.cols());
+    for (int i = 0; i < a.rows(); ++i)
+        for (int j = 0; j < a.cols(); ++j) assert(std::abs(a(i, j) - b(i, j)) < 1e-4);
+}
+
+void testMatchesSingleSignals() {
+    // 48 samples wrap natively under circular padding, 50 do not
+    for (int length : {48, 50}) {
+        Tensor<float> signals = makeSignals(9, length, 1);
+        Tensor<float> shared = makeSignals(1, 7, 2);
+        Tensor<float> per_signal = makeSignals(9, 7, 3);
+        for (Padding padding : {Padding::VALID, Padding::ZERO, Padding::FULL, Padding::REFLECT, Padding::CIRCULAR}) {
+            for (const Tensor<float>* kernels : {&shared, &per_signal}) {
+                Tensor<float> expected = reference(signals, *kernels, padding, 0.5f);
+                for (ConvAlgorithm algorithm : {ConvAlgorithm::DIRECT, ConvAlgorithm::FFT, ConvAlgorithm::AUTO}) {
+                    setConvAlgorithm(algorithm);
+                    Tensor<float> output(9, expected.cols());
+                    convolveBatch1D(signals, *kernels, output, padding, 0.5f);
+                    assertClose(output, expected);
+                }
+                setConvAlgorithm(ConvAlgorithm::AUTO);
+            }
+        }
+    }
+
+    // Rows of a wider buffer: the views' pitch is not their length
+    Tensor<float> wide = makeSignals(5, 70, 4);
+    TensorView<const float> signals = wide.view().window(0, 3, 5, 40);
+    Tensor<float> kernels = makeSignals(5, 4, 5);
+    Tensor<float> wide_output(5, 60);
+    TensorView<float> output = wide_output.view().window(0, 10, 5, 40);
+    setConvAlgorithm(ConvAlgorithm::FFT);
+    convolveBatch1D(signals, kernels, output, Padding::ZERO);
+    setConvAlgorithm(ConvAlgorithm::AUTO);
+    assertClose(output, reference(signals, kernels, Padding::ZERO, 0.0f));
+}
+
+void testBatchedPlans() {
+#ifndef KERNELFLOW_NO_INSTRUMENTATION
+    // One thread: a single batched transform pair for the whole batch, plus
+    // one batched transform of per-signal kernels
+    setNumThreads(1);
+    Tensor<float> signals = makeSignals(64, 40, 6);
+    Tensor<float> shared = makeSignals(1, 9, 7);
+    Tensor<float> per_signal = makeSignals(64, 9, 8);
+    Tensor<float> output(64, 40);
+    fftConvolveBatch1D(signals, shared, output, Padding::ZERO, 0, Flags::ESTIMATE);  // caches the kernel spectrum
+    resetInstrumentation();
+    fftConvolveBatch1D(signals, shared, output, Padding::ZERO, 0, Flags::ESTIMATE);
+    assert(instrumentationSnapshot().calls(Stage::FORWARD_FFT) == 1);
+    assert(instrumentationSnapshot().calls(Stage::INVERSE_FFT) == 1);
+    resetInstrumentation();
+    fftConvolveBatch1D(signals, per_signal, output, Padding::ZERO, 0, Flags::ESTIMATE);
+    assert(instrumentationSnapshot().calls(Stage::FORWARD_FFT) == 2);
+    assert(instrumentationSnapshot().calls(Stage::INVERSE_FFT) == 1);
+    setNumThreads(0);
+#endif
+}
+
+void testThreadedSlices() {
+    // Enough work for three uneven slices; results do not depend on the split
+    Tensor<float> signals = makeSignals(701, 28, 9);
+    Tensor<float> kernels = makeSignals(701, 5, 10);
+    Tensor<float> serial(701, 28), threaded(701, 28);
+    setNumThreads(1);
+    fftConvolveBatch1D(signals, kernels, serial, Padding::REFLECT, 0, Flags::ESTIMATE);
+    setNumThreads(3);
+    resetInstrumentation();
+    fftConvolveBatch1D(signals, kernels, threaded, Padding::REFLECT, 0, Flags::ESTIMATE);
+#ifndef KERNELFLOW_NO_INSTRUMENTATION
+    assert(instrumentationSnapshot().calls(Stage::INVERSE_FFT) == 3);
+#endif
+    setNumThreads(0);
+    assertClose(threaded, serial);
+    assertClose(threaded, reference(signals, kernels, Padding::REFLECT, 0.0f));
+}
+
+void testInvalidArguments() {
+    Tensor<float> signals = makeSignals(4, 20, 1);
+    Tensor<float> output(4, 20);
+    Tensor<float> kernels = makeSignals(3, 5, 2);  // neither one nor one per signal
+    Tensor<float> long_kernel = makeSignals(1, 21, 3);
+    Tensor<float> wrong_output(4, 19);
+    Tensor<float> kernel = makeSignals(1, 5, 4);
+
+    for (ConvAlgorithm algorithm : {ConvAlgorithm::DIRECT, ConvAlgorithm::FFT}) {
+        setConvAlgorithm(algorithm);
+        bool thrown = false;
+        try {
+            convolveBatch1D(signals, kernels, output, Padding::ZERO);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        thrown = false;
+        try {
+            convolveBatch1D(signals, long_kernel, output, Padding::VALID);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        thrown = false;
+        try {
+            convolveBatch1D(signals, kernel, wrong_output, Padding::ZERO);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    setConvAlgorithm(ConvAlgorithm::AUTO);
+}
+
+int main() {
+    testMatchesSingleSignals();
+    testBatchedPlans();
+    testThreadedSlices();
+    testInvalidArguments();
+    std::cout << "All batched convolution tests passed!" << std::endl;
+    return 0;
+}
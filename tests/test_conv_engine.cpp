@@ -0,0 +1,90 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include "src/conv_engine.h"
+#include "src/convolution.h"
+
+void testBackendsAgree() {
+    Tensor<float> image(11, 14, 2, 1);
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < 11; ++i)
+            for (int j = 0; j < 14; ++j)
+                image(0, c, i, j) = static_cast<float>((i * 3 + j * 5 + c) % 9) - 4;
+
+    for (int kernel_size : {1, 3, 4}) {
+        Tensor<float> kernel(kernel_size, kernel_size + 1);
+        for (int i = 0; i < kernel_size; ++i)
+            for (int j = 0; j <= kernel_size; ++j)
+                kernel(i, j) = static_cast<float>(i - j) * 0.5f + 1;
+
+        for (Padding padding : {Padding::VALID, Padding::ZERO, Padding::CONSTANT, Padding::REPLICATE,
+                                Padding::REFLECT, Padding::FULL, Padding::CIRCULAR}) {
+            int rows = convolutionOutputSize(11, kernel_size, padding);
+            int cols = convolutionOutputSize(14, kernel_size + 1, padding);
+            Tensor<float> direct(rows, cols, 2, 1), spectral(rows, cols, 2, 1);
+            dispatchConvolve2D(image, kernel, direct, padding, 0.75f, ConvAlgorithm::DIRECT);
+            dispatchConvolve2D(image, kernel, spectral, padding, 0.75f, ConvAlgorithm::FFT);
+            for (int c = 0; c < 2; ++c)
+                for (int i = 0; i < rows; ++i)
+                    for (int j = 0; j < cols; ++j)
+                        assert(std::abs(direct(0, c, i, j) - spectral(0, c, i, j)) < 1e-3);
+        }
+    }
+
+    // The 1D entry point gives the same answer whichever backend it picks
+    std::vector<float> signal = {1, 2, 3, 4, 5, 6, 7};
+    std::vector<float> taps = {1, 0, -1};
+    setConvAlgorithm(ConvAlgorithm::DIRECT);
+    std::vector<float> direct = convolve(signal, taps, 1, Padding::REFLECT);
+    setConvAlgorithm(ConvAlgorithm::FFT);
+    std::vector<float> spectral = convolve(signal, taps, 1, Padding::REFLECT);
+    setConvAlgorithm(ConvAlgorithm::AUTO);
+    assert(direct.size() == spectral.size());
+    for (size_t i = 0; i < direct.size(); ++i) {
+        assert(std::abs(direct[i] - spectral[i]) < 1e-4);
+    }
+}
+
+void testSelection() {
+    setCostModel(CostModel());
+
+    // Small kernels go direct, large kernels on large images go to the FFT
+    assert(selectAlgorithm(ConvProblem{512, 512, 3, 3, 1, Padding::ZERO, 1}) == ConvAlgorithm::DIRECT);
+    assert(selectAlgorithm(ConvProblem{512, 512, 31, 31, 1, Padding::ZERO, 1}) == ConvAlgorithm::FFT);
+
+    // More threads favour the backend that scales better
+    ConvProblem problem{512, 512, 9, 9, 8, Padding::ZERO, 1};
+    double direct_serial = estimateCost(problem, ConvAlgorithm::DIRECT);
+    problem.threads = 8;
+    assert(estimateCost(problem, ConvAlgorithm::DIRECT) < direct_serial);
+}
+
+void testCostModelPersistence() {
+    const std::string path = "test_costmodel.txt";
+    CostModel model;
+    model.direct_per_mac = 0.125;
+    model.direct_fixed_per_mac = 0.0625;
+    model.fft_per_point_log = 0.5;
+    setCostModel(model);
+    assert(saveCostModel(path) == FFTStatus::SUCCESS);
+
+    setCostModel(CostModel());
+    assert(loadCostModel(path) == FFTStatus::SUCCESS);
+    assert(std::abs(getCostModel().direct_per_mac - 0.125) < 1e-9);
+    assert(std::abs(getCostModel().direct_fixed_per_mac - 0.0625) < 1e-9);
+    assert(std::abs(getCostModel().fft_per_point_log - 0.5) < 1e-9);
+    assert(loadCostModel("does_not_exist.txt") == FFTStatus::FAILURE);
+
+    std::remove(path.c_str());
+    setCostModel(CostModel());
+}
+
+int main() {
+    testBackendsAgree();
+    testSelection();
+    testCostModelPersistence();
+    std::cout << "All engine tests passed!" << std::endl;
+    return 0;
+}
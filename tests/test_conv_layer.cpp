@@ -0,0 +1,119 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include "src/conv_layer.h"
+#include "src/direct_convolution.h"
+
+static const int BATCH = 3, IN = 4, OUT = 5, ROWS = 12, COLS = 15;
+
+static Tensor<float> makeInput() {
+    Tensor<float> input(ROWS, COLS, IN, BATCH);
+    for (int b = 0; b < BATCH; ++b)
+        for (int c = 0; c < IN; ++c)
+            for (int i = 0; i < ROWS; ++i)
+                for (int j = 0; j < COLS; ++j)
+                    input(b, c, i, j) = static_cast<float>((i * 7 + j * 3 + b * 5 + c * 11) % 17) * 0.125f - 1;
+    return input;
+}
+
+static Tensor<float> makeFilters(int size) {
+    Tensor<float> filters(size, size, IN, OUT);
+    for (int k = 0; k < OUT; ++k)
+        for (int c = 0; c < IN; ++c)
+            for (int i = 0; i < size; ++i)
+                for (int j = 0; j < size; ++j)
+                    filters(k, c, i, j) = static_cast<float>((i * 5 + j + k * 3 + c * 7) % 9) * 0.25f - 1;
+    return filters;
+}
+
+// Sum over input channels of single-image direct convolutions
+static void reference(const Tensor<float>& input, const Tensor<float>& filters, const Tensor<float>& output,
+                      Padding padding) {
+    Tensor<float> single(output.rows(), output.cols());
+    for (int b = 0; b < BATCH; ++b)
+        for (int k = 0; k < OUT; ++k)
+            for (int c = 0; c < IN; ++c) {
+                directConvolve2D(input.view().image(b, c), filters.view().image(k, c), single, padding, 0.5f);
+                for (int i = 0; i < output.rows(); ++i)
+                    for (int j = 0; j < output.cols(); ++j)
+                        output(b, k, i, j) += single(i, j);
+            }
+}
+
+void testBackendsMatchReference() {
+    Tensor<float> input = makeInput();
+    for (int size : {3, 5}) {
+        Tensor<float> filters = makeFilters(size);
+        for (Padding padding : {Padding::VALID, Padding::ZERO, Padding::CONSTANT, Padding::REFLECT, Padding::FULL}) {
+            int rows = convolutionOutputSize(ROWS, size, padding);
+            int cols = convolutionOutputSize(COLS, size, padding);
+            Tensor<float> expected(rows, cols, OUT, BATCH);
+            reference(input, filters, expected, padding);
+
+            for (ConvAlgorithm algorithm : {ConvAlgorithm::AUTO, ConvAlgorithm::DIRECT, ConvAlgorithm::WINOGRAD,
+                                            ConvAlgorithm::FFT}) {
+                if (algorithm == ConvAlgorithm::WINOGRAD && size != 3) continue;
+                ConvLayer layer(filters, padding, 0.5f, algorithm);
+                assert(layer.outputRows(ROWS) == rows && layer.outputCols(COLS) == cols);
+                Tensor<float> output(rows, cols, OUT, BATCH);
+                // Run twice so the second call reuses the cached filter spectra
+                for (int pass = 0; pass < 2; ++pass) {
+                    layer.forward(input, output);
+                    for (int b = 0; b < BATCH; ++b)
+                        for (int k = 0; k < OUT; ++k)
+                            for (int i = 0; i < rows; ++i)
+                                for (int j = 0; j < cols; ++j)
+                                    assert(std::abs(output(b, k, i, j) - expected(b, k, i, j)) < 2e-3);
+                }
+            }
+        }
+    }
+}
+
+// A tight memory limit splits the batch without changing the result
+void testBatchSplitting() {
+    Tensor<float> input = makeInput();
+    Tensor<float> filters = makeFilters(5);
+    Tensor<float> expected(ROWS, COLS, OUT, BATCH);
+    reference(input, filters, expected, Padding::ZERO);
+
+    setFFTMemoryLimit(1);
+    ConvLayer layer(filters, Padding::ZERO, 0.5f, ConvAlgorithm::FFT);
+    Tensor<float> output(ROWS, COLS, OUT, BATCH);
+    layer.forward(input, output);
+    setFFTMemoryLimit(static_cast<std::size_t>(512) << 20);
+
+    for (int b = 0; b < BATCH; ++b)
+        for (int k = 0; k < OUT; ++k)
+            for (int i = 0; i < ROWS; ++i)
+                for (int j = 0; j < COLS; ++j)
+                    assert(std::abs(output(b, k, i, j) - expected(b, k, i, j)) < 2e-3);
+}
+
+void testSelection() {
+    setCostModel(CostModel());
+    Tensor<float> filters(7, 7, 64, 64);
+    ConvLayer layer(filters, Padding::ZERO);
+    // Deep 7x7 layers amortize the transforms over the channel pairs
+    assert(layer.algorithmFor(56, 56, 8) == ConvAlgorithm::FFT);
+
+    ConvLayer shape_check(makeFilters(3), Padding::ZERO);
+    Tensor<float> wrong(ROWS, COLS, IN + 1, 1);
+    Tensor<float> output(ROWS, COLS, OUT, 1);
+    bool threw = false;
+    try {
+        shape_check.forward(wrong, output);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main() {
+    testBackendsMatchReference();
+    testBatchSplitting();
+    testSelection();
+    std::cout << "All conv layer tests passed!" << std::endl;
+    return 0;
+}
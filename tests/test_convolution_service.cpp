@@ -0,0 +1,227 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "src/convolution_service.h"
+#include "src/parallel.h"
+
+static Tensor<float> makeImage(int rows, int cols, int channels, int batch, int seed) {
+    Tensor<float> image(rows, cols, channels, batch);
+    for (int b = 0; b < batch; ++b)
+        for (int c = 0; c < channels; ++c)
+            for (int i = 0; i < rows; ++i)
+                for (int j = 0; j < cols; ++j)
+                    image(b, c, i, j) = static_cast<float>((i * 7 + j * 3 + c * 5 + b + seed) % 11) - 5;
+    return image;
+}
+
+static Tensor<float> makeKernel(int rows, int cols, int seed) {
+    Tensor<float> kernel(rows, cols);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j) kernel(i, j) = static_cast<float>((i * 5 + j + seed) % 7) * 0.25f - 0.75f;
+    return kernel;
+}
+
+static Tensor<float> expectedOutput(const Tensor<float>& image, const PreparedKernel& kernel, float pad_val) {
+    int rows = kernel.rank() == 1 ? image.rows() : kernel.outputRows();
+    Tensor<float> output(rows, kernel.outputCols(), image.channels(), image.batch());
+    convolve(image, kernel, output, pad_val);
+    return output;
+}
+
+static void assertSame(const Tensor<float>& a, const Tensor<float>& b) {
+    assert(a.rows() == b.rows() && a.cols() == b.cols() && a.channels() == b.channels() && a.batch() == b.batch());
+    for (int n = 0; n < a.batch(); ++n)
+        for (int c = 0; c < a.channels(); ++c)
+            for (int i = 0; i < a.rows(); ++i)
+                for (int j = 0; j < a.cols(); ++j) assert(std::abs(a(n, c, i, j) - b(n, c, i, j)) < 1e-3);
+}
+
+void testMatchesSynchronous() {
+    // Mixed kernels and shapes from several producers; batched and single
+    // jobs must give what a direct call gives
+    Tensor<float> k1 = makeKernel(3, 3, 0), k2 = makeKernel(5, 4, 1);
+    PreparedKernel a(k1, 24, 20, Padding::ZERO), b(k2, 16, 32, Padding::REFLECT);
+    PreparedKernel line(std::vector<float>{0.5f, -1.0f, 2.0f}, 40, Padding::CONSTANT);
+
+    ServiceOptions options;
+    options.workers = 3;
+    options.queue_capacity = 4;
+    options.max_batch = 3;
+    ConvolutionService service(options);
+    assert(service.workers() == 3);
+
+    const int PRODUCERS = 3, JOBS = 6;
+    std::vector<std::vector<std::future<Tensor<float>>>> futures(PRODUCERS);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p]() {
+            for (int j = 0; j < JOBS; ++j) {
+                int seed = p * JOBS + j;
+                if (seed % 3 == 0) {
+                    futures[p].push_back(service.submit(makeImage(24, 20, 2, 1 + j % 2, seed), a));
+                } else if (seed % 3 == 1) {
+                    futures[p].push_back(service.submit(makeImage(16, 32, 1, 1, seed), b));
+                } else {
+                    futures[p].push_back(service.submit(makeImage(3, 40, 1, 1, seed), line, 0.5f));
+                }
+            }
+        });
+    }
+    for (std::thread& producer : producers) producer.join();
+
+    for (int p = 0; p < PRODUCERS; ++p) {
+        for (int j = 0; j < JOBS; ++j) {
+            int seed = p * JOBS + j;
+            Tensor<float> output = futures[p][j].get();
+            if (seed % 3 == 0) {
+                assertSame(output, expectedOutput(makeImage(24, 20, 2, 1 + j % 2, seed), a, 0.0f));
+            } else if (seed % 3 == 1) {
+                assertSame(output, expectedOutput(makeImage(16, 32, 1, 1, seed), b, 0.0f));
+            } else {
+                assertSame(output, expectedOutput(makeImage(3, 40, 1, 1, seed), line, 0.5f));
+            }
+        }
+    }
+    service.wait();
+    ServiceStats stats = service.stats();
+    assert(stats.submitted == PRODUCERS * JOBS && stats.completed == stats.submitted && stats.failed == 0);
+    assert(stats.queue_depth == 0 && stats.peak_queue_depth <= options.queue_capacity);
+    assert(stats.total_p50_us <= stats.total_p99_us && stats.total_p99_us <= stats.total_max_us);
+    assert(stats.queue_max_us <= stats.total_max_us);
+}
+
+void testBatching() {
+    // One worker lingering long enough for every job to arrive runs them as
+    // one batch
+    Tensor<float> k = makeKernel(3, 3, 2);
+    PreparedKernel kernel(k, 16, 16, Padding::ZERO);
+    ServiceOptions options;
+    options.workers = 1;
+    options.max_batch = 4;
+    options.batch_linger = std::chrono::milliseconds(2000);
+    ConvolutionService service(options);
+
+    std::vector<std::future<Tensor<float>>> futures;
+    for (int j = 0; j < 4; ++j) futures.push_back(service.submit(makeImage(16, 16, 1, 1, j), kernel));
+    for (int j = 0; j < 4; ++j) assertSame(futures[j].get(), expectedOutput(makeImage(16, 16, 1, 1, j), kernel, 0.0f));
+    service.wait();
+    ServiceStats stats = service.stats();
+    assert(stats.batches == 1 && stats.mean_batch == 4);
+
+    service.resetStats();
+    assert(service.stats().submitted == 0 && service.stats().total_max_us == 0);
+}
+
+void testWaitDuringLinger() {
+    // A job held by a lingering worker is neither queued nor finished, but
+    // still counts for wait() and the queue depth
+    Tensor<float> k = makeKernel(3, 3, 4);
+    PreparedKernel kernel(k, 16, 16, Padding::ZERO);
+    ServiceOptions options;
+    options.workers = 1;
+    options.max_batch = 4;
+    options.batch_linger = std::chrono::milliseconds(500);
+    ConvolutionService service(options);
+
+    std::future<Tensor<float>> future = service.submit(makeImage(16, 16, 1, 1, 0), kernel);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    assert(service.stats().queue_depth == 1);
+    service.wait();
+    assert(future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    ServiceStats stats = service.stats();
+    assert(stats.completed == 1 && stats.queue_depth == 0);
+}
+
+void testBackpressure() {
+    // Jobs pile up behind a lingering worker until the queue is full
+    Tensor<float> k = makeKernel(3, 3, 3);
+    PreparedKernel kernel(k, 16, 16, Padding::ZERO);
+    PreparedKernel other(k, 8, 8, Padding::ZERO);
+    ServiceOptions options;
+    options.workers = 1;
+    options.queue_capacity = 2;
+    options.max_batch = 2;
+    options.batch_linger = std::chrono::milliseconds(200);
+    ConvolutionService service(options);
+
+    std::vector<std::future<Tensor<float>>> futures;
+    futures.push_back(service.submit(makeImage(16, 16, 1, 1, 0), kernel));
+    bool rejected = false;
+    Tensor<float> image;
+    int seed = 0;
+    for (; seed < 8 && !rejected; ++seed) {
+        image = makeImage(8, 8, 1, 1, seed);
+        std::optional<std::future<Tensor<float>>> future = service.trySubmit(std::move(image), other);
+        if (future) {
+            futures.push_back(std::move(*future));
+        } else {
+            rejected = true;
+        }
+    }
+    assert(rejected);
+    for (std::future<Tensor<float>>& future : futures) future.get();
+    service.wait();
+
+    // The rejected image was left with the caller and can be retried
+    assert(image.rows() == 8 && image.cols() == 8);
+    std::optional<std::future<Tensor<float>>> retry = service.trySubmit(std::move(image), other);
+    assert(retry);
+    assertSame(retry->get(), expectedOutput(makeImage(8, 8, 1, 1, seed - 1), other, 0.0f));
+    service.wait();
+    ServiceStats stats = service.stats();
+    assert(stats.completed == futures.size() + 1 && stats.peak_queue_depth <= 2);
+}
+
+void testInvalidSubmit() {
+    Tensor<float> k = makeKernel(3, 3, 0);
+    PreparedKernel kernel(k, 16, 16, Padding::ZERO);
+    ConvolutionService service;
+    bool thrown = false;
+    try {
+        service.submit(makeImage(16, 15, 1, 1, 0), kernel);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(service.stats().submitted == 0);
+
+    thrown = false;
+    try {
+        ServiceOptions options;
+        options.max_batch = 0;
+        ConvolutionService invalid(options);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void testThreadLimit() {
+    setNumThreads(4);
+    {
+        ThreadLimit limit(2);
+        assert(getNumThreads() == 2);
+        {
+            ThreadLimit wider(8);
+            assert(getNumThreads() == 2);
+        }
+        assert(getNumThreads() == 2);
+    }
+    assert(getNumThreads() == 4);
+    setNumThreads(0);
+}
+
+int main() {
+    testMatchesSynchronous();
+    testBatching();
+    testWaitDuringLinger();
+    testBackpressure();
+    testInvalidSubmit();
+    testThreadLimit();
+    std::cout << "All convolution service tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "src/correlation.h"
+#include "src/instrumentation.h"
+
+// Deterministic noise in [-1, 1)
+static float noise(std::uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<float>(state >> 8) / (1 << 23) - 1.0f;
+}
+
+static Tensor<float> noiseImage(int rows, int cols, std::uint32_t seed) {
+    Tensor<float> image(rows, cols);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j) image(i, j) = noise(seed);
+    return image;
+}
+
+// Brute-force scores of template t at window (i, j)
+static float reference(const Tensor<float>& image, const Tensor<float>& templates, int t, int i, int j,
+                       MatchMethod method) {
+    int rows = templates.rows(), cols = templates.cols();
+    double n = static_cast<double>(rows) * cols;
+    double image_mean = 0, template_mean = 0;
+    for (int u = 0; u < rows; ++u)
+        for (int v = 0; v < cols; ++v) {
+            image_mean += image(i + u, j + v) / n;
+            template_mean += templates(t, 0, u, v) / n;
+        }
+    if (method == MatchMethod::CROSS_CORRELATION) {
+        image_mean = template_mean = 0;
+    }
+    double product = 0, image_energy = 0, template_energy = 0;
+    for (int u = 0; u < rows; ++u)
+        for (int v = 0; v < cols; ++v) {
+            double x = image(i + u, j + v) - image_mean, w = templates(t, 0, u, v) - template_mean;
+            product += x * w;
+            image_energy += x * x;
+            template_energy += w * w;
+        }
+    if (method == MatchMethod::CROSS_CORRELATION) {
+        return static_cast<float>(product);
+    }
+    return image_energy > 1e-9 && template_energy > 1e-9
+               ? static_cast<float>(product / std::sqrt(image_energy * template_energy))
+               : 0.0f;
+}
+
+void testScoresMatchReference() {
+    // 40 x 37 is staged to a 40 x 40 transform; 48 x 45 is transformed as is
+    for (int cols : {37, 45}) {
+        int rows = cols == 37 ? 40 : 48;
+        Tensor<float> image = noiseImage(rows, cols, 7);
+        Tensor<float> templates(7, 5, 1, 3);
+        std::uint32_t seed = 11;
+        for (int t = 0; t < 2; ++t)
+            for (int i = 0; i < 7; ++i)
+                for (int j = 0; j < 5; ++j) templates(t, 0, i, j) = noise(seed);
+        for (int i = 0; i < 7; ++i)
+            for (int j = 0; j < 5; ++j) templates(2, 0, i, j) = 0.5f;  // constant: ZNCC scores 0
+
+        for (MatchMethod method : {MatchMethod::CROSS_CORRELATION, MatchMethod::ZNCC}) {
+            Tensor<float> output(rows - 6, cols - 4, 1, 3);
+            resetInstrumentation();
+            correlate2D(image, templates, output, method, Flags::ESTIMATE);
+#ifndef KERNELFLOW_NO_INSTRUMENTATION
+            // One transform of the image, one batched transform of the templates
+            assert(instrumentationSnapshot().calls(Stage::FORWARD_FFT) == 2);
+            assert(instrumentationSnapshot().calls(Stage::INVERSE_FFT) == 1);
+#endif
+            for (int t = 0; t < 3; ++t)
+                for (int i = 0; i < rows - 6; ++i)
+                    for (int j = 0; j < cols - 4; ++j)
+                        assert(std::abs(output(t, 0, i, j) - reference(image, templates, t, i, j, method)) < 1e-3);
+        }
+    }
+}
+
+void testTopPeaks() {
+    // Two copies of a patch, one with changed contrast and brightness, are
+    // both perfect ZNCC matches; plain correlation prefers the brighter one
+    Tensor<float> image = noiseImage(48, 40, 3);
+    Tensor<float> templates(6, 6, 1, 2);
+    for (int i = 0; i < 6; ++i)
+        for (int j = 0; j < 6; ++j) {
+            templates(0, 0, i, j) = image(5 + i, 7 + j);
+            templates(1, 0, i, j) = image(30 + i, 2 + j);
+            image(20 + i, 25 + j) = 3.0f * image(5 + i, 7 + j) + 2.0f;
+        }
+
+    std::vector<std::vector<MatchPeak>> peaks = matchTemplates(image, templates, 3, MatchMethod::ZNCC, -1.0f,
+                                                               Flags::ESTIMATE);
+    assert(peaks.size() == 2 && peaks[0].size() == 3 && peaks[1].size() == 3);
+    assert(std::abs(peaks[0][0].score - 1.0f) < 1e-3 && std::abs(peaks[0][1].score - 1.0f) < 1e-3);
+    assert(peaks[0][2].score < 0.9f);
+    bool first = (peaks[0][0].row == 5 && peaks[0][0].col == 7) || (peaks[0][1].row == 5 && peaks[0][1].col == 7);
+    bool second = (peaks[0][0].row == 20 && peaks[0][0].col == 25) || (peaks[0][1].row == 20 && peaks[0][1].col == 25);
+    assert(first && second);
+    assert(peaks[1][0].row == 30 && peaks[1][0].col == 2 && std::abs(peaks[1][0].score - 1.0f) < 1e-3);
+    for (const std::vector<MatchPeak>& best : peaks)
+        for (size_t p = 1; p < best.size(); ++p) assert(best[p - 1].score >= best[p].score);
+
+    // Peaks agree with the score map
+    Tensor<float> scores(43, 35, 1, 2);
+    correlate2D(image, templates, scores, MatchMethod::CROSS_CORRELATION, Flags::ESTIMATE);
+    peaks = matchTemplates(image, templates, 1, MatchMethod::CROSS_CORRELATION, -1e30f, Flags::ESTIMATE);
+    assert(peaks[0][0].row == 20 && peaks[0][0].col == 25);
+    float best = -1e30f;
+    for (int i = 0; i < 43; ++i)
+        for (int j = 0; j < 35; ++j) best = std::max(best, scores(0, 0, i, j));
+    assert(std::abs(peaks[0][0].score - best) < 1e-3);
+
+    // A threshold drops the weaker peaks
+    peaks = matchTemplates(image, templates, 5, MatchMethod::ZNCC, 0.99f, Flags::ESTIMATE);
+    assert(peaks[0].size() == 2 && peaks[1].size() == 1);
+}
+
+void testInvalidArguments() {
+    Tensor<float> image(10, 10);
+    Tensor<float> large(11, 3);
+    Tensor<float> output(1, 1);
+    bool thrown = false;
+    try {
+        correlate2D(image, large, output, MatchMethod::ZNCC);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    Tensor<float> small(3, 3);
+    thrown = false;
+    try {
+        matchTemplates(image, small, 0, MatchMethod::ZNCC);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    thrown = false;
+    try {
+        correlate2D(image, small, output, MatchMethod::CROSS_CORRELATION);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+int main() {
+    testScoresMatchReference();
+    testTopPeaks();
+    testInvalidArguments();
+    std::cout << "All correlation tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "src/conv_engine.h"
+#include "src/convolution.h"
+#include "src/direct_kernels.h"
+#include "src/simd.h"
+
+static float value(int i, int j, int seed) {
+    return static_cast<float>((i * 31 + j * 17 + seed) % 23) * 0.1f - 1.1f;
+}
+
+// Every level the machine supports, scalar first
+static std::vector<SimdLevel> supportedLevels() {
+    std::vector<SimdLevel> levels;
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE3, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level <= detectedSimdLevel()) levels.push_back(level);
+    }
+    return levels;
+}
+
+static const std::vector<std::pair<int, int>> FIXED_SIZES = {{1, 3}, {1, 5}, {1, 7}, {1, 9}, {3, 1}, {5, 1},
+                                                              {7, 1}, {9, 1}, {3, 3}, {5, 5}, {7, 7}};
+
+void testTable() {
+    for (SimdLevel level : supportedLevels()) {
+        setSimdLevel(level);
+        for (const std::pair<int, int>& size : FIXED_SIZES) {
+            assert((fixedDirectKernel(size.first, size.second) != nullptr) == (level >= SimdLevel::SSE3));
+        }
+        assert(fixedDirectKernel(4, 4) == nullptr);
+        assert(fixedDirectKernel(3, 5) == nullptr);
+        assert(fixedDirectKernel(1, 11) == nullptr);
+    }
+    setSimdLevel(SimdLevel::AUTO);
+}
+
+void testRowKernels() {
+    // Lengths cover the scalar (or masked) tails, single vectors and full
+    // register blocks of every level
+    const int pitch = 160;
+    std::vector<float> in(9 * pitch), taps(49);
+    for (int i = 0; i < 9; ++i)
+        for (int j = 0; j < pitch; ++j) in[i * pitch + j] = value(i, j, 1);
+    for (int t = 0; t < 49; ++t) taps[t] = value(t, 0, 2);
+
+    for (SimdLevel level : supportedLevels()) {
+        setSimdLevel(level);
+        for (const std::pair<int, int>& size : FIXED_SIZES) {
+            FixedDirectKernel kernel = fixedDirectKernel(size.first, size.second);
+            if (!kernel) continue;
+            for (int n : {0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 64, 70, 150}) {
+                std::vector<float> out(n + 1, 7.0f);
+                kernel(in.data(), pitch, taps.data(), out.data(), n);
+                for (int j = 0; j < n; ++j) {
+                    double expected = 0;
+                    for (int u = 0; u < size.first; ++u)
+                        for (int v = 0; v < size.second; ++v)
+                            expected += static_cast<double>(taps[u * size.second + v]) * in[u * pitch + j + v];
+                    assert(std::abs(out[j] - expected) < 1e-4);
+                }
+                assert(out[n] == 7.0f);  // nothing written past the row
+            }
+        }
+    }
+    setSimdLevel(SimdLevel::AUTO);
+}
+
+// Brute-force convolution of one image with zero padding and the kernel
+// centred as paddingBefore() places it
+static float reference(const Tensor<float>& image, int c, const Tensor<float>& kernel, int i, int j, int top, int left) {
+    double sum = 0;
+    for (int u = 0; u < kernel.rows(); ++u)
+        for (int v = 0; v < kernel.cols(); ++v) {
+            int y = i - top + kernel.rows() - 1 - u, x = j - left + kernel.cols() - 1 - v;
+            if (y >= 0 && y < image.rows() && x >= 0 && x < image.cols()) {
+                sum += static_cast<double>(kernel(u, v)) * image(0, c, y, x);
+            }
+        }
+    return static_cast<float>(sum);
+}
+
+void testConvolution() {
+    // Fixed sizes and sizes that keep the generic loops agree with the
+    // reference at every level and padding
+    std::vector<std::pair<int, int>> sizes = FIXED_SIZES;
+    sizes.push_back({4, 4});
+    sizes.push_back({2, 3});
+    Tensor<float> image(23, 75, 2);
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < 23; ++i)
+            for (int j = 0; j < 75; ++j) image(0, c, i, j) = value(i, j, c);
+
+    for (SimdLevel level : supportedLevels()) {
+        setSimdLevel(level);
+        for (const std::pair<int, int>& size : sizes) {
+            Tensor<float> kernel(size.first, size.second);
+            for (int u = 0; u < size.first; ++u)
+                for (int v = 0; v < size.second; ++v) kernel(u, v) = value(u, v, 3);
+            for (Padding padding : {Padding::VALID, Padding::ZERO, Padding::FULL}) {
+                int rows = convolutionOutputSize(23, size.first, padding);
+                int cols = convolutionOutputSize(75, size.second, padding);
+                int top = padding == Padding::VALID ? 0 : paddingBefore(size.first, padding);
+                int left = padding == Padding::VALID ? 0 : paddingBefore(size.second, padding);
+                Tensor<float> output(rows, cols, 2);
+                dispatchConvolve2D(image, kernel, output, padding, 0.0f, ConvAlgorithm::DIRECT);
+                for (int c = 0; c < 2; ++c)
+                    for (int i = 0; i < rows; ++i)
+                        for (int j = 0; j < cols; ++j)
+                            assert(std::abs(output(0, c, i, j) - reference(image, c, kernel, i, j, top, left)) < 1e-4);
+            }
+        }
+    }
+    setSimdLevel(SimdLevel::AUTO);
+
+    // Strided problems keep the generic loops; a window of a wider image
+    // feeds the kernels a pitch larger than its width
+    Tensor<float> kernel(3, 3);
+    for (int u = 0; u < 3; ++u)
+        for (int v = 0; v < 3; ++v) kernel(u, v) = value(u, v, 4);
+    Tensor<float> full(23, 75, 2), strided(12, 38, 2);
+    dispatchConvolve2D(image, kernel, full, Padding::ZERO, 0.0f, ConvAlgorithm::DIRECT);
+    dispatchConvolve2D(image, kernel, strided, Padding::ZERO, 0.0f, ConvAlgorithm::DIRECT, 2);
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < 12; ++i)
+            for (int j = 0; j < 38; ++j) assert(std::abs(strided(0, c, i, j) - full(0, c, 2 * i, 2 * j)) < 1e-5);
+
+    TensorView<const float> window = image.view().window(0, 0, 23, 40);
+    Tensor<float> narrow(21, 38, 2);
+    dispatchConvolve2D(window, kernel, narrow, Padding::VALID, 0.0f, ConvAlgorithm::DIRECT);
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < 21; ++i)
+            for (int j = 0; j < 38; ++j) assert(std::abs(narrow(0, c, i, j) - full(0, c, i + 1, j + 1)) < 1e-5);
+}
+
+void testSelection() {
+    // The fixed-size kernels' lower cost moves mid-sized kernels off the FFT
+    setCostModel(CostModel());
+    ConvProblem problem{512, 512, 7, 7, 1, Padding::ZERO, 1};
+    if (fixedDirectKernel(7, 7)) {
+        assert(selectAlgorithm(problem) == ConvAlgorithm::DIRECT);
+        ConvProblem generic{512, 512, 6, 6, 1, Padding::ZERO, 1};
+        assert(estimateCost(problem, ConvAlgorithm::DIRECT) < estimateCost(generic, ConvAlgorithm::DIRECT));
+    }
+
+    // 1D signals pick the specialization through convolve()
+    std::vector<float> signal(300), kernel{0.25f, -0.5f, 1.0f, 0.5f, 0.125f};
+    for (int j = 0; j < 300; ++j) signal[j] = value(0, j, 5);
+    setConvAlgorithm(ConvAlgorithm::DIRECT);
+    std::vector<float> direct = convolve(signal, kernel, 1, Padding::ZERO);
+    setConvAlgorithm(ConvAlgorithm::FFT);
+    std::vector<float> spectral = convolve(signal, kernel, 1, Padding::ZERO);
+    setConvAlgorithm(ConvAlgorithm::AUTO);
+    assert(direct.size() == 300 && spectral.size() == 300);
+    for (int j = 0; j < 300; ++j) assert(std::abs(direct[j] - spectral[j]) < 1e-4);
+}
+
+int main() {
+    testTable();
+    testRowKernels();
+    testConvolution();
+    testSelection();
+    std::cout << "All direct kernel tests passed!" << std::endl;
+    return 0;
+}
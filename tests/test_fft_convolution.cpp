@@ -0,0 +1,136 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include "src/convolution.h"
+#include "src/fft_convolution.h"
+#include "src/instrumentation.h"
+
+// Direct convolution of a zero-padded image, used as the reference
+static std::vector<std::vector<float>> referenceConvolve(const std::vector<std::vector<float>>& image,
+                                                         const std::vector<std::vector<float>>& kernel,
+                                                         Padding padding) {
+    int rows = image.size(), cols = image[0].size();
+    int krows = kernel.size(), kcols = kernel[0].size();
+    int out_rows = convolutionOutputSize(rows, krows, padding);
+    int out_cols = convolutionOutputSize(cols, kcols, padding);
+    int top = paddingBefore(krows, padding), left = paddingBefore(kcols, padding);
+
+    std::vector<std::vector<float>> output(out_rows, std::vector<float>(out_cols, 0));
+    for (int i = 0; i < out_rows; ++i) {
+        for (int j = 0; j < out_cols; ++j) {
+            for (int u = 0; u < krows; ++u) {
+                for (int v = 0; v < kcols; ++v) {
+                    int r = i + krows - 1 - u - top, c = j + kcols - 1 - v - left;
+                    if (r >= 0 && r < rows && c >= 0 && c < cols) {
+                        output[i][j] += image[r][c] * kernel[u][v];
+                    }
+                }
+            }
+        }
+    }
+    return output;
+}
+
+void testSmoothSizes() {
+    assert(nextSmoothSize(1) == 1);
+    assert(nextSmoothSize(11) == 12);
+    assert(nextSmoothSize(13) == 14);
+    assert(nextSmoothSize(64) == 64);
+    assert(nextSmoothSize(1021) == 1024);
+    assert(nextSmoothSize(2039) == 2048);
+    assert(nextSmoothSize(97) == 98);
+}
+
+void testSpectralConvolve() {
+    // A prime-sized image, so every extent gets rounded up
+    std::vector<std::vector<float>> image(13, std::vector<float>(17));
+    for (int i = 0; i < 13; ++i)
+        for (int j = 0; j < 17; ++j)
+            image[i][j] = static_cast<float>((i * 5 + j * 3) % 7) - 3;
+
+    for (auto kernel : {std::vector<std::vector<float>>{{1, 2, 1}, {0, 0, 0}, {-1, -2, -1}},
+                        std::vector<std::vector<float>>{{0.5f, -1, 2, 1}, {3, 0, 1, -2}}}) {
+        for (Padding padding : {Padding::VALID, Padding::ZERO, Padding::FULL}) {
+            std::vector<std::vector<float>> result = convolve(image, kernel, 1, padding);
+            std::vector<std::vector<float>> expected = referenceConvolve(image, kernel, padding);
+
+            assert(result.size() == expected.size());
+            for (size_t i = 0; i < result.size(); ++i) {
+                assert(result[i].size() == expected[i].size());
+                for (size_t j = 0; j < result[i].size(); ++j) {
+                    assert(std::abs(result[i][j] - expected[i][j]) < 1e-3);
+                }
+            }
+        }
+    }
+}
+
+// Circular convolution of every image in `image`, computed directly
+static Tensor<float> referenceCircular(const Tensor<float>& image, const Tensor<float>& kernel) {
+    int rows = image.rows(), cols = image.cols();
+    int top = paddingBefore(kernel.rows(), Padding::CIRCULAR), left = paddingBefore(kernel.cols(), Padding::CIRCULAR);
+    Tensor<float> output(rows, cols, image.channels(), image.batch());
+    for (int b = 0; b < image.batch(); ++b)
+        for (int c = 0; c < image.channels(); ++c)
+            for (int i = 0; i < rows; ++i)
+                for (int j = 0; j < cols; ++j)
+                    for (int u = 0; u < kernel.rows(); ++u)
+                        for (int v = 0; v < kernel.cols(); ++v) {
+                            int r = ((i + kernel.rows() - 1 - u - top) % rows + rows) % rows;
+                            int q = ((j + kernel.cols() - 1 - v - left) % cols + cols) % cols;
+                            output(b, c, i, j) += image(b, c, r, q) * kernel(u, v);
+                        }
+    return output;
+}
+
+void testCircularPadding() {
+    // 12 x 10 wraps natively on both axes, 12 x 11 only along the rows and
+    // 13 x 11 on neither
+    Tensor<float> kernel(3, 4);
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 4; ++j) kernel(i, j) = static_cast<float>(i * 4 + j) * 0.25f - 1;
+    for (int cols : {10, 11}) {
+        for (int rows : {12, 13}) {
+            Tensor<float> image(rows, cols, 2, 2);
+            for (int b = 0; b < 2; ++b)
+                for (int c = 0; c < 2; ++c)
+                    for (int i = 0; i < rows; ++i)
+                        for (int j = 0; j < cols; ++j)
+                            image(b, c, i, j) = static_cast<float>((i * 7 + j * 3 + c * 5 + b) % 11) - 5;
+            Tensor<float> expected = referenceCircular(image, kernel);
+
+            Tensor<float> output(rows, cols, 2, 2);
+            resetInstrumentation();
+            fftConvolve2D(image, kernel, output, Padding::CIRCULAR, 0.0f, Flags::ESTIMATE);
+#ifndef KERNELFLOW_NO_INSTRUMENTATION
+            // A natively wrapping image goes to the transform unstaged
+            assert((instrumentationSnapshot().calls(Stage::PAD) == 0) == (rows == 12 && cols == 10));
+#endif
+            for (int b = 0; b < 2; ++b)
+                for (int c = 0; c < 2; ++c)
+                    for (int i = 0; i < rows; ++i)
+                        for (int j = 0; j < cols; ++j) assert(std::abs(output(b, c, i, j) - expected(b, c, i, j)) < 1e-3);
+
+            // Each row on its own, as a batch of 1D signals
+            Tensor<float> taps(1, 4);
+            for (int j = 0; j < 4; ++j) taps(0, j) = kernel(1, j);
+            Tensor<float> signals_out(rows, cols, 2, 2);
+            std::shared_ptr<const KernelSpectrum> spectrum =
+                cachedKernelSpectrum(taps, 1, 1, fftConvolutionSize(cols, 4, Padding::CIRCULAR), Flags::ESTIMATE);
+            fftConvolve1D(image, *spectrum, signals_out, Padding::CIRCULAR, 0.0f, Flags::ESTIMATE);
+            Tensor<float> row_expected = referenceCircular(image, taps);
+            for (int b = 0; b < 2; ++b)
+                for (int i = 0; i < rows; ++i)
+                    for (int j = 0; j < cols; ++j) assert(std::abs(signals_out(b, 1, i, j) - row_expected(b, 1, i, j)) < 1e-3);
+        }
+    }
+}
+
+int main() {
+    testSmoothSizes();
+    testSpectralConvolve();
+    testCircularPadding();
+    std::cout << "All FFT convolution tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <cassert>
+#include "src/direct_convolution.h"
+#include "src/fft_convolution.h"
+#include "src/instrumentation.h"
+
+static Tensor<float> pattern(int rows, int cols, int seed) {
+    Tensor<float> t(rows, cols);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j) t(i, j) = static_cast<float>((i * 31 + j * 17 + seed) % 23) * 0.1f - 1;
+    return t;
+}
+
+#ifndef KERNELFLOW_NO_INSTRUMENTATION
+
+static std::string readFile(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+void testStages() {
+    FFTPlanCache::instance().clear();
+    clearKernelSpectrumCache();
+    Tensor<float> image = pattern(32, 30, 1);
+    Tensor<float> kernel = pattern(5, 5, 2);
+    Tensor<float> output(32, 30);
+
+    resetInstrumentation();
+    fftConvolve2D(image, kernel, output, Padding::ZERO, 0.0f, Flags::ESTIMATE);
+    InstrumentationSnapshot first = instrumentationSnapshot();
+    for (Stage stage : {Stage::PAD, Stage::FORWARD_FFT, Stage::MULTIPLY, Stage::INVERSE_FFT, Stage::CROP}) {
+        assert(first.calls(stage) >= 1);
+    }
+    assert(first.calls(Stage::PLAN) >= 2);  // image r2c, kernel r2c and c2r
+    assert(first.nanoseconds(Stage::FORWARD_FFT) >= first.nanoseconds(Stage::PLAN) / 2);
+    assert(first.count(Counter::SPECTRUM_CACHE_MISSES) == 1);
+    assert(first.count(Counter::PLAN_CACHE_MISSES) == first.calls(Stage::PLAN));
+    assert(first.calls(Stage::DIRECT) == 0);
+
+    // The repeat call reuses every plan and the kernel spectrum
+    resetInstrumentation();
+    fftConvolve2D(image, kernel, output, Padding::ZERO, 0.0f, Flags::ESTIMATE);
+    InstrumentationSnapshot second = instrumentationSnapshot();
+    assert(second.calls(Stage::PLAN) == 0);
+    assert(second.count(Counter::PLAN_CACHE_MISSES) == 0);
+    assert(second.count(Counter::PLAN_CACHE_HITS) >= 2);
+    assert(second.count(Counter::SPECTRUM_CACHE_HITS) == 1);
+
+    resetInstrumentation();
+    directConvolve2D(image, kernel, output, Padding::ZERO, 0.0f);
+    assert(instrumentationSnapshot().calls(Stage::DIRECT) == 1);
+}
+
+void testAllocations() {
+    resetInstrumentation();
+    {
+        Tensor<float> a(8, 8);
+        Tensor<double> b(4, 4, 2, 1);
+    }
+    InstrumentationSnapshot snapshot = instrumentationSnapshot();
+    assert(snapshot.count(Counter::ALLOCATIONS) == 2);
+    assert(snapshot.count(Counter::ALLOCATED_BYTES) == 8 * 8 * sizeof(float) + 4 * 4 * 2 * sizeof(double));
+}
+
+void testThreadsAreSummed() {
+    // Totals of threads that have exited are kept
+    resetInstrumentation();
+    std::thread workers[3];
+    for (std::thread& worker : workers) {
+        worker = std::thread([]() {
+            for (int i = 0; i < 10; ++i) {
+                ScopedStage stage(Stage::CROP);
+                countEvent(Counter::PLAN_CACHE_HITS, 2);
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    InstrumentationSnapshot snapshot = instrumentationSnapshot();
+    assert(snapshot.calls(Stage::CROP) == 30);
+    assert(snapshot.count(Counter::PLAN_CACHE_HITS) == 60);
+}
+
+void testOutputFormats() {
+    resetInstrumentation();
+    bool was_tracing = traceEnabled();
+    setTraceEnabled(true);
+    Tensor<float> image = pattern(16, 16, 3);
+    Tensor<float> kernel = pattern(3, 3, 4);
+    Tensor<float> output(16, 16);
+    fftConvolve2D(image, kernel, output, Padding::REFLECT, 0.0f, Flags::ESTIMATE);
+    setTraceEnabled(was_tracing);
+
+    std::string json = instrumentationJSON();
+    assert(json.find("\"forward_fft\": {\"calls\": ") != std::string::npos);
+    assert(json.find("\"plan_cache_hits\": ") != std::string::npos);
+
+    const std::string path = "/tmp/kernelflow_test_trace.json";
+    assert(writeChromeTrace(path));
+    std::string trace = readFile(path);
+    assert(trace.find("\"traceEvents\": [") == 1);
+    assert(trace.find("\"name\": \"inverse_fft\", \"ph\": \"X\"") != std::string::npos);
+    assert(trace.find("\"name\": \"pad\"") != std::string::npos);
+    std::remove(path.c_str());
+
+    assert(!writeInstrumentationJSON("/nonexistent/dir/profile.json"));
+}
+
+#else
+
+void testCompiledOut() {
+    Tensor<float> image = pattern(16, 16, 3);
+    Tensor<float> kernel = pattern(3, 3, 4);
+    Tensor<float> output(16, 16);
+    fftConvolve2D(image, kernel, output, Padding::ZERO, 0.0f, Flags::ESTIMATE);
+    InstrumentationSnapshot snapshot = instrumentationSnapshot();
+    assert(snapshot.calls(Stage::FORWARD_FFT) == 0);
+    assert(snapshot.count(Counter::ALLOCATIONS) == 0);
+    assert(!traceEnabled());
+}
+
+#endif
+
+int main() {
+#ifndef KERNELFLOW_NO_INSTRUMENTATION
+    testStages();
+    testAllocations();
+    testThreadsAreSummed();
+    testOutputFormats();
+#else
+    testCompiledOut();
+#endif
+    std::cout << "All instrumentation tests passed!" << std::endl;
+    return 0;
+}
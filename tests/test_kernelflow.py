@@ -0,0 +1,218 @@
+"""Tests of the kernelflow Python module (make test-python).
+
+Run without numpy, the tests pass float32 memoryviews through the buffer
+protocol; with numpy, the strided-array and allocation paths are covered too.
+"""
+
+import array
+import random
+import threading
+
+import kernelflow as kf
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+
+def floats(values, shape):
+    return memoryview(array.array("f", values)).cast("B").cast("f", shape)
+
+
+def zeros(shape):
+    count = 1
+    for extent in shape:
+        count *= extent
+    return floats([0.0] * count, shape)
+
+
+def pattern(rows, cols, seed=0):
+    return [float((i * 31 + j * 17 + seed) % 23) * 0.1 - 1 for i in range(rows) for j in range(cols)]
+
+
+def reference(image, rows, cols, kernel, kh, kw):
+    """Zero-padded 'same' convolution of flat row-major lists."""
+    top, left = (kh - 1) // 2, (kw - 1) // 2
+    out = []
+    for i in range(rows):
+        for j in range(cols):
+            total = 0.0
+            for u in range(kh):
+                for v in range(kw):
+                    y, x = i + top - u, j + left - v
+                    if 0 <= y < rows and 0 <= x < cols:
+                        total += kernel[u * kw + v] * image[y * cols + x]
+            out.append(total)
+    return out
+
+
+def assert_close(actual, expected, tolerance=1e-3):
+    assert len(actual) == len(expected)
+    for a, e in zip(actual, expected):
+        assert abs(a - e) < tolerance, (a, e)
+
+
+def test_convolve_into_buffer():
+    image, kernel = pattern(12, 10), pattern(3, 5, seed=4)
+    expected = reference(image, 12, 10, kernel, 3, 5)
+    for algorithm in (kf.ConvAlgorithm.DIRECT, kf.ConvAlgorithm.FFT, kf.ConvAlgorithm.AUTO):
+        out = zeros((12, 10))
+        result = kf.convolve(floats(image, (12, 10)), floats(kernel, (3, 5)), out=out, algorithm=algorithm)
+        assert result is out
+        assert_close([x for row in out.tolist() for x in row], expected)
+
+
+def test_batched_and_1d():
+    # [batch][channels][rows][cols] stacks are convolved image by image
+    images = pattern(2 * 3 * 8, 9)
+    kernel = pattern(3, 3, seed=2)
+    out = zeros((2, 3, 8, 9))
+    kf.convolve(floats(images, (2, 3, 8, 9)), floats(kernel, (3, 3)), out=out)
+    flat = out.cast("B").cast("f")
+    for n in range(6):
+        expected = reference(images[n * 72:(n + 1) * 72], 8, 9, kernel, 3, 3)
+        assert_close(flat[n * 72:(n + 1) * 72].tolist(), expected)
+
+    # Signals use 1D kernels; VALID output is shorter
+    signal = [float(i % 5) for i in range(20)]
+    out = zeros((18,))
+    kf.convolve(floats(signal, (20,)), floats([1, 2, 3], (3,)), out=out, padding=kf.Padding.VALID)
+    assert_close(out.tolist(), [signal[i] * 3 + signal[i + 1] * 2 + signal[i + 2] for i in range(18)])
+
+
+def test_convolve_batch():
+    # Every row against a shared kernel, then against its own kernel
+    signals = pattern(6, 16)
+    kernels = pattern(6, 3, seed=7)
+    for shared in (True, False):
+        out = zeros((6, 16))
+        taps = floats(kernels[:3], (3,)) if shared else floats(kernels, (6, 3))
+        result = kf.convolve_batch(floats(signals, (6, 16)), taps, out=out)
+        assert result is out
+        for n in range(6):
+            kernel = kernels[:3] if shared else kernels[n * 3:(n + 1) * 3]
+            expected = reference(signals[n * 16:(n + 1) * 16], 1, 16, kernel, 1, 3)
+            assert_close(out.tolist()[n], expected)
+
+    try:
+        kf.convolve_batch(floats(signals, (6, 16)), floats(kernels[:6], (2, 3)))
+        assert False
+    except ValueError:
+        pass
+
+
+def test_prepared_kernel_and_layer():
+    kernel = pattern(5, 5, seed=1)
+    prepared = kf.PreparedKernel(floats(kernel, (5, 5)), (16, 14))
+    assert prepared.rank == 2 and prepared.input_shape == (16, 14) and prepared.output_shape == (16, 14)
+    image = pattern(16, 14, seed=3)
+    out = zeros((16, 14))
+    kf.convolve_prepared(floats(image, (16, 14)), prepared, out=out)
+    assert_close(out.cast("B").cast("f").tolist(), reference(image, 16, 14, kernel, 5, 5))
+
+    # Two output channels: the first sums both inputs, the second keeps the first input
+    filters = [0, 0, 0, 0, 1, 0, 0, 0, 0] * 2 + [0, 0, 0, 0, 1, 0, 0, 0, 0] + [0.0] * 9
+    layer = kf.ConvLayer(floats(filters, (2, 2, 3, 3)))
+    assert layer.in_channels == 2 and layer.out_channels == 2
+    inputs = pattern(2 * 6, 7)
+    out = zeros((1, 2, 6, 7))
+    layer.forward(floats(inputs, (1, 2, 6, 7)), out=out)
+    flat = out.cast("B").cast("f").tolist()
+    assert_close(flat[:42], [a + b for a, b in zip(inputs[:42], inputs[42:])])
+    assert_close(flat[42:], inputs[:42])
+
+
+def test_template_matching():
+    rng = random.Random(5)
+    image = [rng.uniform(-1, 1) for _ in range(20 * 18)]
+    template = [image[(4 + i) * 18 + 9 + j] for i in range(5) for j in range(4)]
+    scores = zeros((16, 15))
+    kf.correlate(floats(image, (20, 18)), floats(template, (5, 4)), out=scores)
+    assert abs(scores[4, 9] - 1.0) < 1e-3
+    plain = zeros((1, 16, 15))
+    kf.correlate(floats(image, (20, 18)), floats(template, (1, 5, 4)), kf.MatchMethod.CROSS_CORRELATION, out=plain)
+    expected = sum(t * t for t in template)
+    assert abs(plain[0, 4, 9] - expected) < 1e-3
+
+    peaks = kf.match_templates(floats(image, (20, 18)), floats(template + template[::-1], (2, 5, 4)), k=2)
+    assert len(peaks) == 2 and len(peaks[0]) == 2
+    row, col, score = peaks[0][0]
+    assert (row, col) == (4, 9) and abs(score - 1.0) < 1e-3
+
+
+def test_errors():
+    image, kernel = floats(pattern(6, 6), (6, 6)), floats(pattern(3, 3), (3, 3))
+    for bad_out in (zeros((5, 6)), memoryview(bytes(144)).cast("f", (6, 6))):
+        try:
+            kf.convolve(image, kernel, out=bad_out)
+            assert False
+        except (ValueError, BufferError):
+            pass
+    try:
+        kf.convolve(memoryview(array.array("d", [0.0] * 36)).cast("B").cast("d", (6, 6)), kernel,
+                    out=zeros((6, 6)))
+        assert False
+    except TypeError:
+        pass
+
+
+def test_concurrent_callers():
+    # The GIL is released while convolving; results are unaffected by
+    # several Python threads calling in at once
+    image, kernel = pattern(20, 18), pattern(5, 5, seed=9)
+    expected = reference(image, 20, 18, kernel, 5, 5)
+    outs = [zeros((20, 18)) for _ in range(4)]
+
+    def work(out):
+        for _ in range(3):
+            kf.convolve(floats(image, (20, 18)), floats(kernel, (5, 5)), out=out)
+
+    threads = [threading.Thread(target=work, args=(out,)) for out in outs]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    for out in outs:
+        assert_close(out.cast("B").cast("f").tolist(), expected)
+
+
+def test_numpy_arrays():
+    if np is None:
+        return
+    base = np.arange(24 * 30, dtype=np.float32).reshape(24, 30) % 7
+    kernel = np.ones((3, 3), dtype=np.float32) / 9
+
+    # Row-strided views are wrapped in place; a strided last axis is gathered
+    dense = kf.convolve(np.ascontiguousarray(base[::2]), kernel)
+    assert dense.shape == (12, 30) and dense.dtype == np.float32
+    assert np.allclose(kf.convolve(base[::2], kernel), dense, atol=1e-4)
+    assert np.allclose(kf.convolve(base[:, ::2], kernel), kf.convolve(np.ascontiguousarray(base[:, ::2]), kernel),
+                       atol=1e-4)
+
+    # Outputs can be views into a larger caller array
+    canvas = np.zeros((24, 40), dtype=np.float32)
+    kf.convolve(base, kernel, out=canvas[:, 5:35])
+    assert np.allclose(canvas[:, 5:35], kf.convolve(base, kernel), atol=1e-4)
+
+    strided = kf.convolve(base, kernel, stride=2)
+    assert strided.shape == (12, 15)
+    assert np.allclose(strided, kf.convolve(base, kernel)[::2, ::2], atol=1e-4)
+
+    try:
+        kf.convolve(base.astype(np.float64), kernel)
+        assert False
+    except TypeError:
+        pass
+
+
+if __name__ == "__main__":
+    test_convolve_into_buffer()
+    test_batched_and_1d()
+    test_convolve_batch()
+    test_prepared_kernel_and_layer()
+    test_template_matching()
+    test_errors()
+    test_concurrent_callers()
+    test_numpy_arrays()
+    print("All kernelflow tests passed!")
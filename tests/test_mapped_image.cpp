@@ -0,0 +1,149 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include "src/conv_engine.h"
+#include "src/mapped_image.h"
+
+static const std::string RAW_PATH = "test_mapped_image.raw";
+static const std::string KFIM_PATH = "test_mapped_image.kfim";
+static const std::string OUTPUT_PATH = "test_mapped_output.kfim";
+
+static Tensor<float> makeImage(int rows, int cols, int channels) {
+    Tensor<float> image(rows, cols, channels);
+    for (int c = 0; c < channels; ++c)
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < cols; ++j) image(0, c, i, j) = static_cast<float>((i * 7 + j * 3 + c * 5) % 11) - 5;
+    return image;
+}
+
+static void assertClose(const TensorView<const float>& a, const TensorView<const float>& b, float tolerance) {
+    assert(a.rows() == b.rows() && a.cols() == b.cols() && a.channels() == b.channels());
+    for (int c = 0; c < a.channels(); ++c)
+        for (int i = 0; i < a.rows(); ++i)
+            for (int j = 0; j < a.cols(); ++j) assert(std::abs(a(0, c, i, j) - b(0, c, i, j)) <= tolerance);
+}
+
+// Copy a whole mapped image into memory
+static Tensor<float> load(const MappedImage& mapped) {
+    Tensor<float> pixels(mapped.rows(), mapped.cols(), mapped.channels());
+    mapped.readRows(0, pixels);
+    return pixels;
+}
+
+void testRoundTrip() {
+    Tensor<float> image = makeImage(13, 17, 2);
+    {
+        // Tiles that do not divide the image leave padded edge tiles
+        MappedImage tiled;
+        assert(tiled.create(KFIM_PATH, 13, 17, 2, 5, 7) == FFTStatus::SUCCESS);
+        assert(tiled.tiled() && tiled.writable());
+        tiled.writeRows(0, image.view().window(0, 0, 6, 17));
+        tiled.writeRows(6, image.view().window(6, 0, 7, 17));
+        assert(tiled.flush() == FFTStatus::SUCCESS);
+    }
+    MappedImage tiled;
+    assert(tiled.open(KFIM_PATH) == FFTStatus::SUCCESS);
+    assert(tiled.rows() == 13 && tiled.cols() == 17 && tiled.channels() == 2);
+    assert(tiled.tileRows() == 5 && tiled.tileCols() == 7 && !tiled.writable());
+    tiled.prefetchRows(0, 13);
+    assertClose(load(tiled), image, 0.0f);
+    tiled.releaseRows(0, 13);
+    assertClose(load(tiled), image, 0.0f);
+
+    {
+        MappedImage raw;
+        assert(raw.createRaw(RAW_PATH, 13, 17, 2) == FFTStatus::SUCCESS);
+        raw.writeRows(0, image);
+    }
+    MappedImage raw;
+    assert(raw.openRaw(RAW_PATH, 13, 17, 2) == FFTStatus::SUCCESS);
+    assertClose(raw.view(), image, 0.0f);
+
+    // Moving hands over the mapping
+    MappedImage moved(std::move(raw));
+    assert(!raw.isOpen() && moved.isOpen());
+    assertClose(moved.view(), image, 0.0f);
+}
+
+void testOpenFailures() {
+    MappedImage image;
+    assert(image.openRaw(RAW_PATH, 13, 17, 3) == FFTStatus::FAILURE);  // size mismatch
+    assert(!image.isOpen());
+    assert(image.open(RAW_PATH) == FFTStatus::FAILURE);                // no header
+    assert(image.open("no_such_image.kfim") == FFTStatus::FAILURE);
+    {
+        std::ofstream truncated(OUTPUT_PATH, std::ios::binary | std::ios::trunc);
+        truncated << "KFIM";
+    }
+    assert(image.open(OUTPUT_PATH) == FFTStatus::FAILURE);
+
+    assert(image.openRaw(RAW_PATH, 13, 17, 2) == FFTStatus::SUCCESS);
+    bool thrown = false;
+    try {
+        image.writableView();
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void testConvolveMapped() {
+    // Strips of 6 rows split every padding's borders across strips; mapped
+    // results must match the in-memory convolution
+    Tensor<float> image = makeImage(37, 29, 2);
+    Tensor<float> kernel(5, 4);
+    for (int i = 0; i < 5; ++i)
+        for (int j = 0; j < 4; ++j) kernel(i, j) = static_cast<float>((i * 5 + j) % 7) * 0.25f - 0.75f;
+
+    MappedImage raw, tiled;
+    assert(raw.createRaw(RAW_PATH, 37, 29, 2) == FFTStatus::SUCCESS);
+    raw.writeRows(0, image);
+    assert(tiled.create(KFIM_PATH, 37, 29, 2, 7, 5) == FFTStatus::SUCCESS);
+    tiled.writeRows(0, image);
+
+    for (Padding padding : {Padding::VALID, Padding::ZERO, Padding::CONSTANT, Padding::REPLICATE, Padding::REFLECT,
+                            Padding::FULL, Padding::CIRCULAR}) {
+        int rows = convolutionOutputSize(37, 5, padding), cols = convolutionOutputSize(29, 4, padding);
+        Tensor<float> expected(rows, cols, 2);
+        dispatchConvolve2D(image, kernel, expected, padding, 1.5f, ConvAlgorithm::DIRECT);
+
+        for (const MappedImage* input : {&raw, &tiled}) {
+            for (int strip : {6, 0}) {
+                MappedImage dense;
+                assert(dense.createRaw(OUTPUT_PATH, rows, cols, 2) == FFTStatus::SUCCESS);
+                convolveMapped(*input, kernel, dense, padding, 1.5f, strip);
+                assertClose(dense.view(), expected, 1e-3f);
+
+                MappedImage blocks;
+                assert(blocks.create(OUTPUT_PATH, rows, cols, 2, 8, 8) == FFTStatus::SUCCESS);
+                convolveMapped(*input, kernel, blocks, padding, 1.5f, strip);
+                assertClose(load(blocks), expected, 1e-3f);
+            }
+        }
+    }
+
+    MappedImage wrong;
+    assert(wrong.createRaw(OUTPUT_PATH, 36, 29, 2) == FFTStatus::SUCCESS);
+    bool thrown = false;
+    try {
+        convolveMapped(raw, kernel, wrong, Padding::ZERO);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+int main() {
+    testRoundTrip();
+    testOpenFailures();
+    testConvolveMapped();
+    std::remove(RAW_PATH.c_str());
+    std::remove(KFIM_PATH.c_str());
+    std::remove(OUTPUT_PATH.c_str());
+    std::cout << "All mapped image tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <cassert>
+#include <cmath>
+#include "src/conv_engine.h"
+#include "src/conv_layer.h"
+#include "src/fft_convolution.h"
+#include "src/parallel.h"
+#include "src/tiled_convolution.h"
+
+static Tensor<float> pattern(int rows, int cols, int channels, int batch, int seed) {
+    Tensor<float> t(rows, cols, channels, batch);
+    for (int b = 0; b < batch; ++b)
+        for (int c = 0; c < channels; ++c)
+            for (int i = 0; i < rows; ++i)
+                for (int j = 0; j < cols; ++j)
+                    t(b, c, i, j) = static_cast<float>((i * 31 + j * 17 + c * 7 + b * 3 + seed) % 23) * 0.1f - 1;
+    return t;
+}
+
+static void assertClose(const Tensor<float>& a, const Tensor<float>& b, float tolerance) {
+    for (int n = 0; n < a.batch(); ++n)
+        for (int c = 0; c < a.channels(); ++c)
+            for (int i = 0; i < a.rows(); ++i)
+                for (int j = 0; j < a.cols(); ++j) assert(std::abs(a(n, c, i, j) - b(n, c, i, j)) < tolerance);
+}
+
+void testThreadCount() {
+    setNumThreads(3);
+    assert(getNumThreads() == 3);
+    assert(parallelThreads(1) == 1);          // tiny loops stay serial
+    assert(parallelThreads(1e9) == 3);
+    assert(fftThreads(64 * 64) == 1);         // small transforms are planned single-threaded
+    assert(fftThreads(1024 * 1024) == 3);
+
+    setNumThreads(0);
+    assert(getNumThreads() >= 1);
+
+    bool threw = false;
+    try {
+        setNumThreads(-1);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+// Every backend gives the same result whatever the thread count
+void testBackendsMatchAcrossThreadCounts() {
+    Tensor<float> image = pattern(64, 60, 2, 2, 0);
+    Tensor<float> kernel3 = pattern(3, 3, 1, 1, 5);
+    Tensor<float> kernel9 = pattern(9, 9, 1, 1, 9);
+
+    for (ConvAlgorithm algorithm : {ConvAlgorithm::DIRECT, ConvAlgorithm::WINOGRAD, ConvAlgorithm::SEPARABLE,
+                                    ConvAlgorithm::FFT, ConvAlgorithm::TILED_FFT}) {
+        const Tensor<float>& kernel = algorithm == ConvAlgorithm::WINOGRAD ? kernel3 : kernel9;
+        for (Padding padding : {Padding::ZERO, Padding::REFLECT, Padding::VALID}) {
+            int rows = convolutionOutputSize(image.rows(), kernel.rows(), padding);
+            int cols = convolutionOutputSize(image.cols(), kernel.cols(), padding);
+            Tensor<float> serial(rows, cols, 2, 2), threaded(rows, cols, 2, 2);
+            setNumThreads(1);
+            dispatchConvolve2D(image, kernel, serial, padding, 0, algorithm);
+            setNumThreads(4);
+            dispatchConvolve2D(image, kernel, threaded, padding, 0, algorithm);
+            assertClose(serial, threaded, 1e-3f);
+        }
+    }
+
+    // Strided FFT and tiles split over explicit workers
+    Tensor<float> strided_serial(32, 30, 2, 2), strided_threaded(32, 30, 2, 2);
+    setNumThreads(1);
+    dispatchConvolve2D(image, kernel9, strided_serial, Padding::ZERO, 0, ConvAlgorithm::FFT, 2);
+    setNumThreads(4);
+    dispatchConvolve2D(image, kernel9, strided_threaded, Padding::ZERO, 0, ConvAlgorithm::FFT, 2);
+    assertClose(strided_serial, strided_threaded, 1e-3f);
+
+    Tensor<float> tiles_serial(64, 60, 2, 2), tiles_threaded(64, 60, 2, 2);
+    tiledConvolve2D(image, kernel9, tiles_serial, Padding::ZERO, 0, Flags::ESTIMATE, 32, 1);
+    tiledConvolve2D(image, kernel9, tiles_threaded, Padding::ZERO, 0, Flags::ESTIMATE, 32, 4);
+    assertClose(tiles_serial, tiles_threaded, 1e-3f);
+
+    // Many 1D signals: staging, product and crop are split by row
+    Tensor<float> signals = pattern(1024, 60, 1, 1, 7);
+    Tensor<float> taps = pattern(1, 15, 1, 1, 8);
+    std::shared_ptr<const KernelSpectrum> spectrum =
+        cachedKernelSpectrum(taps, 1, 1, fftConvolutionSize(60, 15, Padding::REFLECT), Flags::ESTIMATE);
+    Tensor<float> rows_serial(1024, 60), rows_threaded(1024, 60);
+    setNumThreads(1);
+    fftConvolve1D(signals, *spectrum, rows_serial, Padding::REFLECT, 0, Flags::ESTIMATE);
+    setNumThreads(4);
+    fftConvolve1D(signals, *spectrum, rows_threaded, Padding::REFLECT, 0, Flags::ESTIMATE);
+    assertClose(rows_serial, rows_threaded, 1e-3f);
+    setNumThreads(0);
+}
+
+void testLayerMatchesAcrossThreadCounts() {
+    Tensor<float> filters = pattern(5, 5, 3, 4, 1);
+    Tensor<float> input = pattern(64, 64, 3, 3, 2);
+    for (ConvAlgorithm algorithm : {ConvAlgorithm::DIRECT, ConvAlgorithm::FFT}) {
+        ConvLayer layer(filters, Padding::ZERO, 0, algorithm);
+        Tensor<float> serial(64, 64, 4, 3), threaded(64, 64, 4, 3);
+        setNumThreads(1);
+        layer.forward(input, serial);
+        setNumThreads(4);
+        layer.forward(input, threaded);
+        assertClose(serial, threaded, 1e-3f);
+    }
+    setNumThreads(0);
+}
+
+// Large transform batches are planned once per thread count
+void testThreadedPlansAreCachedSeparately() {
+    Tensor<float> signals = pattern(1024, 128, 1, 1, 3);
+    Tensor<std::complex<float>> spectra(1024, 65);
+    FFTWrapper fftWrapper;
+
+    setNumThreads(1);
+    assert(fftWrapper.performFFT1D(signals, spectra, Flags::ESTIMATE) == FFTStatus::SUCCESS);
+    std::size_t plans = FFTPlanCache::instance().size();
+    assert(fftWrapper.performFFT1D(signals, spectra, Flags::ESTIMATE) == FFTStatus::SUCCESS);
+    assert(FFTPlanCache::instance().size() == plans);
+
+    setNumThreads(4);
+    assert(fftWrapper.performFFT1D(signals, spectra, Flags::ESTIMATE) == FFTStatus::SUCCESS);
+    assert(FFTPlanCache::instance().size() == plans + 1);
+    setNumThreads(0);
+}
+
+// Callers on several threads may plan and convolve concurrently
+void testConcurrentCallers() {
+    FFTPlanCache::instance().clear();
+    clearKernelSpectrumCache();
+    Tensor<float> kernel = pattern(7, 7, 1, 1, 6);
+    std::vector<Tensor<float>> images, outputs;
+    for (int t = 0; t < 4; ++t) {
+        images.push_back(pattern(40 + 10 * t, 50, 1, 1, t));
+        outputs.emplace_back(40 + 10 * t, 50);
+    }
+
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 4; ++t) {
+        callers.emplace_back([&, t]() {
+            fftConvolve2D(images[t], kernel, outputs[t], Padding::ZERO, 0, Flags::ESTIMATE);
+        });
+    }
+    for (std::thread& caller : callers) caller.join();
+
+    for (int t = 0; t < 4; ++t) {
+        Tensor<float> expected(40 + 10 * t, 50);
+        dispatchConvolve2D(images[t], kernel, expected, Padding::ZERO, 0, ConvAlgorithm::DIRECT);
+        assertClose(outputs[t], expected, 1e-3f);
+    }
+}
+
+int main() {
+    testThreadCount();
+    testBackendsMatchAcrossThreadCounts();
+    testLayerMatchesAcrossThreadCounts();
+    testThreadedPlansAreCachedSeparately();
+    testConcurrentCallers();
+    std::cout << "All parallel execution tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include <thread>
+#include "src/FFTWrapper.h"
+
+void testPlanReuse() {
+    FFTWrapper fftWrapper;
+    FFTPlanCache::instance().clear();
+
+    // Test 1: Repeated transforms of the same shape share one plan
+    {
+        std::vector<float> signal = {1, 2, 3, 4, 5, 6, 7, 8};
+        std::vector<std::complex<float>> spectrum;
+
+        for (int i = 0; i < 10; ++i) {
+            assert(fftWrapper.performFFT1D(signal, spectrum, Flags::MEASURE) == FFTStatus::SUCCESS);
+        }
+        assert(FFTPlanCache::instance().size() == 1);
+        assert(spectrum.size() == signal.size() / 2 + 1);
+        assert(std::abs(spectrum[0].real() - 36) < 1e-4);
+    }
+
+    // Test 2: A different size or direction gets its own plan
+    {
+        std::vector<float> signal = {1, 2, 3, 4, 5};
+        std::vector<std::complex<float>> spectrum;
+        fftWrapper.performFFT1D(signal, spectrum, Flags::MEASURE);
+        assert(FFTPlanCache::instance().size() == 2);
+
+        std::vector<float> roundtrip(signal.size());
+        fftWrapper.performInverseFFT1D(spectrum, roundtrip, Flags::MEASURE);
+        assert(FFTPlanCache::instance().size() == 3);
+        for (size_t i = 0; i < signal.size(); ++i) {
+            assert(std::abs(roundtrip[i] - signal[i]) < 1e-4);
+        }
+    }
+}
+
+void testConcurrentUse() {
+    FFTPlanCache::instance().clear();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([]() {
+            FFTWrapper fftWrapper;
+            std::vector<std::vector<float>> image = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+            std::vector<std::vector<std::complex<float>>> spectrum;
+            std::vector<std::vector<float>> roundtrip(3, std::vector<float>(4));
+            for (int i = 0; i < 20; ++i) {
+                fftWrapper.performFFT2D(image, spectrum, Flags::ESTIMATE);
+                fftWrapper.performInverseFFT2D(spectrum, roundtrip, Flags::ESTIMATE);
+            }
+            for (size_t i = 0; i < image.size(); ++i) {
+                for (size_t j = 0; j < image[i].size(); ++j) {
+                    assert(std::abs(roundtrip[i][j] - image[i][j]) < 1e-4);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // One forward and one inverse plan, at most one per buffer alignment
+    assert(FFTPlanCache::instance().size() >= 2);
+}
+
+int main() {
+    testPlanReuse();
+    testConcurrentUse();
+    std::cout << "All plan cache tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include "src/conv_engine.h"
+#include "src/prepared_kernel.h"
+
+static const Padding PADDINGS[] = {Padding::VALID, Padding::ZERO, Padding::CONSTANT, Padding::REPLICATE,
+                                   Padding::REFLECT, Padding::FULL};
+
+void testPrepared1D() {
+    std::vector<float> signal(50);
+    for (int i = 0; i < 50; ++i) signal[i] = static_cast<float>((i * 7) % 11) - 5;
+    std::vector<float> kernel = {0.25f, -1.0f, 2.0f, 0.5f, 1.5f};
+
+    setConvAlgorithm(ConvAlgorithm::DIRECT);
+    for (Padding padding : PADDINGS) {
+        std::vector<float> expected = convolve(signal, kernel, 1, padding, 0.75f);
+        PreparedKernel prepared(kernel, 50, padding);
+        assert(prepared.rank() == 1 && prepared.outputCols() == static_cast<int>(expected.size()));
+        std::vector<float> output = convolve(signal, prepared, 0.75f);
+        assert(output.size() == expected.size());
+        for (size_t i = 0; i < output.size(); ++i) {
+            assert(std::abs(output[i] - expected[i]) < 1e-3);
+        }
+
+        // Rows of a tensor are independent signals
+        Tensor<float> signals(3, 50);
+        Tensor<float> outputs(3, prepared.outputCols());
+        for (int r = 0; r < 3; ++r)
+            for (int i = 0; i < 50; ++i) signals(r, i) = signal[i] * (r + 1);
+        convolve(signals, prepared, outputs, 0.75f);
+        for (int r = 0; r < 3; ++r) {
+            std::vector<float> row(signals.view().row(0, 0, r), signals.view().row(0, 0, r) + 50);
+            std::vector<float> row_expected = convolve(row, kernel, 1, padding, 0.75f);
+            for (size_t i = 0; i < row_expected.size(); ++i) {
+                assert(std::abs(outputs(r, static_cast<int>(i)) - row_expected[i]) < 1e-3);
+            }
+        }
+    }
+    setConvAlgorithm(ConvAlgorithm::AUTO);
+
+    // The signal length is part of the preparation
+    PreparedKernel prepared(kernel, 50, Padding::ZERO);
+    bool threw = false;
+    try {
+        convolve(std::vector<float>(49, 1.0f), prepared);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void testPrepared2D() {
+    Tensor<float> image(20, 17, 1, 2);
+    for (int b = 0; b < 2; ++b)
+        for (int i = 0; i < 20; ++i)
+            for (int j = 0; j < 17; ++j) image(b, 0, i, j) = static_cast<float>((i * 3 + j * 5 + b) % 7) - 3;
+    Tensor<float> kernel(4, 3);
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 3; ++j) kernel(i, j) = static_cast<float>(i * 3 - j) * 0.25f;
+
+    for (Padding padding : PADDINGS) {
+        PreparedKernel prepared(kernel, 20, 17, padding);
+        Tensor<float> expected(prepared.outputRows(), prepared.outputCols(), 1, 2);
+        Tensor<float> output(prepared.outputRows(), prepared.outputCols(), 1, 2);
+        dispatchConvolve2D(image, kernel, expected, padding, 0.5f, ConvAlgorithm::DIRECT);
+        convolve(image, prepared, output, 0.5f);
+        for (int b = 0; b < 2; ++b)
+            for (int i = 0; i < output.rows(); ++i)
+                for (int j = 0; j < output.cols(); ++j)
+                    assert(std::abs(output(b, 0, i, j) - expected(b, 0, i, j)) < 1e-3);
+    }
+}
+
+void testSpectrumCache() {
+    clearKernelSpectrumCache();
+    Tensor<float> image(16, 16);
+    Tensor<float> output(16, 16);
+    Tensor<float> kernel(5, 5);
+    Tensor<float> same_kernel(5, 5);
+    kernel(2, 2) = 1;
+    same_kernel(2, 2) = 1;
+
+    // Equal contents hit the same entry, wherever the kernel lives
+    dispatchConvolve2D(image, kernel, output, Padding::ZERO, 0, ConvAlgorithm::FFT);
+    dispatchConvolve2D(image, same_kernel, output, Padding::ZERO, 0, ConvAlgorithm::FFT);
+    assert(kernelSpectrumCacheSize() == 1);
+    PreparedKernel prepared(same_kernel, 16, 16, Padding::ZERO);
+    assert(kernelSpectrumCacheSize() == 1);
+
+    // A different kernel or transform shape is a new entry
+    same_kernel(0, 0) = 2;
+    dispatchConvolve2D(image, same_kernel, output, Padding::ZERO, 0, ConvAlgorithm::FFT);
+    assert(kernelSpectrumCacheSize() == 2);
+    Tensor<float> valid(12, 12);
+    dispatchConvolve2D(image, kernel, valid, Padding::VALID, 0, ConvAlgorithm::FFT);
+    assert(kernelSpectrumCacheSize() == 3);
+
+    // Least recently used entries are evicted first
+    setKernelSpectrumCacheCapacity(1);
+    assert(kernelSpectrumCacheSize() == 1);
+    setKernelSpectrumCacheCapacity(16);
+    clearKernelSpectrumCache();
+    assert(kernelSpectrumCacheSize() == 0);
+
+    // Prepared kernels keep their spectrum after it leaves the cache
+    Tensor<float> result(16, 16);
+    image(8, 8) = 3;
+    convolve(image, prepared, result);
+    assert(std::abs(result(8, 8) - 3) < 1e-4);
+}
+
+int main() {
+    testPrepared1D();
+    testPrepared2D();
+    testSpectrumCache();
+    std::cout << "All prepared kernel tests passed!" << std::endl;
+    return 0;
+}
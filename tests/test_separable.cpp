@@ -0,0 +1,170 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include "src/conv_engine.h"
+#include "src/instrumentation.h"
+#include "src/parallel.h"
+#include "src/separable_convolution.h"
+
+static Tensor<float> outerSum(const std::vector<std::vector<float>>& columns, const std::vector<std::vector<float>>& rows) {
+    Tensor<float> kernel(columns[0].size(), rows[0].size());
+    for (size_t t = 0; t < columns.size(); ++t)
+        for (size_t u = 0; u < columns[t].size(); ++u)
+            for (size_t v = 0; v < rows[t].size(); ++v)
+                kernel(u, v) += columns[t][u] * rows[t][v];
+    return kernel;
+}
+
+void testDecomposition() {
+    // Gaussian and Sobel kernels are rank 1
+    std::vector<float> gauss = {0.05f, 0.25f, 0.4f, 0.25f, 0.05f};
+    assert(decomposeKernel(outerSum({gauss}, {gauss}), 1e-5).rank() == 1);
+    assert(decomposeKernel(outerSum({{1, 2, 1}}, {{1, 0, -1}}), 1e-5).rank() == 1);
+
+    // A sum of two independent terms is rank 2, and the factors rebuild it
+    Tensor<float> kernel = outerSum({{1, 2, 3, 4}, {0, 1, 0, -1}}, {{1, -1, 2, 0, 1, 3}, {2, 2, 0, 1, 0, 1}});
+    SeparableKernel separable = decomposeKernel(kernel, 1e-5);
+    assert(separable.rank() == 2 && separable.rows == 4 && separable.cols == 6);
+    for (int u = 0; u < 4; ++u)
+        for (int v = 0; v < 6; ++v) {
+            float sum = 0;
+            for (int t = 0; t < separable.rank(); ++t) sum += separable.column_factors[t][u] * separable.row_factors[t][v];
+            assert(std::abs(sum - kernel(u, v)) < 1e-4);
+        }
+
+    // A generic kernel is full rank; a zero kernel has no terms
+    Tensor<float> generic(5, 5);
+    for (int u = 0; u < 5; ++u)
+        for (int v = 0; v < 5; ++v) generic(u, v) = static_cast<float>((u * u * 7 + v * 3 + u * v) % 11) - 5;
+    assert(decomposeKernel(generic, 1e-5).rank() == 5);
+    assert(decomposeKernel(Tensor<float>(3, 3), 1e-5).rank() == 0);
+}
+
+void testRankBound() {
+    // Decomposition stops with no terms once the rank is past the bound
+    Tensor<float> generic(5, 5);
+    for (int u = 0; u < 5; ++u)
+        for (int v = 0; v < 5; ++v) generic(u, v) = static_cast<float>((u * u * 7 + v * 3 + u * v) % 11) - 5;
+    assert(decomposeKernel(generic, 1e-5, 2).rank() == 0);
+    assert(decomposeKernel(generic, 1e-5, 4).rank() == 0);
+    assert(decomposeKernel(generic, 1e-5, 5).rank() == 5);
+    Tensor<float> rank2 = outerSum({{1, 2, 3}, {0, 1, -1}}, {{1, -1, 2}, {2, 2, 0}});
+    assert(decomposeKernel(rank2, 1e-5, 2).rank() == 2);
+    assert(decomposeKernel(rank2, 1e-5, 1).rank() == 0);
+    assert(decomposeKernel(rank2, 1e-5, 0).rank() == 0);
+
+    // Cached answers respect the bound they were computed under
+    clearSeparableKernelCache();
+    assert(cachedSeparableKernel(rank2, 1e-5, 1)->rank() == 0);
+    assert(cachedSeparableKernel(rank2, 1e-5, 2)->rank() == 2);
+    assert(cachedSeparableKernel(rank2, 1e-5, 3)->rank() == 2);
+}
+
+void testTwoPassMatchesDirect() {
+    const int rows = 21, cols = 1500;  // wider than one column strip
+    Tensor<float> image(rows, cols, 2, 1);
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < cols; ++j) image(0, c, i, j) = static_cast<float>((i * 13 + j * 7 + c) % 17) * 0.125f - 1;
+
+    Tensor<float> kernel = outerSum({{1, 2, 3, 4, 5}, {1, 0, -1, 0, 1}}, {{0.5f, 1, -1}, {1, 1, 1}});
+    SeparableKernel separable = decomposeKernel(kernel, 1e-5);
+    for (Padding padding : {Padding::VALID, Padding::ZERO, Padding::CONSTANT, Padding::REPLICATE,
+                            Padding::REFLECT, Padding::FULL}) {
+        int out_rows = convolutionOutputSize(rows, 5, padding);
+        int out_cols = convolutionOutputSize(cols, 3, padding);
+        Tensor<float> expected(out_rows, out_cols, 2, 1), output(out_rows, out_cols, 2, 1);
+        dispatchConvolve2D(image, kernel, expected, padding, 0.5f, ConvAlgorithm::DIRECT);
+        separableConvolve2D(image, separable, output, padding, 0.5f);
+        for (int c = 0; c < 2; ++c)
+            for (int i = 0; i < out_rows; ++i)
+                for (int j = 0; j < out_cols; ++j) assert(std::abs(output(0, c, i, j) - expected(0, c, i, j)) < 1e-3);
+    }
+}
+
+void testUnevenBands() {
+    // 5 output rows on 4 threads: bands of 2 rows, so only 3 bands exist and
+    // no task may prime its ring from rows past the image
+    setNumThreads(4);
+    const int rows = 7, cols = 20000;
+    Tensor<float> image(rows, cols);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j) image(i, j) = static_cast<float>((i * 5 + j * 3) % 11) * 0.25f;
+    Tensor<float> kernel = outerSum({{1, 2, 1}}, {{1, 2, 1}});
+    Tensor<float> expected(5, cols - 2), output(5, cols - 2);
+    dispatchConvolve2D(image, kernel, expected, Padding::VALID, 0, ConvAlgorithm::DIRECT);
+    separableConvolve2D(image, decomposeKernel(kernel, 1e-5), output, Padding::VALID, 0);
+    setNumThreads(0);
+    for (int i = 0; i < 5; ++i)
+        for (int j = 0; j < cols - 2; ++j) assert(std::abs(output(i, j) - expected(i, j)) < 1e-3);
+}
+
+void testSelection() {
+    setCostModel(CostModel());
+    ConvProblem problem{512, 512, 9, 9, 1, Padding::ZERO, 1};
+    assert(estimateCost(problem, ConvAlgorithm::SEPARABLE) < 0);
+    problem.kernel_rank = 1;
+    assert(selectAlgorithm(problem) == ConvAlgorithm::SEPARABLE);
+    problem.kernel_rank = 9;
+    assert(selectAlgorithm(problem) != ConvAlgorithm::SEPARABLE);
+
+    // AUTO detects a box filter and still gives the direct result
+    Tensor<float> image(64, 64), box(7, 7), expected(64, 64), output(64, 64);
+    for (int i = 0; i < 64; ++i)
+        for (int j = 0; j < 64; ++j) image(i, j) = static_cast<float>((i * j) % 5);
+    for (int u = 0; u < 7; ++u)
+        for (int v = 0; v < 7; ++v) box(u, v) = 1.0f / 49;
+    dispatchConvolve2D(image, box, expected, Padding::REFLECT, 0, ConvAlgorithm::DIRECT);
+    dispatchConvolve2D(image, box, output, Padding::REFLECT, 0);
+    for (int i = 0; i < 64; ++i)
+        for (int j = 0; j < 64; ++j) assert(std::abs(output(i, j) - expected(i, j)) < 1e-4);
+}
+
+void testAutoDecomposition() {
+#ifndef KERNELFLOW_NO_INSTRUMENTATION
+    setCostModel(CostModel());
+    clearSeparableKernelCache();
+
+    // A large full-rank kernel cannot win as SEPARABLE even at rank 1, so
+    // AUTO never decomposes it
+    Tensor<float> image(96, 96), large(63, 63), output(96, 96);
+    for (int i = 0; i < 96; ++i)
+        for (int j = 0; j < 96; ++j) image(i, j) = static_cast<float>((i * 13 + j * 7) % 17) * 0.125f - 1;
+    for (int u = 0; u < 63; ++u)
+        for (int v = 0; v < 63; ++v) large(u, v) = static_cast<float>((u * u * 7 + v * 3 + u * v) % 11) - 5;
+    ConvProblem problem{96, 96, 63, 63, 1, Padding::ZERO, getNumThreads()};
+    double other = estimateCost(problem, selectAlgorithm(problem));
+    problem.kernel_rank = 1;
+    assert(estimateCost(problem, ConvAlgorithm::SEPARABLE) >= other);
+    resetInstrumentation();
+    dispatchConvolve2D(image, large, output, Padding::ZERO, 0);
+    InstrumentationSnapshot snapshot = instrumentationSnapshot();
+    assert(snapshot.count(Counter::DECOMPOSITION_CACHE_HITS) == 0);
+    assert(snapshot.count(Counter::DECOMPOSITION_CACHE_MISSES) == 0);
+
+    // A kernel that can win as SEPARABLE is decomposed on the first call only
+    std::vector<float> taps = {1, 8, 28, 56, 70, 56, 28, 8, 1};
+    Tensor<float> box = outerSum({taps}, {taps});
+    ConvProblem small{96, 96, 9, 9, 1, Padding::ZERO, getNumThreads()};
+    small.kernel_rank = 1;
+    assert(selectAlgorithm(small) == ConvAlgorithm::SEPARABLE);
+    Tensor<float> small_output(96, 96);
+    resetInstrumentation();
+    for (int r = 0; r < 3; ++r) dispatchConvolve2D(image, box, small_output, Padding::ZERO, 0);
+    snapshot = instrumentationSnapshot();
+    assert(snapshot.count(Counter::DECOMPOSITION_CACHE_MISSES) == 1);
+    assert(snapshot.count(Counter::DECOMPOSITION_CACHE_HITS) == 2);
+#endif
+}
+
+int main() {
+    testDecomposition();
+    testRankBound();
+    testTwoPassMatchesDirect();
+    testUnevenBands();
+    testSelection();
+    testAutoDecomposition();
+    std::cout << "All separable convolution tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <vector>
+#include "src/conv_engine.h"
+#include "src/fft_convolution.h"
+#include "src/simd.h"
+
+static std::vector<std::complex<float>> pattern(int n, int seed) {
+    std::vector<std::complex<float>> v(n);
+    for (int j = 0; j < n; ++j) {
+        v[j] = {static_cast<float>((j * 31 + seed) % 23) * 0.1f - 1, static_cast<float>((j * 17 + seed) % 19) * 0.1f - 1};
+    }
+    return v;
+}
+
+static bool close(std::complex<float> a, std::complex<float> b) {
+    return std::abs(a - b) <= 1e-5f * (1 + std::abs(b));
+}
+
+// Every level the machine supports, scalar first
+static std::vector<SimdLevel> supportedLevels() {
+    std::vector<SimdLevel> levels;
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE3, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level <= detectedSimdLevel()) levels.push_back(level);
+    }
+    return levels;
+}
+
+void testKernels() {
+    // Sizes cover empty input, the scalar tails and several full vectors
+    for (SimdLevel level : supportedLevels()) {
+        setSimdLevel(level);
+        assert(getSimdLevel() == level);
+        for (int n : {0, 1, 3, 7, 8, 17, 100}) {
+            std::vector<std::complex<float>> a = pattern(n, 1), b = pattern(n, 2), acc = pattern(n, 3);
+            std::vector<std::complex<float>> product(n), conjugate(n), accumulated = acc, in_place = a;
+            complexMultiply(product.data(), a.data(), b.data(), n, 0.25f);
+            conjugateMultiply(conjugate.data(), a.data(), b.data(), n, 0.5f);
+            complexMultiplyAccumulate(accumulated.data(), a.data(), b.data(), n, 2.0f);
+            complexMultiply(in_place.data(), in_place.data(), b.data(), n);
+            for (int j = 0; j < n; ++j) {
+                assert(close(product[j], 0.25f * a[j] * b[j]));
+                assert(close(conjugate[j], 0.5f * a[j] * std::conj(b[j])));
+                assert(close(accumulated[j], acc[j] + 2.0f * a[j] * b[j]));
+                assert(close(in_place[j], a[j] * b[j]));
+            }
+
+            std::vector<float> src(2 * n), dst(2 * n);
+            for (int j = 0; j < 2 * n; ++j) src[j] = static_cast<float>(j) - 5;
+            scaledCopy(dst.data(), src.data(), 2 * n, 0.125f);
+            scaledCopy(src.data(), src.data(), 2 * n, 0.125f);
+            for (int j = 0; j < 2 * n; ++j) assert(dst[j] == (static_cast<float>(j) - 5) * 0.125f && src[j] == dst[j]);
+        }
+    }
+    setSimdLevel(SimdLevel::AUTO);
+}
+
+void testUnsupportedLevel() {
+    if (detectedSimdLevel() == SimdLevel::AVX512) return;
+    bool thrown = false;
+    try {
+        setSimdLevel(SimdLevel::AVX512);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void testConvolutionsAgree() {
+    // The FFT backends fold 1/N into the multiply; every level must still
+    // match the direct result
+    Tensor<float> image(30, 27, 3, 2);
+    Tensor<float> kernel(5, 4);
+    for (int b = 0; b < 2; ++b)
+        for (int c = 0; c < 3; ++c)
+            for (int i = 0; i < 30; ++i)
+                for (int j = 0; j < 27; ++j) image(b, c, i, j) = static_cast<float>((i * 7 + j * 3 + c + b * 5) % 13) - 6;
+    for (int i = 0; i < 5; ++i)
+        for (int j = 0; j < 4; ++j) kernel(i, j) = static_cast<float>((i * 5 + j) % 7) * 0.25f - 0.5f;
+
+    Tensor<float> expected(30, 27, 3, 2);
+    dispatchConvolve2D(image, kernel, expected, Padding::ZERO, 0.0f, ConvAlgorithm::DIRECT);
+    for (SimdLevel level : supportedLevels()) {
+        setSimdLevel(level);
+        for (ConvAlgorithm algorithm : {ConvAlgorithm::FFT, ConvAlgorithm::TILED_FFT}) {
+            Tensor<float> output(30, 27, 3, 2);
+            dispatchConvolve2D(image, kernel, output, Padding::ZERO, 0.0f, algorithm);
+            for (int b = 0; b < 2; ++b)
+                for (int c = 0; c < 3; ++c)
+                    for (int i = 0; i < 30; ++i)
+                        for (int j = 0; j < 27; ++j) assert(std::abs(output(b, c, i, j) - expected(b, c, i, j)) < 1e-3);
+        }
+    }
+    setSimdLevel(SimdLevel::AUTO);
+}
+
+int main() {
+    std::cout << "Detected SIMD level: " << simdLevelName(detectedSimdLevel()) << std::endl;
+    testKernels();
+    testUnsupportedLevel();
+    testConvolutionsAgree();
+    std::cout << "All SIMD tests passed!" << std::endl;
+    return 0;
+}
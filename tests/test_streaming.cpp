@@ -0,0 +1,100 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include "src/convolution.h"
+#include "src/instrumentation.h"
+#include "src/streaming_convolution.h"
+
+static std::vector<float> makeSignal(int n) {
+    std::vector<float> signal(n);
+    for (int i = 0; i < n; ++i) {
+        signal[i] = static_cast<float>((i * 37 + 11) % 23) * 0.125f - 1.0f;
+    }
+    return signal;
+}
+
+// Chunked streaming output equals the FULL convolution of the whole signal
+void testMatchesFullConvolution() {
+    std::vector<float> signal = makeSignal(3000);
+    for (int kernel_size : {1, 5, 64, 301}) {
+        std::vector<float> kernel = makeSignal(kernel_size + 7);
+        kernel.resize(kernel_size);
+        std::vector<float> expected = convolve(signal, kernel, 1, Padding::FULL);
+
+        for (StreamingMethod method : {StreamingMethod::OVERLAP_SAVE, StreamingMethod::OVERLAP_ADD}) {
+            // Blocks both shorter and longer than the kernel
+            for (int block_size : {0, 16, 1000}) {
+                StreamingConvolver1D convolver(kernel, block_size, method, Flags::ESTIMATE);
+                assert(convolver.fftSize() == convolver.blockSize() + kernel_size - 1);
+
+                std::vector<float> output;
+                std::size_t chunks[] = {1, 7, 250, 33, 999};
+                std::size_t pos = 0;
+                for (int c = 0; pos < signal.size(); ++c) {
+                    std::size_t count = std::min(chunks[c % 5], signal.size() - pos);
+                    convolver.process(signal.data() + pos, count, output);
+                    pos += count;
+                    // Output only lags the input by the buffered samples
+                    assert(output.size() + convolver.pending() == pos);
+                }
+                convolver.flush(output);
+
+                assert(output.size() == expected.size());
+                for (size_t i = 0; i < output.size(); ++i) {
+                    assert(std::abs(output[i] - expected[i]) < 1e-3);
+                }
+            }
+        }
+    }
+}
+
+// flush() starts a new stream with no history from the previous one
+void testFlushResets() {
+    std::vector<float> kernel = {0.5f, -1.0f, 0.25f};
+    std::vector<float> signal = makeSignal(100);
+    StreamingConvolver1D convolver(kernel, 32, StreamingMethod::OVERLAP_SAVE, Flags::ESTIMATE);
+
+    std::vector<float> first = convolver.process(signal);
+    convolver.flush(first);
+    assert(convolver.pending() == 0);
+    std::vector<float> second = convolver.process(signal);
+    convolver.flush(second);
+
+    assert(first.size() == signal.size() + kernel.size() - 1);
+    assert(first.size() == second.size());
+    for (size_t i = 0; i < first.size(); ++i) {
+        assert(std::abs(first[i] - second[i]) < 1e-5);
+    }
+}
+
+// Blocks reuse the plans resolved at construction, and pick up new ones
+// after the plan cache has been cleared
+void testPlansResolvedOnce() {
+    std::vector<float> kernel = {0.25f, 0.5f, 0.25f};
+    std::vector<float> signal = makeSignal(640);
+    std::vector<float> expected = convolve(signal, kernel, 1, Padding::FULL);
+    StreamingConvolver1D convolver(kernel, 30, StreamingMethod::OVERLAP_SAVE, Flags::ESTIMATE);
+
+    resetInstrumentation();
+    std::vector<float> output = convolver.process(signal);
+#ifndef KERNELFLOW_NO_INSTRUMENTATION
+    InstrumentationSnapshot report = instrumentationSnapshot();
+    assert(report.count(Counter::PLAN_CACHE_HITS) == 0 && report.count(Counter::PLAN_CACHE_MISSES) == 0);
+#endif
+
+    FFTPlanCache::instance().clear();
+    convolver.flush(output);
+    assert(output.size() == expected.size());
+    for (size_t i = 0; i < output.size(); ++i) {
+        assert(std::abs(output[i] - expected[i]) < 1e-3);
+    }
+}
+
+int main() {
+    testMatchesFullConvolution();
+    testFlushResets();
+    testPlansResolvedOnce();
+    std::cout << "All streaming tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include "src/conv_engine.h"
+#include "src/convolution.h"
+#include "src/fft_convolution.h"
+
+static const Padding PADDINGS[] = {Padding::VALID, Padding::ZERO, Padding::CONSTANT, Padding::REPLICATE,
+                                   Padding::REFLECT, Padding::FULL};
+
+// Strided outputs equal the full-resolution convolution subsampled
+void testMatchesSubsampledFull() {
+    const int rows = 19, cols = 23;
+    Tensor<float> image(rows, cols, 2, 1);
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < cols; ++j)
+                image(0, c, i, j) = static_cast<float>((i * 7 + j * 3 + c * 5) % 11) * 0.25f - 1;
+
+    for (int kernel_size : {1, 2, 5}) {
+        Tensor<float> kernel(kernel_size, kernel_size + 1);
+        for (int i = 0; i < kernel_size; ++i)
+            for (int j = 0; j <= kernel_size; ++j)
+                kernel(i, j) = static_cast<float>((i * 5 + j * 2) % 7) - 3;
+
+        for (Padding padding : PADDINGS) {
+            int full_rows = convolutionOutputSize(rows, kernel_size, padding);
+            int full_cols = convolutionOutputSize(cols, kernel_size + 1, padding);
+            Tensor<float> full(full_rows, full_cols, 2, 1);
+            dispatchConvolve2D(image, kernel, full, padding, 0.5f, ConvAlgorithm::DIRECT);
+
+            for (int stride : {1, 2, 3}) {
+                int out_rows = convolutionOutputSize(rows, kernel_size, padding, stride);
+                int out_cols = convolutionOutputSize(cols, kernel_size + 1, padding, stride);
+                assert(out_rows == (full_rows + stride - 1) / stride);
+                for (ConvAlgorithm algorithm : {ConvAlgorithm::DIRECT, ConvAlgorithm::FFT}) {
+                    Tensor<float> output(out_rows, out_cols, 2, 1);
+                    dispatchConvolve2D(image, kernel, output, padding, 0.5f, algorithm, stride);
+                    for (int c = 0; c < 2; ++c)
+                        for (int i = 0; i < out_rows; ++i)
+                            for (int j = 0; j < out_cols; ++j)
+                                assert(std::abs(output(0, c, i, j) - full(0, c, i * stride, j * stride)) < 1e-3);
+                }
+            }
+        }
+    }
+}
+
+void testVectorOverloads() {
+    std::vector<float> signal(40);
+    for (int i = 0; i < 40; ++i) signal[i] = static_cast<float>((i * 3) % 7) - 2;
+    std::vector<float> kernel = {1, -2, 0.5f, 3};
+
+    for (Padding padding : PADDINGS) {
+        setConvAlgorithm(ConvAlgorithm::DIRECT);
+        std::vector<float> full = convolve(signal, kernel, 1, padding, 0.25f);
+        for (ConvAlgorithm algorithm : {ConvAlgorithm::DIRECT, ConvAlgorithm::FFT}) {
+            setConvAlgorithm(algorithm);
+            std::vector<float> strided = convolve(signal, kernel, 3, padding, 0.25f);
+            assert(strided.size() == (full.size() + 2) / 3);
+            for (size_t i = 0; i < strided.size(); ++i) {
+                assert(std::abs(strided[i] - full[i * 3]) < 1e-3);
+            }
+        }
+    }
+
+    std::vector<std::vector<float>> image(9, std::vector<float>(8));
+    for (int i = 0; i < 9; ++i)
+        for (int j = 0; j < 8; ++j) image[i][j] = static_cast<float>(i - j);
+    std::vector<std::vector<float>> taps = {{1, 2}, {3, 4}};
+    setConvAlgorithm(ConvAlgorithm::FFT);
+    std::vector<std::vector<float>> full = convolve(image, taps, 1, Padding::FULL);
+    std::vector<std::vector<float>> strided = convolve(image, taps, 2, Padding::FULL);
+    setConvAlgorithm(ConvAlgorithm::AUTO);
+    assert(strided.size() == 5 && strided[0].size() == 5);
+    for (size_t i = 0; i < strided.size(); ++i)
+        for (size_t j = 0; j < strided[i].size(); ++j)
+            assert(std::abs(strided[i][j] - full[i * 2][j * 2]) < 1e-3);
+}
+
+void testCosts() {
+    setCostModel(CostModel());
+    ConvProblem problem{512, 512, 15, 15, 1, Padding::ZERO, 1};
+    double direct = estimateCost(problem, ConvAlgorithm::DIRECT);
+    double fft = estimateCost(problem, ConvAlgorithm::FFT);
+    problem.stride = 2;
+
+    // Both backends get cheaper; Winograd and tiles do not take strides
+    assert(estimateCost(problem, ConvAlgorithm::DIRECT) < direct / 3);
+    assert(estimateCost(problem, ConvAlgorithm::FFT) < fft);
+    assert(estimateCost(problem, ConvAlgorithm::TILED_FFT) < 0);
+    problem.kernel_rows = problem.kernel_cols = 3;
+    assert(estimateCost(problem, ConvAlgorithm::WINOGRAD) < 0);
+}
+
+int main() {
+    testMatchesSubsampledFull();
+    testVectorOverloads();
+    testCosts();
+    std::cout << "All strided convolution tests passed!" << std::endl;
+    return 0;
+}
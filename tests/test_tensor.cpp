@@ -0,0 +1,102 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include "src/convolution.h"
+
+// Direct "same"/"valid" convolution of one image, used as the reference
+static float referencePixel(const TensorView<const float>& image, const TensorView<const float>& kernel,
+                            int i, int j, int top, int left, float fill) {
+    float sum = 0;
+    for (int u = 0; u < kernel.rows(); ++u) {
+        for (int v = 0; v < kernel.cols(); ++v) {
+            int r = i + kernel.rows() - 1 - u - top;
+            int c = j + kernel.cols() - 1 - v - left;
+            bool inside = r >= 0 && r < image.rows() && c >= 0 && c < image.cols();
+            sum += (inside ? image(r, c) : fill) * kernel(u, v);
+        }
+    }
+    return sum;
+}
+
+void testTensorFFT() {
+    FFTWrapper fftWrapper;
+
+    // Test 1: In-place 2D round trip over a batch of images
+    {
+        int rows = 6, cols = 10;
+        Tensor<float> data(rows, cols, 3, 2, 2 * (cols / 2 + 1));
+        for (int b = 0; b < 2; ++b)
+            for (int c = 0; c < 3; ++c)
+                for (int i = 0; i < rows; ++i)
+                    for (int j = 0; j < cols; ++j)
+                        data(b, c, i, j) = static_cast<float>(b * 100 + c * 10 + i - j);
+
+        const TensorView<float>& real = data.view();
+        TensorView<std::complex<float>> spectrum(reinterpret_cast<std::complex<float>*>(data.data()),
+                                                 rows, cols / 2 + 1, 3, 2, real.rowStride() / 2,
+                                                 real.channelStride() / 2, real.batchStride() / 2);
+        assert(fftWrapper.performFFT2D(real, spectrum, Flags::ESTIMATE) == FFTStatus::SUCCESS);
+        assert(std::abs(spectrum(1, 2, 0, 0).real() - rows * cols * 120.0f - rows * cols * (2.5f - 4.5f)) < 1e-2);
+        assert(fftWrapper.performInverseFFT2D(spectrum, real, Flags::ESTIMATE) == FFTStatus::SUCCESS);
+        for (int b = 0; b < 2; ++b)
+            for (int c = 0; c < 3; ++c)
+                for (int i = 0; i < rows; ++i)
+                    for (int j = 0; j < cols; ++j)
+                        assert(std::abs(data(b, c, i, j) - (b * 100 + c * 10 + i - j)) < 1e-3);
+    }
+
+    // Test 2: Mismatched shapes are rejected
+    {
+        Tensor<float> real(4, 8);
+        Tensor<std::complex<float>> spectrum(4, 4);
+        assert(fftWrapper.performFFT2D(real.view(), spectrum.view(), Flags::ESTIMATE) == FFTStatus::FAILURE);
+    }
+}
+
+void testTensorConvolve() {
+    std::vector<float> storage(2 * 9 * 12);
+    for (size_t i = 0; i < storage.size(); ++i) {
+        storage[i] = static_cast<float>((i * 7) % 11) - 5;
+    }
+    // A strided window of caller memory: two channels, 7x9 inside a 9x12 buffer
+    TensorView<float> buffer(storage.data(), 9, 12, 2, 1);
+    TensorView<const float> image = buffer.window(1, 2, 7, 9);
+
+    std::vector<float> kernel_data = {1, -2, 0.5f, 3, 1, -1};
+    TensorView<const float> kernel(kernel_data.data(), 2, 3);
+
+    for (Padding padding : {Padding::VALID, Padding::ZERO, Padding::CONSTANT, Padding::REPLICATE, Padding::REFLECT}) {
+        bool padded = padding != Padding::VALID;
+        int out_rows = padded ? image.rows() : image.rows() - kernel.rows() + 1;
+        int out_cols = padded ? image.cols() : image.cols() - kernel.cols() + 1;
+        Tensor<float> output(out_rows, out_cols, 2, 1);
+        convolve(image, kernel, output, 1, padding, 1.5f);
+
+        int top = padded ? (kernel.rows() - 1) / 2 : 0;
+        int left = padded ? (kernel.cols() - 1) / 2 : 0;
+        for (int c = 0; c < 2; ++c) {
+            TensorView<const float> channel = image.image(0, c);
+            for (int i = 0; i < out_rows; ++i) {
+                for (int j = 0; j < out_cols; ++j) {
+                    // Only check border pixels for the modes the reference models
+                    bool interior = i >= top && j >= left && i + kernel.rows() - 1 - top < image.rows() &&
+                                    j + kernel.cols() - 1 - left < image.cols();
+                    if (!interior && (padding == Padding::REPLICATE || padding == Padding::REFLECT)) {
+                        continue;
+                    }
+                    float fill = padding == Padding::CONSTANT ? 1.5f : 0.0f;
+                    float expected = referencePixel(channel, kernel, i, j, top, left, fill);
+                    assert(std::abs(output(0, c, i, j) - expected) < 1e-3);
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    testTensorFFT();
+    testTensorConvolve();
+    std::cout << "All tensor tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include "src/conv_engine.h"
+#include "src/fft_convolution.h"
+#include "src/tiled_convolution.h"
+
+// Tiles with halos reproduce the whole-image FFT for every padding mode,
+// including tiles smaller than the kernel and ragged edge tiles
+void testMatchesWholeImage() {
+    const int rows = 37, cols = 29;
+    Tensor<float> image(rows, cols, 2, 2);
+    for (int b = 0; b < 2; ++b)
+        for (int c = 0; c < 2; ++c)
+            for (int i = 0; i < rows; ++i)
+                for (int j = 0; j < cols; ++j)
+                    image(b, c, i, j) = static_cast<float>((i * 5 + j * 3 + b * 7 + c) % 13) * 0.25f - 1;
+
+    for (int kernel_size : {1, 3, 6}) {
+        Tensor<float> kernel(kernel_size, kernel_size + 2);
+        for (int i = 0; i < kernel_size; ++i)
+            for (int j = 0; j < kernel_size + 2; ++j)
+                kernel(i, j) = static_cast<float>((i * 3 + j) % 5) - 2;
+
+        for (Padding padding : {Padding::VALID, Padding::ZERO, Padding::CONSTANT, Padding::REPLICATE,
+                                Padding::REFLECT, Padding::FULL}) {
+            int out_rows = convolutionOutputSize(rows, kernel_size, padding);
+            int out_cols = convolutionOutputSize(cols, kernel_size + 2, padding);
+            Tensor<float> expected(out_rows, out_cols, 2, 2);
+            fftConvolve2D(image, kernel, expected, padding, 0.5f, Flags::ESTIMATE);
+
+            for (int tile_size : {4, 11, 0}) {
+                for (int threads : {1, 3}) {
+                    Tensor<float> output(out_rows, out_cols, 2, 2);
+                    tiledConvolve2D(image, kernel, output, padding, 0.5f, Flags::ESTIMATE, tile_size, threads);
+                    for (int b = 0; b < 2; ++b)
+                        for (int c = 0; c < 2; ++c)
+                            for (int i = 0; i < out_rows; ++i)
+                                for (int j = 0; j < out_cols; ++j)
+                                    assert(std::abs(output(b, c, i, j) - expected(b, c, i, j)) < 1e-3);
+                }
+            }
+        }
+    }
+}
+
+void testMemory() {
+    // Tile buffers do not grow with the image, only with the thread count
+    std::size_t one = tiledConvolutionMemory(15, 15, 0, 1);
+    assert(tiledConvolutionMemory(15, 15, 0, 4) > one);
+    assert(one < static_cast<std::size_t>(8) << 20);
+    assert(tileFFTSize(defaultTileSize(15), 15) == 512);
+}
+
+void testSelection() {
+    setCostModel(CostModel());
+    ConvProblem problem{4096, 4096, 31, 31, 1, Padding::ZERO, 1};
+    assert(selectAlgorithm(problem) == ConvAlgorithm::FFT);
+
+    // Past the memory limit the whole-image FFT is unavailable and tiles take over
+    setFFTMemoryLimit(16 << 20);
+    assert(estimateCost(problem, ConvAlgorithm::FFT) < 0);
+    assert(selectAlgorithm(problem) == ConvAlgorithm::TILED_FFT);
+
+    Tensor<float> image(300, 200);
+    Tensor<float> kernel(31, 31);
+    Tensor<float> output(300, 200);
+    image(150, 100) = 1;
+    kernel(15, 15) = 2;
+    dispatchConvolve2D(image, kernel, output, Padding::ZERO, 0, ConvAlgorithm::TILED_FFT);
+    assert(std::abs(output(150, 100) - 2) < 1e-4);
+    assert(std::abs(output(0, 0)) < 1e-4);
+    setFFTMemoryLimit(static_cast<std::size_t>(512) << 20);
+}
+
+int main() {
+    testMatchesWholeImage();
+    testMemory();
+    testSelection();
+    std::cout << "All tiled convolution tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include "src/conv_engine.h"
+#include "src/winograd.h"
+
+static float pattern(int a, int b, int c) {
+    return static_cast<float>((a * 7 + b * 3 + c * 5) % 11) * 0.25f - 1.25f;
+}
+
+// Both variants match the FFT path for every padding mode
+void testMatchesFFT() {
+    for (int size : {5, 13, 18}) {
+        Tensor<float> image(size, size + 3, 2, 1);
+        for (int c = 0; c < 2; ++c)
+            for (int i = 0; i < size; ++i)
+                for (int j = 0; j < size + 3; ++j)
+                    image(0, c, i, j) = pattern(i, j, c);
+
+        Tensor<float> kernel(3, 3);
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                kernel(i, j) = pattern(i, j, 1) + 0.5f;
+
+        for (Padding padding : {Padding::VALID, Padding::ZERO, Padding::CONSTANT, Padding::REPLICATE,
+                                Padding::REFLECT, Padding::FULL}) {
+            int rows = convolutionOutputSize(size, 3, padding);
+            int cols = convolutionOutputSize(size + 3, 3, padding);
+            Tensor<float> reference(rows, cols, 2, 1);
+            dispatchConvolve2D(image, kernel, reference, padding, 0.75f, ConvAlgorithm::FFT);
+
+            for (WinogradVariant variant : {WinogradVariant::F2x2_3x3, WinogradVariant::F4x4_3x3}) {
+                Tensor<float> output(rows, cols, 2, 1);
+                winogradConvolve2D(image, kernel, output, padding, 0.75f, variant);
+                for (int c = 0; c < 2; ++c)
+                    for (int i = 0; i < rows; ++i)
+                        for (int j = 0; j < cols; ++j)
+                            assert(std::abs(output(0, c, i, j) - reference(0, c, i, j)) < 1e-3);
+            }
+        }
+    }
+}
+
+// A layer sums every input channel's convolution with its filter
+void testLayer() {
+    const int batch = 2, in = 3, out = 4, rows = 10, cols = 9;
+    Tensor<float> input(rows, cols, in, batch);
+    for (int b = 0; b < batch; ++b)
+        for (int c = 0; c < in; ++c)
+            for (int i = 0; i < rows; ++i)
+                for (int j = 0; j < cols; ++j)
+                    input(b, c, i, j) = pattern(i + b, j, c);
+
+    Tensor<float> filters(3, 3, in, out);
+    for (int k = 0; k < out; ++k)
+        for (int c = 0; c < in; ++c)
+            for (int i = 0; i < 3; ++i)
+                for (int j = 0; j < 3; ++j)
+                    filters(k, c, i, j) = pattern(i + k, j + c, k);
+
+    clearWinogradFilterCache();
+    for (WinogradVariant variant : {WinogradVariant::F2x2_3x3, WinogradVariant::F4x4_3x3}) {
+        Tensor<float> output(rows, cols, out, batch);
+        winogradConvolveLayer(input, filters, output, Padding::ZERO, 0, variant);
+
+        Tensor<float> single(rows, cols);
+        for (int b = 0; b < batch; ++b)
+            for (int k = 0; k < out; ++k) {
+                std::vector<float> expected(rows * cols, 0);
+                for (int c = 0; c < in; ++c) {
+                    dispatchConvolve2D(input.view().image(b, c), filters.view().image(k, c), single,
+                                       Padding::ZERO, 0, ConvAlgorithm::DIRECT);
+                    for (int i = 0; i < rows; ++i)
+                        for (int j = 0; j < cols; ++j)
+                            expected[i * cols + j] += single(i, j);
+                }
+                for (int i = 0; i < rows; ++i)
+                    for (int j = 0; j < cols; ++j)
+                        assert(std::abs(output(b, k, i, j) - expected[i * cols + j]) < 1e-3);
+            }
+    }
+
+    // Filters are transformed once per variant and reused afterwards
+    assert(winogradFilterCacheSize() == 2);
+    Tensor<float> output(rows, cols, out, batch);
+    winogradConvolveLayer(input, filters, output, Padding::ZERO, 0, WinogradVariant::F4x4_3x3);
+    assert(winogradFilterCacheSize() == 2);
+    clearWinogradFilterCache();
+    assert(winogradFilterCacheSize() == 0);
+}
+
+void testSelection() {
+    setCostModel(CostModel());
+
+    // Winograd only handles 3x3 kernels and wins once channels dominate
+    assert(estimateCost(ConvProblem{64, 64, 5, 5, 1, Padding::ZERO, 1}, ConvAlgorithm::WINOGRAD) < 0);
+    ConvProblem layer{56, 56, 3, 3, 1, Padding::ZERO, 1, 64, 64};
+    assert(selectAlgorithm(layer) == ConvAlgorithm::WINOGRAD);
+}
+
+int main() {
+    testMatchesFFT();
+    testLayer();
+    testSelection();
+    std::cout << "All Winograd tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include "src/FFTWisdom.h"
+#include "src/convolution.h"
+
+void testWisdomRoundTrip() {
+    const std::string path = "test_wisdom.dat";
+    FFTWisdom::forget();
+    FFTPlanCache::instance().clear();
+
+    // Test 1: Pre-planned shapes can be saved and reloaded
+    {
+        std::vector<FFTShape> shapes = convolutionFFTShapes(64, 5, Padding::ZERO);
+        shapes.push_back(FFTShape{2, {16, 12}, false});
+        assert(FFTWisdom::prePlan(shapes, Flags::MEASURE) == FFTStatus::SUCCESS);
+        assert(FFTPlanCache::instance().size() >= 2 * shapes.size());
+        assert(FFTWisdom::save(path) == FFTStatus::SUCCESS);
+    }
+
+    // Test 2: After a restart, WISDOM_ONLY planning succeeds for the saved shapes only
+    {
+        FFTWisdom::forget();
+        FFTPlanCache::instance().clear();
+        assert(FFTWisdom::load(path) == FFTStatus::SUCCESS);
+
+        FFTWrapper fftWrapper;
+        std::vector<float> signal(16 * 12, 1);
+        std::vector<std::complex<float>> spectrum;
+        std::vector<std::vector<float>> image(16, std::vector<float>(12, 1));
+        std::vector<std::vector<std::complex<float>>> spectrum2D;
+        assert(fftWrapper.performFFT2D(image, spectrum2D, Flags::MEASURE | Flags::WISDOM_ONLY) == FFTStatus::SUCCESS);
+        assert(fftWrapper.performFFT1D(signal, spectrum, Flags::MEASURE | Flags::WISDOM_ONLY) == FFTStatus::FAILURE);
+    }
+
+    // Test 3: Files with a foreign header are rejected
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "kernel-flow-wisdom 999 fftw-0.0\n";
+        file.close();
+        assert(FFTWisdom::load(path) == FFTStatus::FAILURE);
+        assert(FFTWisdom::load("does_not_exist.dat") == FFTStatus::FAILURE);
+    }
+
+    std::remove(path.c_str());
+}
+
+void testWisdomWhilePlanning() {
+    // Saving, loading and forgetting wisdom share the planner lock, so they
+    // may run while another thread creates plans
+    const std::string path = "test_wisdom_concurrent.dat";
+    FFTPlanCache::instance().clear();
+    std::thread planner([]() {
+        FFTWrapper fftWrapper;
+        for (int size = 8; size < 72; ++size) {
+            std::vector<float> signal(size, 1);
+            std::vector<std::complex<float>> spectrum;
+            assert(fftWrapper.performFFT1D(signal, spectrum, Flags::ESTIMATE) == FFTStatus::SUCCESS);
+        }
+    });
+    for (int i = 0; i < 32; ++i) {
+        assert(FFTWisdom::save(path) == FFTStatus::SUCCESS);
+        assert(FFTWisdom::load(path) == FFTStatus::SUCCESS);
+        FFTWisdom::forget();
+    }
+    planner.join();
+    std::remove(path.c_str());
+}
+
+int main() {
+    testWisdomRoundTrip();
+    testWisdomWhilePlanning();
+    std::cout << "All wisdom tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <cassert>
+#include <cmath>
+#include "src/conv_engine.h"
+#include "src/conv_layer.h"
+#include "src/convolution.h"
+#include "src/parallel.h"
+#include "src/separable_convolution.h"
+#include "src/workspace.h"
+
+static Tensor<float> pattern(int rows, int cols, int channels, int batch, int seed) {
+    Tensor<float> t(rows, cols, channels, batch);
+    for (int b = 0; b < batch; ++b)
+        for (int c = 0; c < channels; ++c)
+            for (int i = 0; i < rows; ++i)
+                for (int j = 0; j < cols; ++j)
+                    t(b, c, i, j) = static_cast<float>((i * 31 + j * 17 + c * 7 + b * 3 + seed) % 23) * 0.1f - 1;
+    return t;
+}
+
+// Every heap allocation in the process, std::vector and friends included,
+// which Counter::ALLOCATIONS (Tensor and plan scratch only) does not see
+static std::atomic<std::uint64_t> heap_allocations{0};
+
+void* operator new(std::size_t bytes) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(bytes ? bytes : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static bool aligned(const void* p) {
+    return reinterpret_cast<std::uintptr_t>(p) % Workspace::ALIGNMENT == 0;
+}
+
+static std::uint64_t allocations() {
+    return instrumentationSnapshot().count(Counter::ALLOCATIONS);
+}
+
+void testArena() {
+    Workspace ws;
+    assert(ws.capacity() == 0 && ws.used() == 0);
+    {
+        WorkspaceFrame outer(ws);
+        float* a = outer.array<float>(10);
+        assert(aligned(a) && ws.used() == Workspace::footprint(40));
+        {
+            // Nothing reserved yet, so every request gets a block of its own
+            WorkspaceFrame inner(ws);
+            TensorView<float> t = inner.tensor(3, 5, 2, 1, 8);
+            assert(aligned(t.data()) && t.rowStride() == 8 && t(0, 1, 2, 4) == 0.0f);
+            assert(ws.used() == Workspace::footprint(40) + workspaceTensorBytes(3, 5, 2, 1, 8));
+        }
+        assert(ws.used() == Workspace::footprint(40));
+    }
+    // Once idle, the main block grows to the most ever in use
+    assert(ws.used() == 0);
+    assert(ws.peak() == Workspace::footprint(40) + workspaceTensorBytes(3, 5, 2, 1, 8));
+    assert(ws.capacity() >= ws.peak());
+
+    std::size_t capacity = ws.capacity();
+    {
+        WorkspaceFrame frame(ws);
+        float* a = frame.array<float>(10);
+        float* b = frame.array<float>(48);
+        assert(aligned(a) && aligned(b) && b != a);
+    }
+    assert(ws.capacity() == capacity);
+
+    ws.shrink();
+    assert(ws.capacity() == 0 && ws.peak() == 0);
+    ws.reserve(1000);
+    assert(ws.capacity() == Workspace::footprint(1000));
+}
+
+void testBinding() {
+    Workspace& thread_default = currentWorkspace();
+    Workspace a, b;
+    {
+        WorkspaceBinding bind_a(a);
+        assert(&currentWorkspace() == &a);
+        {
+            WorkspaceBinding bind_b(b);
+            assert(&currentWorkspace() == &b);
+        }
+        assert(&currentWorkspace() == &a);
+    }
+    assert(&currentWorkspace() == &thread_default);
+}
+
+void testSizeQueries() {
+    // Single-threaded, so tiled convolution runs its only worker on this thread
+    setNumThreads(1);
+    Tensor<float> image = pattern(40, 36, 2, 1, 1);
+    Tensor<float> kernel3 = pattern(3, 3, 1, 1, 2);
+    Tensor<float> kernel5(5, 5);
+    for (int i = 0; i < 5; ++i)
+        for (int j = 0; j < 5; ++j) kernel5(i, j) = static_cast<float>((i + 1) * (5 - j));  // rank 1
+
+    struct Case {
+        ConvAlgorithm algorithm;
+        const Tensor<float>& kernel;
+        Padding padding;
+        int stride;
+    };
+    const Case cases[] = {
+        {ConvAlgorithm::DIRECT, kernel5, Padding::ZERO, 1},
+        {ConvAlgorithm::DIRECT, kernel5, Padding::VALID, 2},
+        {ConvAlgorithm::WINOGRAD, kernel3, Padding::REFLECT, 1},
+        {ConvAlgorithm::SEPARABLE, kernel5, Padding::REPLICATE, 1},
+        {ConvAlgorithm::FFT, kernel5, Padding::ZERO, 1},
+        {ConvAlgorithm::FFT, kernel5, Padding::CONSTANT, 1},
+        {ConvAlgorithm::FFT, kernel5, Padding::ZERO, 2},
+        {ConvAlgorithm::TILED_FFT, kernel5, Padding::FULL, 1},
+    };
+    for (const Case& c : cases) {
+        int out_rows = convolutionOutputSize(image.rows(), c.kernel.rows(), c.padding, c.stride);
+        int out_cols = convolutionOutputSize(image.cols(), c.kernel.cols(), c.padding, c.stride);
+        Tensor<float> output(out_rows, out_cols, 2, 1);
+        ConvProblem problem{image.rows(), image.cols(), c.kernel.rows(), c.kernel.cols(), 2, c.padding,
+                            getNumThreads(), 1, 1, c.stride};
+        if (c.algorithm == ConvAlgorithm::SEPARABLE) {
+            problem.kernel_rank = decomposeKernel(c.kernel, getSeparabilityTolerance()).rank();
+        }
+
+        Workspace ws;
+        WorkspaceBinding bind(ws);
+        dispatchConvolve2D(image, c.kernel, output, c.padding, 0.5f, c.algorithm, c.stride);
+        assert(ws.peak() == convolutionWorkspaceSize(problem, c.algorithm));
+        assert(ws.used() == 0);
+    }
+
+    Tensor<float> filters = pattern(3, 3, 2, 3, 4);
+    for (ConvAlgorithm algorithm : {ConvAlgorithm::DIRECT, ConvAlgorithm::WINOGRAD, ConvAlgorithm::FFT}) {
+        ConvLayer layer(filters, Padding::ZERO, 0.0f, algorithm);
+        Tensor<float> input = pattern(20, 18, 2, 2, 5);
+        Tensor<float> output(20, 18, 3, 2);
+        Workspace ws;
+        WorkspaceBinding bind(ws);
+        layer.forward(input, output);
+        assert(ws.peak() == layer.workspaceSize(20, 18, 2));
+    }
+    setNumThreads(0);
+}
+
+void testSteadyStateDoesNotAllocate() {
+    // Plans, kernel spectra and the workspace are set up by the first call;
+    // repeats only reuse them
+    Tensor<float> image = pattern(48, 44, 1, 2, 6);
+    Tensor<float> kernel = pattern(7, 7, 1, 1, 7);
+    Tensor<float> kernel3 = pattern(3, 3, 1, 1, 8);
+    Tensor<float> output(48, 44, 1, 2);
+    Tensor<float> expected(48, 44, 1, 2);
+    dispatchConvolve2D(image, kernel, expected, Padding::REFLECT, 0.0f, ConvAlgorithm::DIRECT);
+
+    for (ConvAlgorithm algorithm : {ConvAlgorithm::DIRECT, ConvAlgorithm::FFT, ConvAlgorithm::TILED_FFT}) {
+        for (int repeat = 0; repeat < 3; ++repeat) {
+            std::uint64_t before = allocations();
+            dispatchConvolve2D(image, kernel, output, Padding::REFLECT, 0.0f, algorithm);
+#ifndef KERNELFLOW_NO_INSTRUMENTATION
+            assert(repeat == 0 || allocations() == before);
+#endif
+            (void)before;
+            for (int b = 0; b < 2; ++b)
+                for (int i = 0; i < 48; ++i)
+                    for (int j = 0; j < 44; ++j) assert(std::abs(output(b, 0, i, j) - expected(b, 0, i, j)) < 1e-3);
+        }
+    }
+    for (ConvAlgorithm algorithm : {ConvAlgorithm::WINOGRAD, ConvAlgorithm::SEPARABLE}) {
+        for (int repeat = 0; repeat < 3; ++repeat) {
+            std::uint64_t before = allocations();
+            dispatchConvolve2D(image, kernel3, output, Padding::ZERO, 0.0f, algorithm);
+#ifndef KERNELFLOW_NO_INSTRUMENTATION
+            assert(repeat == 0 || allocations() == before);
+#endif
+            (void)before;
+        }
+    }
+
+    // No heap allocation at all on repeats, through AUTO (which looks up the
+    // cached decomposition of 2D kernels) as well as the spatial backends.
+    // The FFT path is left to Counter::ALLOCATIONS above: what happens inside
+    // FFTW's execute calls is up to the FFTW build.
+    setNumThreads(1);
+    Tensor<float> square = pattern(64, 64, 1, 1, 9);
+    Tensor<float> square_output(64, 64);
+    Tensor<float> binomial(9, 9);  // rank 1: AUTO runs it as SEPARABLE
+    const float taps[] = {1, 8, 28, 56, 70, 56, 28, 8, 1};
+    for (int i = 0; i < 9; ++i)
+        for (int j = 0; j < 9; ++j) binomial(i, j) = taps[i] * taps[j] / 65536;
+    for (const Tensor<float>* k : {&kernel3, &kernel, &binomial}) {
+        for (ConvAlgorithm algorithm : {ConvAlgorithm::AUTO, ConvAlgorithm::DIRECT, ConvAlgorithm::WINOGRAD,
+                                        ConvAlgorithm::SEPARABLE}) {
+            if (algorithm == ConvAlgorithm::WINOGRAD && k->rows() != 3) continue;
+            dispatchConvolve2D(square, *k, square_output, Padding::ZERO, 0.0f, algorithm);
+            std::uint64_t before = heap_allocations.load();
+            for (int repeat = 0; repeat < 3; ++repeat) {
+                dispatchConvolve2D(square, *k, square_output, Padding::ZERO, 0.0f, algorithm);
+            }
+            assert(heap_allocations.load() == before);
+        }
+    }
+    setNumThreads(0);
+}
+
+int main() {
+    testArena();
+    testBinding();
+    testSizeQueries();
+    testSteadyStateDoesNotAllocate();
+    std::cout << "All workspace tests passed!" << std::endl;
+    return 0;
+}